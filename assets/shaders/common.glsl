@@ -17,6 +17,8 @@ const uint CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
 
 layout(constant_id = 200) const uint MAX_TEXTURES = 1024;
 
+const uint MAX_TERRAIN_CLIPMAP_LEVELS = 16;
+
 
 // ====================================
 
@@ -57,6 +59,19 @@ struct LightCluster {
 };
 
 
+struct TerrainPatch {
+	vec2 position;
+	float size;
+	uint lod;
+
+	// Right, bottom, left, top
+	vec4 tessFactors;
+
+	vec2 heightBounds;
+	float curvature;
+};
+
+
 // ====================================
 
 // #define FRAME_SET_ID		  (SET_ID_OFFSET + 0)
@@ -78,8 +93,8 @@ struct LightCluster {
 
 layout(push_constant) uniform ModelBlock {
 	mat4 transformMatrix;
-	vec4 terrainTessFactors;
-	uint lod;
+	uint materialIndex;
+	vec4 positionDequantization;
 }
 uModel;
 
@@ -139,8 +154,8 @@ layout(set = ENVIRONMENT_SET_ID, binding = 5) readonly buffer SpotLightsBlock {
 
 layout(push_constant) uniform ModelBlock {
 	mat4 transformMatrix;
-	vec4 terrainTessFactors;
-	uint lod;
+	uint materialIndex;
+	vec4 positionDequantization;
 }
 uModel;
 
@@ -171,21 +186,94 @@ layout(set = TEXTURES_SET_ID, binding = 1) uniform texture2D uTextures[MAX_TEXTU
 
 #ifdef TERRAIN_SET_ID
 layout(set = TERRAIN_SET_ID, binding = 0) uniform TerrainBlock {
+	// Window origin in level texels, level texel size and residency
+	vec4 clipmapLevels[MAX_TERRAIN_CLIPMAP_LEVELS];
+
 	uint size;
 	uint maxHeight;
 
-	uint textureHeight;
-	uint textureNormal;
+	uint clipmapSize;
+	uint clipmapLevelCount;
 
-	float texelSize;
 	float baseTessLevel;
+
+	float pixelScale;
+	float maxPixelError;
+	bool isPerspective;
 }
 uTerrain;
+
+// Indexed by instance, one instance per drawn patch
+layout(set = TERRAIN_SET_ID, binding = 1) readonly buffer TerrainPatchesBlock {
+	TerrainPatch uTerrainPatches[];
+};
+
+// Layer per clipmap level, addressed toroidally with repeating sampler
+layout(set = TERRAIN_SET_ID, binding = 2) uniform sampler2DArray uTerrainHeightClipmap;
+layout(set = TERRAIN_SET_ID, binding = 3) uniform sampler2DArray uTerrainNormalClipmap;
+
+
+// Texels kept away from window edge for bicubic filter and width of band blended with next level, in level texels
+const float TERRAIN_CLIPMAP_BORDER = 4.0;
+const float TERRAIN_CLIPMAP_BLEND  = 32.0;
+
+vec2 getTerrainClipmapTexelPosition(vec2 worldPosition, uint level) {
+	return (worldPosition + 0.5 * uTerrain.size) / uTerrain.clipmapLevels[level].z;
+}
+
+// Distance in texels from position to usable part of level window, negative if outside of it or level is not resident
+float getTerrainClipmapEdgeDistance(vec2 worldPosition, uint level) {
+	vec4 clipmapLevel = uTerrain.clipmapLevels[level];
+
+	if (clipmapLevel.w == 0.0) {
+		return -1.0;
+	}
+
+	vec2 localPosition = getTerrainClipmapTexelPosition(worldPosition, level) - clipmapLevel.xy;
+	vec2 edgeDistance  = min(localPosition, uTerrain.clipmapSize - localPosition);
+
+	return min(edgeDistance.x, edgeDistance.y) - TERRAIN_CLIPMAP_BORDER;
+}
+
+// Finest level covering position and blend factor toward next coarser level near its window edge. Coarsest level
+// always covers whole terrain.
+uint selectTerrainClipmapLevel(vec2 worldPosition, out float blend) {
+	uint lastLevel = uTerrain.clipmapLevelCount - 1;
+
+	for (uint level = 0; level < lastLevel; level++) {
+		float edgeDistance = getTerrainClipmapEdgeDistance(worldPosition, level);
+
+		if (edgeDistance >= 0.0) {
+			blend = 1.0 - clamp(edgeDistance / TERRAIN_CLIPMAP_BLEND, 0.0, 1.0);
+
+			// Windows of coarser levels are not guaranteed to be resident around finer ones while streaming
+			if (level + 1 < lastLevel && getTerrainClipmapEdgeDistance(worldPosition, level + 1) < 0.0) {
+				blend = 0.0;
+			}
+
+			return level;
+		}
+	}
+
+	blend = 0.0;
+	return lastLevel;
+}
 #endif // TERRAIN_SET_ID
 
 
 // ====================================
 
+// Inverse of octahedral encoding done by Importer, input is in [-1, 1] range
+vec3 decodeOctahedral(vec2 encoded) {
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+	float t = max(-direction.z, 0.0);
+	direction.xy += mix(vec2(t), vec2(-t), greaterThanEqual(direction.xy, vec2(0.0)));
+
+	return normalize(direction);
+}
+
+
 uint getClusterIndex(uint x, uint y, uint z) {
 	return x * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z + y * CLUSTER_COUNT_Z + z;
 }
@@ -1,6 +1,11 @@
 #include "Core.hpp"
 
+#include "engine/graphics/CookedMeshFile.hpp"
+#include "engine/graphics/TerrainTileFile.hpp"
+
 #include "engine/managers/EntityManager.hpp"
+#include "engine/managers/TerrainStreamingManager.hpp"
+#include "engine/managers/TextureStreamingManager.hpp"
 
 #include "engine/systems/ImGuiSystem.hpp"
 #include "engine/systems/InputSystem.hpp"
@@ -10,6 +15,7 @@
 #include "engine/utils/CPUTimer.hpp"
 #include "engine/utils/Generator.hpp"
 #include "engine/utils/Importer.hpp"
+#include "engine/utils/ThreadPool.hpp"
 
 // #include "thirdparty/imgui/imgui_impl_glfw.h"
 
@@ -18,21 +24,49 @@
 #include <spdlog/sinks/stdout_sinks.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
+#include <thread>
 
 
 namespace Engine {
+// Asset decoded on a worker thread during startup, resources are created from results on main thread
+struct AssetLoadJob {
+	std::function<int()> load;
+	int result;
+};
+
+// Models with cooked filename are cooked after their LODs are generated and loaded from cooked file afterwards
+struct MeshLoadInfo {
+	const char* name;
+	const char* filename;
+	const char* cookedFilename;
+};
+
+// Textures are streamed from cooked file, which is written by the streaming itself when it is missing or stale
+struct TextureLoadInfo {
+	const char* name;
+	const char* filename;
+	const char* cookedFilename;
+	vk::Format format;
+};
+
+
 Core::~Core() {
 	glfwDestroyWindow(glfwWindow);
 	glfwTerminate();
 }
 
 int Core::init(int argc, char** argv) {
+	initStartTime = std::chrono::steady_clock::now();
+
 	// loggers initialization
 
-	std::array<spdlog::sink_ptr, 3> logSinks { std::make_shared<spdlog::sinks::ansicolor_stdout_sink_st>(),
-											   std::make_shared<spdlog::sinks::basic_file_sink_st>("Engine.log"),
-											   std::make_shared<spdlog::sinks::ostream_sink_st>(logBuffer) };
+	// Sinks are shared with worker threads
+	std::array<spdlog::sink_ptr, 3> logSinks { std::make_shared<spdlog::sinks::ansicolor_stdout_sink_mt>(),
+											   std::make_shared<spdlog::sinks::basic_file_sink_mt>("Engine.log"),
+											   std::make_shared<spdlog::sinks::ostream_sink_mt>(logBuffer) };
 	spdlog::set_default_logger(std::make_shared<spdlog::logger>("logger", logSinks.begin(), logSinks.end()));
 	spdlog::set_pattern("[%Y-%m-%d %T] [%^%l%$] %v");
 
@@ -41,6 +75,84 @@ int Core::init(int argc, char** argv) {
 	debugState.logs.resize(maxLogEntries, std::vector<char>(maxLogLength));
 
 
+	// Assets are decoded on worker threads while window, device and renderers are initialized. Resources are created
+	// from them once everything is ready, so GPU uploads happen together at the end.
+
+	// Cooked files are rebuilt whenever they are missing or older than their sources, so that loading them later is a
+	// plain memory mapping with no decoding or processing
+
+	constexpr std::array meshLoadInfos = {
+		MeshLoadInfo { "dragon", "assets/models/dragon.fbx", "assets/models/dragon.mesh" },
+		MeshLoadInfo { "sphere", "assets/models/sphere.fbx", "assets/models/sphere.mesh" },
+		MeshLoadInfo { "tile", "assets/models/tile.fbx", nullptr },
+	};
+
+	std::array<std::vector<StaticMesh>, meshLoadInfos.size()> meshArrays {};
+	std::array<std::vector<std::string>, meshLoadInfos.size()> meshNameArrays {};
+
+	std::array<bool, meshLoadInfos.size()> meshCookedFlags {};
+	for (uint i = 0; i < meshLoadInfos.size(); i++) {
+		meshCookedFlags[i] = meshLoadInfos[i].cookedFilename != nullptr &&
+							 Importer::isCookedFileUpToDate(meshLoadInfos[i].filename, meshLoadInfos[i].cookedFilename,
+															CookedMeshFile::MAGIC, CookedMeshFile::VERSION);
+	}
+
+	constexpr std::array textureLoadInfos = {
+		TextureLoadInfo { "rock_moss_diffuse", "assets/textures/Rock Moss_diffuse.png",
+						  "assets/textures/Rock Moss_diffuse.texture", vk::Format::eR8G8B8A8Srgb },
+		TextureLoadInfo { "rock_moss_normal", "assets/textures/Rock Moss_normal.png",
+						  "assets/textures/Rock Moss_normal.texture", vk::Format::eR8G8B8A8Unorm },
+		TextureLoadInfo { "rock_moss_mra", "assets/textures/Rock Moss_mra.jpg", "assets/textures/Rock Moss_mra.texture",
+						  vk::Format::eR8G8B8A8Srgb },
+		TextureLoadInfo { "mud_with_vegetation_albedo", "assets/textures/mud_with_vegetation_albedo.png",
+						  "assets/textures/mud_with_vegetation_albedo.texture", vk::Format::eR8G8B8A8Srgb },
+		TextureLoadInfo { "mud_with_vegetation_normal", "assets/textures/mud_with_vegetation_normal.png",
+						  "assets/textures/mud_with_vegetation_normal.texture", vk::Format::eR8G8B8A8Unorm },
+		TextureLoadInfo { "mud_with_vegetation_mra", "assets/textures/mud_with_vegetation_mra.png",
+						  "assets/textures/mud_with_vegetation_mra.texture", vk::Format::eR8G8B8A8Srgb },
+	};
+
+	// Terrain is cooked into a tiled file once and streamed from it afterwards
+	const std::string terrainHeightMapFilename = "assets/textures/terrain_05_height.png";
+	const std::string terrainFilename		   = "assets/textures/terrain_05.terrain";
+
+	std::vector<AssetLoadJob> assetLoadJobs {};
+
+	for (uint i = 0; i < meshLoadInfos.size(); i++) {
+		if (meshCookedFlags[i]) {
+			continue;
+		}
+
+		auto& assetLoadJob = assetLoadJobs.emplace_back();
+		assetLoadJob.load  = [&, i]() {
+			return Importer::loadMesh(meshLoadInfos[i].filename, meshArrays[i], meshNameArrays[i]);
+		};
+	}
+
+	if (!Importer::isCookedFileUpToDate(terrainHeightMapFilename, terrainFilename, TerrainTileFile::MAGIC,
+										TerrainTileFile::VERSION)) {
+		auto& assetLoadJob = assetLoadJobs.emplace_back();
+		assetLoadJob.load  = [&]() {
+			return Importer::cookTerrain(terrainHeightMapFilename, terrainFilename, 1.0f, 512.0f);
+		};
+	}
+
+	// Main thread is busy with initialization meanwhile
+	const uint assetThreadCount = std::max<uint>(std::thread::hardware_concurrency(), 2) - 1;
+
+	ThreadPool assetThreadPool {};
+	assetThreadPool.init(
+		[](uint threadIndex, void* pData) {
+			auto& assetLoadJob	= *static_cast<AssetLoadJob*>(pData);
+			assetLoadJob.result = assetLoadJob.load();
+		},
+		assetThreadCount);
+
+	for (auto& assetLoadJob : assetLoadJobs) {
+		assetThreadPool.appendData(&assetLoadJob);
+	}
+
+
 	// window initialization
 
 	if (!glfwInit()) {
@@ -90,6 +202,82 @@ int Core::init(int argc, char** argv) {
 	}
 
 
+	// Textures are streamed in behind fallback texture, materials refer to them right away
+	std::array<TextureManager::Handle, textureLoadInfos.size()> textureHandles {};
+	for (uint i = 0; i < textureHandles.size(); i++) {
+		const auto& textureLoadInfo = textureLoadInfos[i];
+
+		textureHandles[i] = TextureStreamingManager::request(textureLoadInfo.name, textureLoadInfo.filename,
+															 textureLoadInfo.cookedFilename, textureLoadInfo.format);
+	}
+
+
+	assetThreadPool.waitForAll();
+	assetThreadPool.terminate();
+
+	for (const auto& assetLoadJob : assetLoadJobs) {
+		if (assetLoadJob.result) {
+			return 1;
+		}
+	}
+
+	std::array<std::vector<MeshManager::Handle>, meshLoadInfos.size()> meshHandleArrays {};
+	for (uint i = 0; i < meshHandleArrays.size(); i++) {
+		if (meshCookedFlags[i]) {
+			if (!Importer::loadCookedMeshes(meshLoadInfos[i].cookedFilename, meshHandleArrays[i])) {
+				continue;
+			}
+
+			// Cooked file passed header check but is broken further in, model is processed and cooked again
+			spdlog::warn("Cooking '{}' again", meshLoadInfos[i].cookedFilename);
+			meshCookedFlags[i] = false;
+
+			if (Importer::loadMesh(meshLoadInfos[i].filename, meshArrays[i], meshNameArrays[i])) {
+				return 1;
+			}
+			Importer::createMeshes(meshArrays[i], meshNameArrays[i], meshHandleArrays[i], false);
+		} else {
+			// Models with a cooked file are drawn from their compressed LODs, uncompressed source meshes stay on CPU
+			const bool isCompressed = meshLoadInfos[i].cookedFilename != nullptr;
+			Importer::createMeshes(meshArrays[i], meshNameArrays[i], meshHandleArrays[i], !isCompressed);
+		}
+	}
+
+	// Fills lodHandles with compressed LODs of a model, they are cooked as is so a cooked model is used directly
+	const auto getModelLods = [&](uint modelIndex, std::vector<MeshManager::Handle>& lodHandles) {
+		const auto& meshLoadInfo = meshLoadInfos[modelIndex];
+
+		if (meshCookedFlags[modelIndex]) {
+			lodHandles = meshHandleArrays[modelIndex];
+			return 0;
+		}
+
+		std::vector<MeshManager::Handle> sourceLodHandles {};
+		if (Importer::generateMeshLods(meshHandleArrays[modelIndex][0], meshLoadInfo.name, 4, sourceLodHandles,
+									   false)) {
+			return 1;
+		}
+
+		lodHandles.resize(sourceLodHandles.size());
+
+		std::vector<std::string> lodNames(sourceLodHandles.size());
+		for (uint lod = 0; lod < sourceLodHandles.size(); lod++) {
+			lodNames[lod] = std::string(meshLoadInfo.name) + "_compressed_lod_" + std::to_string(lod);
+			if (Importer::compressMesh(sourceLodHandles[lod], lodNames[lod], lodHandles[lod])) {
+				return 1;
+			}
+		}
+
+		// Model is simply processed again on next run if it could not be cooked
+		if (meshLoadInfo.cookedFilename != nullptr &&
+			Importer::cookMeshes(lodHandles, lodNames, meshLoadInfo.cookedFilename)) {
+			spdlog::warn("Failed to cook '{}'", meshLoadInfo.cookedFilename);
+		}
+
+		return 0;
+	};
+
+
 	ScriptManager::init();
 
 	EntityManager::init();
@@ -109,40 +297,29 @@ int Core::init(int argc, char** argv) {
 
 	auto modelEntity = EntityManager::createEntity<TransformComponent, ModelComponent, ScriptComponent>("dragon");
 
-	std::vector<MeshManager::Handle> meshHandles {};
-	if (Importer::importMesh("assets/models/dragon.fbx", meshHandles)) {
+	std::vector<MeshManager::Handle> lodHandles {};
+	if (getModelLods(0, lodHandles)) {
 		return 1;
 	}
-	modelEntity.getComponent<ModelComponent>().meshHandles[0] = meshHandles[0];
-
-	auto albedoTextureHandle = TextureManager::createObject<Texture2D>("rock_moss_diffuse");
-	if (Importer::importTexture("assets/textures/Rock Moss_diffuse.png", albedoTextureHandle, 4, 8,
-								vk::Format::eR8G8B8A8Srgb)) {
-		return 1;
+	for (uint lod = 0; lod < lodHandles.size(); lod++) {
+		modelEntity.getComponent<ModelComponent>().meshHandles[lod] = lodHandles[lod];
 	}
-	auto normalTextureHandle = TextureManager::createObject<Texture2D>("rock_moss_normal");
-	if (Importer::importTexture("assets/textures/Rock Moss_normal.png", normalTextureHandle, 4, 8,
-								vk::Format::eR8G8B8A8Unorm)) {
-		return 1;
-	}
-	auto mraTextureHandle = TextureManager::createObject<Texture2D>("rock_moss_mra");
-	if (Importer::importTexture("assets/textures/Rock Moss_mra.jpg", mraTextureHandle, 4, 8,
-								vk::Format::eR8G8B8A8Srgb)) {
+
+	MaterialManager::Handle materialHandle {};
+	if (MaterialManager::createObject<SimpleMaterial>("rock_moss", materialHandle)) {
 		return 1;
 	}
-
-	auto materialHandle = MaterialManager::createObject<SimpleMaterial>("rock_moss");
 	materialHandle.apply([&](auto& material) {
 		// material.color			   = glm::vec3(0.5f, 0.3f, 0.8f);
-		material.textureAlbedo = albedoTextureHandle;
-		material.textureNormal = normalTextureHandle;
-		material.textureMRA	   = mraTextureHandle;
+		material.textureAlbedo = textureHandles[0];
+		material.textureNormal = textureHandles[1];
+		material.textureMRA	   = textureHandles[2];
 	});
 	materialHandle.update();
 
 	modelEntity.getComponent<ModelComponent>().materialHandles[0] = materialHandle;
-	modelEntity.getComponent<ModelComponent>().shaderHandles[0] =
-		GraphicsShaderManager::getHandle(meshHandles[0], materialHandle);
+	modelEntity.getComponent<ModelComponent>().shaderHandles[0] = GraphicsShaderManager::getHandle(
+		modelEntity.getComponent<ModelComponent>().meshHandles[0], materialHandle);
 
 	modelEntity.getComponent<ScriptComponent>().handle = ScriptManager::getScriptHandle("script_floating_object");
 
@@ -151,15 +328,16 @@ int Core::init(int argc, char** argv) {
 
 	modelEntity.getComponent<TransformComponent>().position.x = 3.0f;
 
-	// std::vector<MeshManager::Handle> meshHandles {};
-	if (Importer::importMesh("assets/models/sphere.fbx", meshHandles)) {
+	if (getModelLods(1, lodHandles)) {
 		return 1;
 	}
-	modelEntity.getComponent<ModelComponent>().meshHandles[0] = meshHandles[0];
+	for (uint lod = 0; lod < lodHandles.size(); lod++) {
+		modelEntity.getComponent<ModelComponent>().meshHandles[lod] = lodHandles[lod];
+	}
 
 	modelEntity.getComponent<ModelComponent>().materialHandles[0] = materialHandle;
-	modelEntity.getComponent<ModelComponent>().shaderHandles[0] =
-		GraphicsShaderManager::getHandle(meshHandles[0], materialHandle);
+	modelEntity.getComponent<ModelComponent>().shaderHandles[0] = GraphicsShaderManager::getHandle(
+		modelEntity.getComponent<ModelComponent>().meshHandles[0], materialHandle);
 
 
 	auto directionalLightEntity =
@@ -175,35 +353,16 @@ int Core::init(int argc, char** argv) {
 
 
 	// auto tileEntity = EntityManager::createEntity<TransformComponent, ModelComponent>("tile");
-	// std::vector<MeshManager::Handle> meshHandles {};
-	if (Importer::importMesh("assets/models/tile.fbx", meshHandles)) {
-		return 1;
-	}
-	// tileEntity.getComponent<ModelComponent>().meshHandles[0] = meshHandles[0];
+	// tileEntity.getComponent<ModelComponent>().meshHandles[0] = meshHandleArrays[2][0];
 
-
-	albedoTextureHandle = TextureManager::createObject<Texture2D>("mud_with_vegetation_albedo");
-	if (Importer::importTexture("assets/textures/mud_with_vegetation_albedo.png", albedoTextureHandle, 4, 8,
-								vk::Format::eR8G8B8A8Srgb)) {
-		return 1;
-	}
-	normalTextureHandle = TextureManager::createObject<Texture2D>("mud_with_vegetation_normal");
-	if (Importer::importTexture("assets/textures/mud_with_vegetation_normal.png", normalTextureHandle, 4, 8,
-								vk::Format::eR8G8B8A8Unorm)) {
-		return 1;
-	}
-	mraTextureHandle = TextureManager::createObject<Texture2D>("mud_with_vegetation_mra");
-	if (Importer::importTexture("assets/textures/mud_with_vegetation_mra.png", mraTextureHandle, 4, 8,
-								vk::Format::eR8G8B8A8Srgb)) {
+	if (MaterialManager::createObject<SimpleMaterial>("mud_with_vegetation", materialHandle)) {
 		return 1;
 	}
-
-	materialHandle = MaterialManager::createObject<SimpleMaterial>("mud_with_vegetation");
 	materialHandle.apply([&](auto& material) {
 		// material.color			   = glm::vec3(0.5f, 0.3f, 0.8f);
-		material.textureAlbedo = albedoTextureHandle;
-		material.textureNormal = normalTextureHandle;
-		material.textureMRA	   = mraTextureHandle;
+		material.textureAlbedo = textureHandles[3];
+		material.textureNormal = textureHandles[4];
+		material.textureMRA	   = textureHandles[5];
 	});
 	materialHandle.update();
 
@@ -239,21 +398,21 @@ int Core::init(int argc, char** argv) {
 
 	auto& terrainState = GlobalStateManager::getWritable<TerrainState>();
 
-	terrainState.size				= 4096;
-	terrainState.maxHeight			= 512;
 	terrainState.materialHandles[0] = materialHandle;
 	terrainState.shaderHandles[0]	= GraphicsShaderManager::getHandle<TerrainMesh>(materialHandle);
-	terrainState.heightMapHandle	= TextureManager::createObject<Texture2D>("terrain_height");
-	if (Importer::importTexture("assets/textures/terrain_05_height.png", terrainState.heightMapHandle, 1, 16,
-								vk::Format::eR16Unorm)) {
-		return 1;
-	}
 
-	terrainState.normalMapHandle = TextureManager::createObject<Texture2D>("terrain_normal");
-	Generator::normalMapFromHeight(terrainState.heightMapHandle, terrainState.normalMapHandle, terrainState.maxHeight);
+	if (TerrainStreamingManager::load(terrainFilename)) {
+		// Cooked file passed header check but is broken further in, it is cooked again from heightmap
+		spdlog::warn("Cooking '{}' again", terrainFilename);
+		if (Importer::cookTerrain(terrainHeightMapFilename, terrainFilename, 1.0f, 512.0f) ||
+			TerrainStreamingManager::load(terrainFilename)) {
+			return 1;
+		}
+	}
 
 
-	spdlog::info("Initialization completed successfully");
+	spdlog::info("Initialization completed successfully in {:.3f} s",
+				 std::chrono::duration<double>(std::chrono::steady_clock::now() - initStartTime).count());
 
 	return 0;
 }
@@ -272,6 +431,8 @@ int Core::run() {
 
 	DebugState::ExecutionTimeArrays cumulativeExecutionTimeArrays = debugState.executionTimeArrays;
 
+	bool isFirstFrame = true;
+
 	while (!glfwWindowShouldClose(glfwWindow)) {
 		auto& debugState = GlobalStateManager::getWritable<DebugState>();
 
@@ -337,6 +498,16 @@ int Core::run() {
 			executionTime.cpuTime = timer.stop();
 			executionTime.gpuTime = -1.0f;
 		}
+
+		// First frame is presented by rendering system above
+		if (isFirstFrame) {
+			isFirstFrame = false;
+
+			debugState.timeToFirstFrame =
+				std::chrono::duration<float>(std::chrono::steady_clock::now() - initStartTime).count();
+
+			spdlog::info("Time to first frame: {:.3f} s", debugState.timeToFirstFrame);
+		}
 	}
 
 	spdlog::info("Main loop terminated");
@@ -9,6 +9,7 @@
 #include "engine/systems/SystemBase.hpp"
 
 #include <array>
+#include <chrono>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -29,6 +30,9 @@ private:
 
 	GLFWwindow* glfwWindow = nullptr;
 
+	// Start of initialization, time to first frame is measured from it
+	std::chrono::steady_clock::time_point initStartTime {};
+
 
 	std::stringstream logBuffer {};
 
@@ -2,9 +2,12 @@
 
 #include <spdlog/spdlog.h>
 
+#include <cassert>
+
 
 namespace Engine {
-vk::Result Buffer::allocate(VmaAllocator allocator, vk::DeviceSize bufferSize) {
+vk::Result Buffer::allocate(VmaAllocator allocator, vk::DeviceSize bufferSize,
+							const std::vector<uint32_t>& queueFamilyIndices) {
 	vmaAllocator = allocator;
 	vkBufferSize = bufferSize;
 
@@ -12,6 +15,12 @@ vk::Result Buffer::allocate(VmaAllocator allocator, vk::DeviceSize bufferSize) {
 	bufferCreateInfo.size  = VkDeviceSize(vkBufferSize);
 	bufferCreateInfo.usage = VkBufferUsageFlags(vkBufferUsageFlags);
 
+	if (queueFamilyIndices.size() > 1) {
+		bufferCreateInfo.sharingMode		   = VK_SHARING_MODE_CONCURRENT;
+		bufferCreateInfo.queueFamilyIndexCount = queueFamilyIndices.size();
+		bufferCreateInfo.pQueueFamilyIndices   = queueFamilyIndices.data();
+	}
+
 	VmaAllocationCreateInfo allocationCreateInfo {};
 	allocationCreateInfo.usage = vmaMemoryUsage;
 
@@ -26,7 +35,7 @@ vk::Result Buffer::allocate(VmaAllocator allocator, vk::DeviceSize bufferSize) {
 	return vk::Result::eSuccess;
 }
 
-vk::Result Buffer::write(void* data) {
+vk::Result Buffer::write(const void* data) {
 	void* pBufferData;
 	auto result = vmaMapMemory(vmaAllocator, vmaAllocation, &pBufferData);
 	if (result != VK_SUCCESS) {
@@ -39,47 +48,17 @@ vk::Result Buffer::write(void* data) {
 	return vk::Result::eSuccess;
 }
 
-vk::Result Buffer::writeStaged(vk::Device device, vk::Queue transferQueue, vk::CommandPool commandPool, void* data) {
-	Buffer stagingBuffer = { vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_TO_GPU };
-
-	stagingBuffer.allocate(vmaAllocator, vkBufferSize);
-	// RETURN_IF_VK_ERROR(stagingBuffer.allocate(), "Failed to allocate buffer");
-	stagingBuffer.write(data);
-	// RETURN_IF_VK_ERROR(stagingBuffer.write(mesh.getVertexBuffer().data()), "Failed to write buffer");
-
-	vk::CommandBufferAllocateInfo commandBufferAllocateInfo {};
-	commandBufferAllocateInfo.level				 = vk::CommandBufferLevel::ePrimary;
-	commandBufferAllocateInfo.commandPool		 = commandPool;
-	commandBufferAllocateInfo.commandBufferCount = 1;
-
-	vk::CommandBuffer stagingCommandBuffer;
-	device.allocateCommandBuffers(&commandBufferAllocateInfo, &stagingCommandBuffer);
-	// RETURN_IF_VK_ERROR(vkDevice.allocateCommandBuffers(&commandBufferAllocateInfo, &stagingCommandBuffer),
-	// 				"Failed to allocate staging command buffer");
-
-	vk::CommandBufferBeginInfo commandBufferBeginInfo {};
-	commandBufferBeginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-
-	stagingCommandBuffer.begin(&commandBufferBeginInfo);
-	// RETURN_IF_VK_ERROR(stagingCommandBuffer.begin(&commandBufferBeginInfo), "Failed to record command
-	// buffer");
-
-	vk::BufferCopy bufferCopy {};
-	bufferCopy.size = vkBufferSize;
-	stagingCommandBuffer.copyBuffer(stagingBuffer.getVkBuffer(), vkBuffer, 1, &bufferCopy);
-
-	stagingCommandBuffer.end();
+vk::Result Buffer::read(void* data) {
+	void* pBufferData;
+	auto result = vmaMapMemory(vmaAllocator, vmaAllocation, &pBufferData);
+	if (result != VK_SUCCESS) {
+		return vk::Result(result);
+	}
 
-	vk::SubmitInfo submitInfo {};
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers	  = &stagingCommandBuffer;
-	transferQueue.submit(1, &submitInfo, nullptr);
-	// RETURN_IF_VK_ERROR(vkGraphicsQueue.submit(1, &submitInfo, nullptr), "Failed to submit staging command
-	// buffer");
-	transferQueue.waitIdle();
-	// RETURN_IF_VK_ERROR(vkGraphicsQueue.waitIdle(), "Failed to wait for staging command buffer to complete");
+	vmaInvalidateAllocation(vmaAllocator, vmaAllocation, 0, VK_WHOLE_SIZE);
 
-	stagingBuffer.destroy();
+	memcpy(data, pBufferData, vkBufferSize);
+	vmaUnmapMemory(vmaAllocator, vmaAllocation);
 
 	return vk::Result::eSuccess;
 }
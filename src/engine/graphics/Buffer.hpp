@@ -5,6 +5,8 @@
 
 #include "vk_mem_alloc.h"
 
+#include <vector>
+
 
 namespace Engine {
 class Buffer {
@@ -24,11 +26,12 @@ public:
 		vkBufferUsageFlags(bufferUsageFlags), vmaMemoryUsage(memoryUsage) {
 	}
 
-	[[nodiscard]] vk::Result allocate(VmaAllocator allocator, vk::DeviceSize bufferSize);
+	// Buffer is shared concurrently if several queue families are given
+	[[nodiscard]] vk::Result allocate(VmaAllocator allocator, vk::DeviceSize bufferSize,
+									  const std::vector<uint32_t>& queueFamilyIndices = {});
 
-	[[nodiscard]] vk::Result write(void* data);
-	[[nodiscard]] vk::Result writeStaged(vk::Device device, vk::Queue transferQueue, vk::CommandPool commandPool,
-										 void* data);
+	[[nodiscard]] vk::Result write(const void* data);
+	[[nodiscard]] vk::Result read(void* data);
 
 	void destroy();
 
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace Engine {
+// Layout of cooked mesh files:
+// - Header
+// - MeshHeader for each mesh
+// - Meshlets, vertex streams and indices of each mesh in GPU layout, every block aligned to DATA_ALIGNMENT
+class CookedMeshFile {
+public:
+	static constexpr uint32_t MAGIC	  = 0x4853454d; // "MESH"
+	static constexpr uint32_t VERSION = 1;
+
+	static constexpr uint32_t MAX_NAME_LENGTH		  = 64;
+	static constexpr uint32_t MAX_VERTEX_STREAM_COUNT = 2;
+
+	static constexpr uint64_t DATA_ALIGNMENT = 16;
+
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+
+		uint32_t meshCount;
+		uint32_t reserved;
+	};
+
+	struct MeshHeader {
+		// Null terminated
+		char name[MAX_NAME_LENGTH];
+
+		// Mesh type index within MeshManager
+		uint32_t typeIndex;
+
+		uint32_t vertexCount;
+		uint32_t vertexStreamCount;
+
+		uint32_t indexCount;
+		// Size of an index in bytes, either 2 or 4
+		uint32_t indexSize;
+
+		uint32_t meshletCount;
+
+		float boundingBox[8][3];
+		// Center followed by radius
+		float boundingSphere[4];
+
+		float positionDequantization[4];
+
+		uint64_t meshletOffset;
+		uint64_t vertexStreamOffsets[MAX_VERTEX_STREAM_COUNT];
+		uint64_t indexOffset;
+	};
+
+
+	static constexpr uint64_t alignOffset(uint64_t offset) {
+		return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace Engine {
+// Layout of cooked texture files:
+// - Header
+// - MipLevelHeader for each mip level, finest first, down to a single texel
+// - Tightly packed pixels of each mip level, every level aligned to DATA_ALIGNMENT
+class CookedTextureFile {
+public:
+	static constexpr uint32_t MAGIC	  = 0x52545854; // "TXTR"
+	static constexpr uint32_t VERSION = 1;
+
+	static constexpr uint32_t MAX_MIP_LEVEL_COUNT = 16;
+
+	// Texel size of every cooked format
+	static constexpr uint32_t TEXEL_SIZE = 4;
+
+	static constexpr uint64_t DATA_ALIGNMENT = 16;
+
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+
+		// Mip level 0 size in texels
+		uint32_t width;
+		uint32_t height;
+
+		// VkFormat value
+		uint32_t format;
+		uint32_t mipLevelCount;
+	};
+
+	struct MipLevelHeader {
+		uint32_t width;
+		uint32_t height;
+
+		uint64_t offset;
+		uint64_t size;
+	};
+
+
+	static constexpr uint64_t alignOffset(uint64_t offset) {
+		return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "HeightPyramid.hpp"
+
+#include "engine/utils/ThreadPool.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+namespace Engine {
+int HeightPyramid::build(const uint16_t* pHeights, uint width, uint height, uint threadCount) {
+	if (pHeights == nullptr || width == 0 || height == 0) {
+		spdlog::error("[HeightPyramid] Failed to build pyramid from empty heightmap");
+		return 1;
+	}
+
+	this->width	 = width;
+	this->height = height;
+
+	levels.clear();
+	baseLevel = 0;
+
+	// Heightmap itself is treated as a level with equal min and max planes
+	Level srcLevel {};
+	srcLevel.width	= width;
+	srcLevel.height = height;
+	srcLevel.minHeights.assign(pHeights, pHeights + width * height);
+	srcLevel.maxHeights = srcLevel.minHeights;
+
+	threadCount = std::max(threadCount, 1u);
+
+	ThreadPool threadPool {};
+	threadPool.init(
+		[](uint, void* pData) {
+			const auto& threadInfo = *static_cast<BuildThreadInfo*>(pData);
+			buildRows(*threadInfo.pSrcLevel, *threadInfo.pDstLevel, threadInfo.firstRow, threadInfo.rowCount);
+		},
+		threadCount);
+
+	std::vector<BuildThreadInfo> threadInfos(threadCount);
+
+	const Level* pSrcLevel = &srcLevel;
+
+	do {
+		Level dstLevel {};
+		dstLevel.width	= (pSrcLevel->width + 1) / 2;
+		dstLevel.height = (pSrcLevel->height + 1) / 2;
+		dstLevel.minHeights.resize(dstLevel.width * dstLevel.height);
+		dstLevel.maxHeights.resize(dstLevel.width * dstLevel.height);
+		dstLevel.curvatures.resize(dstLevel.width * dstLevel.height);
+
+		// Not worth waking threads up for small levels
+		uint fragmentCount = std::min(threadCount, dstLevel.height / 64 + 1);
+		uint rowsPerThread = (dstLevel.height + fragmentCount - 1) / fragmentCount;
+
+		for (uint i = 0; i < fragmentCount; i++) {
+			threadInfos[i].pSrcLevel = pSrcLevel;
+			threadInfos[i].pDstLevel = &dstLevel;
+			threadInfos[i].firstRow	 = std::min(i * rowsPerThread, dstLevel.height);
+			threadInfos[i].rowCount	 = std::min(rowsPerThread, dstLevel.height - threadInfos[i].firstRow);
+
+			threadPool.appendData(&threadInfos[i]);
+		}
+
+		threadPool.waitForAll();
+
+		levels.push_back(std::move(dstLevel));
+		pSrcLevel = &levels.back();
+	} while (pSrcLevel->width > 1 || pSrcLevel->height > 1);
+
+	return 0;
+}
+
+
+glm::vec2 HeightPyramid::getHeightRange(glm::vec2 minTexCoord, glm::vec2 maxTexCoord) const {
+	if (levels.empty()) {
+		return glm::vec2(0.0f, 1.0f);
+	}
+
+	glm::uvec2 minTexel {};
+	glm::uvec2 maxTexel {};
+
+	const auto& level = getTexelRange(minTexCoord, maxTexCoord, minTexel, maxTexel);
+
+	uint16_t minHeight = UINT16_MAX;
+	uint16_t maxHeight = 0;
+
+	for (uint y = minTexel.y; y <= maxTexel.y; y++) {
+		for (uint x = minTexel.x; x <= maxTexel.x; x++) {
+			minHeight = std::min(minHeight, level.minHeights[y * level.width + x]);
+			maxHeight = std::max(maxHeight, level.maxHeights[y * level.width + x]);
+		}
+	}
+
+	return glm::vec2(minHeight, maxHeight) / 65535.0f;
+}
+
+float HeightPyramid::getCurvature(glm::vec2 minTexCoord, glm::vec2 maxTexCoord) const {
+	if (levels.empty()) {
+		return 1.0f;
+	}
+
+	glm::uvec2 minTexel {};
+	glm::uvec2 maxTexel {};
+
+	const auto& level = getTexelRange(minTexCoord, maxTexCoord, minTexel, maxTexel);
+
+	uint16_t curvature = 0;
+
+	for (uint y = minTexel.y; y <= maxTexel.y; y++) {
+		for (uint x = minTexel.x; x <= maxTexel.x; x++) {
+			curvature = std::max(curvature, level.curvatures[y * level.width + x]);
+		}
+	}
+
+	return curvature / 65535.0f;
+}
+
+
+const HeightPyramid::Level& HeightPyramid::getTexelRange(glm::vec2 minTexCoord, glm::vec2 maxTexCoord,
+														 glm::uvec2& minTexel, glm::uvec2& maxTexel) const {
+	// Bicubic filter reads up to two texels around sampled point
+	constexpr float filterExtent = 2.0f;
+
+	const glm::vec2 size = glm::vec2(width, height);
+
+	// In level 0 texels
+	glm::vec2 minPos = (minTexCoord * size - filterExtent) * 0.5f;
+	glm::vec2 maxPos = (maxTexCoord * size + filterExtent) * 0.5f;
+
+	minPos = glm::max(minPos, glm::vec2(0.0f));
+	maxPos = glm::max(maxPos, minPos);
+
+	float extent	= std::max(maxPos.x - minPos.x, maxPos.y - minPos.y);
+	uint levelIndex = static_cast<uint>(std::ceil(std::log2(std::max(extent, 1.0f))));
+
+	levelIndex = std::clamp(levelIndex, baseLevel, baseLevel + static_cast<uint>(levels.size()) - 1);
+
+	const auto& level = levels[levelIndex - baseLevel];
+
+	const float levelScale = 1.0f / (1u << levelIndex);
+
+	minTexel.x = std::min(static_cast<uint>(minPos.x * levelScale), level.width - 1);
+	minTexel.y = std::min(static_cast<uint>(minPos.y * levelScale), level.height - 1);
+	maxTexel.x = std::min(static_cast<uint>(maxPos.x * levelScale), level.width - 1);
+	maxTexel.y = std::min(static_cast<uint>(maxPos.y * levelScale), level.height - 1);
+
+	return level;
+}
+
+
+void HeightPyramid::dropFinestLevels(uint maxWidth) {
+	uint dropCount = 0;
+	while (dropCount + 1 < levels.size() && levels[dropCount].width > maxWidth) {
+		dropCount++;
+	}
+
+	levels.erase(levels.begin(), levels.begin() + dropCount);
+	baseLevel += dropCount;
+}
+
+
+void HeightPyramid::serialize(std::vector<uint8_t>& data) const {
+	auto write = [&data](const void* pSrc, uint64_t size) {
+		uint64_t offset = data.size();
+		data.resize(offset + size);
+		memcpy(&data[offset], pSrc, size);
+	};
+
+	uint levelCount = levels.size();
+
+	write(&width, sizeof(width));
+	write(&height, sizeof(height));
+	write(&baseLevel, sizeof(baseLevel));
+	write(&levelCount, sizeof(levelCount));
+
+	for (const auto& level : levels) {
+		uint64_t planeSize = level.width * level.height * sizeof(uint16_t);
+
+		write(&level.width, sizeof(level.width));
+		write(&level.height, sizeof(level.height));
+
+		write(level.minHeights.data(), planeSize);
+		write(level.maxHeights.data(), planeSize);
+		write(level.curvatures.data(), planeSize);
+	}
+}
+
+int HeightPyramid::deserialize(const uint8_t* pData, uint64_t size) {
+	uint64_t offset = 0;
+
+	auto read = [&](void* pDst, uint64_t readSize) {
+		if (offset + readSize > size) {
+			return false;
+		}
+
+		memcpy(pDst, &pData[offset], readSize);
+		offset += readSize;
+
+		return true;
+	};
+
+	levels.clear();
+
+	uint levelCount {};
+
+	if (!read(&width, sizeof(width)) || !read(&height, sizeof(height)) || !read(&baseLevel, sizeof(baseLevel)) ||
+		!read(&levelCount, sizeof(levelCount))) {
+		spdlog::error("[HeightPyramid] Failed to deserialize pyramid header");
+		return 1;
+	}
+
+	levels.resize(levelCount);
+
+	for (auto& level : levels) {
+		if (!read(&level.width, sizeof(level.width)) || !read(&level.height, sizeof(level.height))) {
+			spdlog::error("[HeightPyramid] Failed to deserialize pyramid level");
+			levels.clear();
+			return 1;
+		}
+
+		level.minHeights.resize(level.width * level.height);
+		level.maxHeights.resize(level.width * level.height);
+		level.curvatures.resize(level.width * level.height);
+
+		uint64_t planeSize = level.width * level.height * sizeof(uint16_t);
+
+		if (!read(level.minHeights.data(), planeSize) || !read(level.maxHeights.data(), planeSize) ||
+			!read(level.curvatures.data(), planeSize)) {
+			spdlog::error("[HeightPyramid] Failed to deserialize pyramid level");
+			levels.clear();
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+void HeightPyramid::buildRows(const Level& srcLevel, Level& dstLevel, uint firstRow, uint rowCount) {
+	std::vector<uint16_t> curvatureRows {};
+	if (srcLevel.curvatures.empty()) {
+		curvatureRows.resize(srcLevel.width * 2);
+	}
+
+	for (uint y = firstRow; y < firstRow + rowCount; y++) {
+		// Last row of odd height levels is reduced with itself
+		uint srcRow0 = y * 2;
+		uint srcRow1 = std::min(y * 2 + 1, srcLevel.height - 1);
+
+		reduceRow(&srcLevel.minHeights[srcRow0 * srcLevel.width], &srcLevel.minHeights[srcRow1 * srcLevel.width],
+				  srcLevel.width, &dstLevel.minHeights[y * dstLevel.width], false);
+		reduceRow(&srcLevel.maxHeights[srcRow0 * srcLevel.width], &srcLevel.maxHeights[srcRow1 * srcLevel.width],
+				  srcLevel.width, &dstLevel.maxHeights[y * dstLevel.width], true);
+
+		if (srcLevel.curvatures.empty()) {
+			computeCurvatureRow(srcLevel, srcRow0, &curvatureRows[0]);
+			computeCurvatureRow(srcLevel, srcRow1, &curvatureRows[srcLevel.width]);
+
+			reduceRow(&curvatureRows[0], &curvatureRows[srcLevel.width], srcLevel.width,
+					  &dstLevel.curvatures[y * dstLevel.width], true);
+		} else {
+			reduceRow(&srcLevel.curvatures[srcRow0 * srcLevel.width], &srcLevel.curvatures[srcRow1 * srcLevel.width],
+					  srcLevel.width, &dstLevel.curvatures[y * dstLevel.width], true);
+		}
+	}
+}
+
+void HeightPyramid::reduceRow(const uint16_t* pSrcRow0, const uint16_t* pSrcRow1, uint srcWidth, uint16_t* pDstRow,
+							  bool isMax) {
+	uint dstX = 0;
+
+#ifdef __SSE2__
+	// SSE2 only has signed 16 bit min/max, values are biased into signed range and back
+	const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+
+	auto reduce = [&](__m128i a, __m128i b) {
+		return isMax ? _mm_max_epi16(a, b) : _mm_min_epi16(a, b);
+	};
+
+	// 16 source texels of each row into 8 destination texels
+	for (; dstX + 8 <= srcWidth / 2; dstX += 8) {
+		const auto* pSrc0 = reinterpret_cast<const __m128i*>(pSrcRow0 + dstX * 2);
+		const auto* pSrc1 = reinterpret_cast<const __m128i*>(pSrcRow1 + dstX * 2);
+
+		__m128i lo = reduce(_mm_xor_si128(_mm_loadu_si128(pSrc0 + 0), bias),
+							_mm_xor_si128(_mm_loadu_si128(pSrc1 + 0), bias));
+		__m128i hi = reduce(_mm_xor_si128(_mm_loadu_si128(pSrc0 + 1), bias),
+							_mm_xor_si128(_mm_loadu_si128(pSrc1 + 1), bias));
+
+		// Reduce horizontal pairs into low halves of 32 bit lanes, then sign extend and pack them
+		lo = reduce(lo, _mm_srli_epi32(lo, 16));
+		hi = reduce(hi, _mm_srli_epi32(hi, 16));
+
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + dstX), _mm_xor_si128(_mm_packs_epi32(lo, hi), bias));
+	}
+#endif
+
+	const uint dstWidth = (srcWidth + 1) / 2;
+
+	for (; dstX < dstWidth; dstX++) {
+		// Last column of odd width levels is reduced with itself
+		uint srcX0 = dstX * 2;
+		uint srcX1 = std::min(dstX * 2 + 1, srcWidth - 1);
+
+		if (isMax) {
+			pDstRow[dstX] = std::max({ pSrcRow0[srcX0], pSrcRow0[srcX1], pSrcRow1[srcX0], pSrcRow1[srcX1] });
+		} else {
+			pDstRow[dstX] = std::min({ pSrcRow0[srcX0], pSrcRow0[srcX1], pSrcRow1[srcX0], pSrcRow1[srcX1] });
+		}
+	}
+}
+
+void HeightPyramid::computeCurvatureRow(const Level& level, uint row, uint16_t* pDstRow) {
+	const uint16_t* pHeights = level.minHeights.data();
+
+	// Clamped at borders
+	const uint16_t* pRow	 = &pHeights[row * level.width];
+	const uint16_t* pRowPrev = &pHeights[(row > 0 ? row - 1 : row) * level.width];
+	const uint16_t* pRowNext = &pHeights[std::min(row + 1, level.height - 1) * level.width];
+
+	for (uint x = 0; x < level.width; x++) {
+		int height	   = pRow[x];
+		int heightPrev = pRow[x > 0 ? x - 1 : x];
+		int heightNext = pRow[std::min(x + 1, level.width - 1)];
+
+		int curvatureX = std::abs(heightPrev + heightNext - 2 * height);
+		int curvatureY = std::abs(pRowPrev[x] + pRowNext[x] - 2 * height);
+
+		pDstRow[x] = std::min(std::max(curvatureX, curvatureY), static_cast<int>(UINT16_MAX));
+	}
+}
+} // namespace Engine
\ No newline at end of file
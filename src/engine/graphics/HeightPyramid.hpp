@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+namespace Engine {
+// Min/max mip pyramid of a 16 bit heightmap. Level 0 texel covers 2x2 heightmap texels, each next level halves
+// resolution. Used for tight bounds of terrain areas on the CPU. Max curvature (absolute second difference of heights)
+// is reduced along, it tells how much tessellation an area needs.
+class HeightPyramid {
+private:
+	struct Level {
+		uint width;
+		uint height;
+
+		std::vector<uint16_t> minHeights;
+		std::vector<uint16_t> maxHeights;
+
+		// Left empty for heightmap itself, computed on the fly from heights instead
+		std::vector<uint16_t> curvatures;
+	};
+
+	struct BuildThreadInfo {
+		const Level* pSrcLevel;
+		Level* pDstLevel;
+
+		uint firstRow;
+		uint rowCount;
+	};
+
+	std::vector<Level> levels {};
+
+	// Index of first stored level, finer levels can be dropped to save memory at cost of looser bounds
+	uint baseLevel {};
+
+	uint width {};
+	uint height {};
+
+
+public:
+	// Builds pyramid from heights in row major order, rows are distributed between threads
+	int build(const uint16_t* pHeights, uint width, uint height, uint threadCount);
+
+	// Returns normalized min and max heights of area given in texture coordinates. Area is extended by a filter
+	// footprint of a few texels to stay conservative for bicubic sampling.
+	glm::vec2 getHeightRange(glm::vec2 minTexCoord, glm::vec2 maxTexCoord) const;
+
+	// Returns max normalized curvature of area given in texture coordinates, per texel squared
+	float getCurvature(glm::vec2 minTexCoord, glm::vec2 maxTexCoord) const;
+
+	// Drops finest levels until first stored one is not wider than given size
+	void dropFinestLevels(uint maxWidth);
+
+	void serialize(std::vector<uint8_t>& data) const;
+	int deserialize(const uint8_t* pData, uint64_t size);
+
+
+	inline bool isEmpty() const {
+		return levels.empty();
+	}
+
+	inline uint getLevelCount() const {
+		return levels.size();
+	}
+
+	inline glm::uvec2 getSize() const {
+		return glm::uvec2(width, height);
+	}
+
+
+private:
+	// Selects level at which area covers at most two texels in each direction and returns texel range in it
+	const Level& getTexelRange(glm::vec2 minTexCoord, glm::vec2 maxTexCoord, glm::uvec2& minTexel,
+							   glm::uvec2& maxTexel) const;
+
+	static void buildRows(const Level& srcLevel, Level& dstLevel, uint firstRow, uint rowCount);
+
+	// Reduces two source rows into a single destination row of half width
+	static void reduceRow(const uint16_t* pSrcRow0, const uint16_t* pSrcRow1, uint srcWidth, uint16_t* pDstRow,
+						  bool isMax);
+
+	static void computeCurvatureRow(const Level& level, uint row, uint16_t* pDstRow);
+};
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "BoundingSphere.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace Engine {
+// Cluster of triangles stored contiguously in a mesh index buffer
+class Meshlet {
+public:
+	uint32_t firstIndex {};
+	uint32_t indexCount {};
+
+	BoundingSphere boundingSphere {};
+
+	// Normal cone, cutoff of 1.0 disables back face test
+	glm::vec3 coneAxis { 0.0f, 0.0f, 1.0f };
+	float coneCutoff { 1.0f };
+
+
+public:
+	inline Meshlet transform(const glm::mat4& matrix) const {
+		Meshlet transformed = *this;
+
+		const glm::vec3 axisScales = glm::vec3(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])),
+											   glm::length(glm::vec3(matrix[2])));
+
+		const float scale	 = std::max(std::max(axisScales.x, axisScales.y), axisScales.z);
+		const float minScale = std::min(std::min(axisScales.x, axisScales.y), axisScales.z);
+
+		transformed.boundingSphere.center = glm::vec3(matrix * glm::vec4(boundingSphere.center, 1.0f));
+		transformed.boundingSphere.radius = boundingSphere.radius * scale;
+
+		// Cone axis is transformed as a normal, which matrix itself does only under uniform scale. Non uniform scale
+		// also changes cone angle, so back face test is disabled rather than paying for an inverse per meshlet.
+		if (scale - minScale > 1e-3f * scale) {
+			transformed.coneCutoff = 1.0f;
+		} else {
+			transformed.coneAxis = glm::normalize(glm::mat3(matrix) * coneAxis);
+		}
+
+		return transformed;
+	}
+
+	// True if every triangle faces away from a perspective view at given position
+	inline bool isBackFacing(const glm::vec3& viewPosition) const {
+		const auto viewVector = boundingSphere.center - viewPosition;
+
+		return coneCutoff < 1.0f &&
+			   glm::dot(viewVector, coneAxis) >= coneCutoff * glm::length(viewVector) + boundingSphere.radius;
+	}
+
+	// True if every triangle faces away from an orthographic view with given direction
+	inline bool isBackFacingDirection(const glm::vec3& viewDirection) const {
+		return coneCutoff < 1.0f && glm::dot(viewDirection, coneAxis) >= coneCutoff;
+	}
+};
+} // namespace Engine
\ No newline at end of file
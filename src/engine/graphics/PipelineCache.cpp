@@ -0,0 +1,180 @@
+#include "PipelineCache.hpp"
+
+#include "engine/utils/IO.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <filesystem>
+
+
+namespace Engine {
+vk::Device PipelineCache::vkDevice {};
+vk::PipelineCache PipelineCache::vkPipelineCache {};
+
+vk::PhysicalDeviceProperties PipelineCache::vkPhysicalDeviceProperties {};
+
+bool PipelineCache::isCreationFeedbackSupported {};
+
+std::atomic<uint> PipelineCache::createdCount {};
+std::atomic<uint> PipelineCache::hitCount {};
+std::atomic<uint> PipelineCache::missCount {};
+
+std::atomic<uint> PipelineCache::unsavedCount {};
+std::chrono::steady_clock::time_point PipelineCache::lastSaveTime {};
+
+PipelineCache::Properties PipelineCache::properties {};
+
+
+int PipelineCache::init(vk::PhysicalDevice physicalDevice, vk::Device device, bool creationFeedbackSupported) {
+	spdlog::info("Initializing PipelineCache...");
+
+	vkDevice					= device;
+	isCreationFeedbackSupported = creationFeedbackSupported;
+
+	physicalDevice.getProperties(&vkPhysicalDeviceProperties);
+
+	std::vector<uint8_t> initialData {};
+
+	if (properties.pipelineCacheEnabled) {
+		std::error_code errorCode;
+		std::filesystem::create_directories(std::filesystem::path(FILENAME).parent_path(), errorCode);
+
+		if (!readFile(FILENAME, initialData) && !isDataCompatible(initialData)) {
+			spdlog::warn("[PipelineCache] '{}' was created by another device or driver, discarding", FILENAME);
+			initialData.clear();
+		}
+	}
+
+	vk::PipelineCacheCreateInfo pipelineCacheCreateInfo {};
+	pipelineCacheCreateInfo.initialDataSize = initialData.size();
+	pipelineCacheCreateInfo.pInitialData	= initialData.data();
+
+	auto result = vkDevice.createPipelineCache(&pipelineCacheCreateInfo, nullptr, &vkPipelineCache);
+	if (result != vk::Result::eSuccess) {
+		spdlog::error("[vulkan] Failed to create pipeline cache. Error code: {} ({})", result, vk::to_string(result));
+		return 1;
+	}
+
+	lastSaveTime = std::chrono::steady_clock::now();
+
+	return 0;
+}
+
+
+void PipelineCache::update() {
+	if (unsavedCount == 0) {
+		return;
+	}
+
+	const auto now = std::chrono::steady_clock::now();
+	if (now - lastSaveTime < std::chrono::seconds(properties.pipelineCacheSaveInterval)) {
+		return;
+	}
+
+	save();
+}
+
+int PipelineCache::save() {
+	lastSaveTime = std::chrono::steady_clock::now();
+	unsavedCount = 0;
+
+	if (!properties.pipelineCacheEnabled || vkPipelineCache == vk::PipelineCache()) {
+		return 0;
+	}
+
+	size_t dataSize = 0;
+
+	auto result = vkDevice.getPipelineCacheData(vkPipelineCache, &dataSize, nullptr);
+	if (result != vk::Result::eSuccess) {
+		spdlog::error("[vulkan] Failed to get pipeline cache data. Error code: {} ({})", result,
+					  vk::to_string(result));
+		return 1;
+	}
+
+	std::vector<uint8_t> data(dataSize);
+
+	// Cache may grow in between calls from other threads, incomplete data is still valid
+	result = vkDevice.getPipelineCacheData(vkPipelineCache, &dataSize, data.data());
+	if (result != vk::Result::eSuccess && result != vk::Result::eIncomplete) {
+		spdlog::error("[vulkan] Failed to get pipeline cache data. Error code: {} ({})", result,
+					  vk::to_string(result));
+		return 1;
+	}
+
+	// Written under temporary name and renamed so that an interrupted save does not corrupt the cache
+	const auto tempFilename = std::string(FILENAME) + ".tmp";
+
+	if (writeFile(tempFilename, data.data(), dataSize)) {
+		spdlog::error("[PipelineCache] Failed to write '{}'", tempFilename);
+		return 1;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempFilename, FILENAME, errorCode);
+	if (errorCode) {
+		spdlog::error("[PipelineCache] Failed to rename '{}' to '{}': {}", tempFilename, FILENAME,
+					  errorCode.message());
+		return 1;
+	}
+
+	return 0;
+}
+
+void PipelineCache::dispose() {
+	if (vkPipelineCache == vk::PipelineCache()) {
+		return;
+	}
+
+	if (isCreationFeedbackSupported) {
+		spdlog::info("[PipelineCache] {} pipeline(s) created, {} cache hit(s), {} miss(es)", getCreatedCount(),
+					 getHitCount(), getMissCount());
+	}
+
+	save();
+
+	vkDevice.destroyPipelineCache(vkPipelineCache);
+	vkPipelineCache = vk::PipelineCache();
+}
+
+
+void PipelineCache::recordPipelineCreation(const vk::PipelineCreationFeedbackEXT& feedback) {
+	createdCount++;
+	unsavedCount++;
+
+	if (!isCreationFeedbackSupported || !(feedback.flags & vk::PipelineCreationFeedbackFlagBitsEXT::eValid)) {
+		return;
+	}
+
+	if (feedback.flags & vk::PipelineCreationFeedbackFlagBitsEXT::eApplicationPipelineCacheHit) {
+		hitCount++;
+	} else {
+		missCount++;
+	}
+}
+
+
+bool PipelineCache::isDataCompatible(const std::vector<uint8_t>& data) {
+	// Header layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+	struct Header {
+		uint32_t headerSize;
+		uint32_t headerVersion;
+		uint32_t vendorId;
+		uint32_t deviceId;
+		uint8_t uuid[VK_UUID_SIZE];
+	};
+
+	if (data.size() < sizeof(Header)) {
+		return false;
+	}
+
+	Header header {};
+	memcpy(&header, data.data(), sizeof(Header));
+
+	return header.headerSize >= sizeof(Header) && header.headerSize <= data.size() &&
+		   header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		   header.vendorId == vkPhysicalDeviceProperties.vendorID &&
+		   header.deviceId == vkPhysicalDeviceProperties.deviceID &&
+		   memcmp(header.uuid, vkPhysicalDeviceProperties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+} // namespace Engine
\ No newline at end of file
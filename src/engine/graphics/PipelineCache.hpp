@@ -0,0 +1,95 @@
+#pragma once
+
+#include "engine/managers/ConfigManager.hpp"
+
+#define VULKAN_HPP_NO_EXCEPTIONS 1
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+namespace Engine {
+// Vulkan pipeline cache shared by all renderers and persisted between runs. Stored data is discarded if its header
+// does not match current device. Cache hits are tracked with pipeline creation feedback when it is supported.
+class PipelineCache {
+public:
+	static constexpr const char* FILENAME = "cache/pipelines.bin";
+
+
+private:
+	static vk::Device vkDevice;
+	static vk::PipelineCache vkPipelineCache;
+
+	static vk::PhysicalDeviceProperties vkPhysicalDeviceProperties;
+
+	static bool isCreationFeedbackSupported;
+
+	static std::atomic<uint> createdCount;
+	static std::atomic<uint> hitCount;
+	static std::atomic<uint> missCount;
+
+	// Pipelines created since cache was last saved
+	static std::atomic<uint> unsavedCount;
+	static std::chrono::steady_clock::time_point lastSaveTime;
+
+	struct Properties {
+		PROPERTY(bool, "Graphics", pipelineCacheEnabled, true);
+
+		// Seconds between saves while new pipelines are being created
+		PROPERTY(uint, "Graphics", pipelineCacheSaveInterval, 30);
+	};
+
+	static Properties properties;
+
+
+public:
+	// Creates pipeline cache with initial data loaded from disk. Creation feedback has to be enabled on the device if
+	// it is reported as supported.
+	static int init(vk::PhysicalDevice physicalDevice, vk::Device device, bool creationFeedbackSupported);
+
+	// Saves cache periodically if new pipelines were created. Has to be called once per frame.
+	static void update();
+
+	static int save();
+
+	// Saves cache and destroys it
+	static void dispose();
+
+
+	// Tells whether creation feedback can be chained into pipeline create infos
+	static inline bool useCreationFeedback() {
+		return isCreationFeedbackSupported;
+	}
+
+	// Updates statistics with feedback of a created pipeline, feedback is ignored if it is not supported
+	static void recordPipelineCreation(const vk::PipelineCreationFeedbackEXT& feedback);
+
+
+	static inline vk::PipelineCache getVkPipelineCache() {
+		return vkPipelineCache;
+	}
+
+	static inline uint getCreatedCount() {
+		return createdCount;
+	}
+
+	static inline uint getHitCount() {
+		return hitCount;
+	}
+
+	static inline uint getMissCount() {
+		return missCount;
+	}
+
+
+private:
+	PipelineCache() {
+	}
+
+	// Checks that cache data was created by the same device and driver
+	static bool isDataCompatible(const std::vector<uint8_t>& data);
+};
+} // namespace Engine
\ No newline at end of file
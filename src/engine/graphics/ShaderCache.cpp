@@ -0,0 +1,101 @@
+#include "ShaderCache.hpp"
+
+#include "engine/utils/IO.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+
+namespace Engine {
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+
+ShaderCache::Properties ShaderCache::properties {};
+
+
+int ShaderCache::init() {
+	if (!isEnabled()) {
+		return 0;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(DIRECTORY, errorCode);
+	if (errorCode) {
+		spdlog::error("[ShaderCache] Failed to create directory '{}': {}", DIRECTORY, errorCode.message());
+		return 1;
+	}
+
+	return 0;
+}
+
+
+uint64_t ShaderCache::hash(const void* pData, uint64_t size, uint64_t seed) {
+	const auto* pBytes = static_cast<const uint8_t*>(pData);
+
+	uint64_t result = seed;
+	for (uint64_t i = 0; i < size; i++) {
+		result ^= pBytes[i];
+		result *= 0x100000001b3;
+	}
+
+	return result;
+}
+
+
+int ShaderCache::load(uint64_t key, std::vector<uint32_t>& spirv) {
+	if (!isEnabled()) {
+		return 1;
+	}
+
+	std::vector<uint8_t> buffer;
+	if (readFile(getEntryFilename(key), buffer)) {
+		return 1;
+	}
+
+	if (buffer.size() < sizeof(uint32_t) || buffer.size() % sizeof(uint32_t) != 0 ||
+		*reinterpret_cast<const uint32_t*>(buffer.data()) != SPIRV_MAGIC) {
+		spdlog::warn("[ShaderCache] Entry '{}' is invalid, ignoring", getEntryFilename(key));
+		return 1;
+	}
+
+	spirv.resize(buffer.size() / sizeof(uint32_t));
+	memcpy(spirv.data(), buffer.data(), buffer.size());
+
+	return 0;
+}
+
+int ShaderCache::store(uint64_t key, const uint32_t* pSpirv, uint64_t wordCount) {
+	if (!isEnabled()) {
+		return 0;
+	}
+
+	// Entry is written under unique name and renamed so that readers never see partially written files
+	const auto filename		= getEntryFilename(key);
+	const auto threadId		= std::hash<std::thread::id> {}(std::this_thread::get_id());
+	const auto tempFilename = fmt::format("{}.{:x}.tmp", filename, threadId);
+
+	if (writeFile(tempFilename, pSpirv, wordCount * sizeof(uint32_t))) {
+		spdlog::error("[ShaderCache] Failed to write '{}'", tempFilename);
+		return 1;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempFilename, filename, errorCode);
+	if (errorCode) {
+		spdlog::error("[ShaderCache] Failed to rename '{}' to '{}': {}", tempFilename, filename, errorCode.message());
+		std::filesystem::remove(tempFilename, errorCode);
+		return 1;
+	}
+
+	return 0;
+}
+
+
+std::string ShaderCache::getEntryFilename(uint64_t key) {
+	return fmt::format("{}/{:016x}.spv", DIRECTORY, key);
+}
+} // namespace Engine
\ No newline at end of file
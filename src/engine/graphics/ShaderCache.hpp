@@ -0,0 +1,57 @@
+#pragma once
+
+#include "engine/managers/ConfigManager.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace Engine {
+// Content addressed on-disk cache of compiled SPIR-V. Key is a hash of fully preprocessed source, macro definitions,
+// shader stage and compiler options, so an entry is never stale and only changed variants are recompiled. Entries
+// are stored as separate files named by key, writes go through a temporary file and are safe to do concurrently.
+class ShaderCache {
+public:
+	static constexpr uint64_t HASH_SEED = 0xcbf29ce484222325;
+
+	static constexpr const char* DIRECTORY = "cache/shaders";
+
+
+private:
+	struct Properties {
+		PROPERTY(bool, "Graphics", shaderCacheEnabled, true);
+	};
+
+	static Properties properties;
+
+
+public:
+	static int init();
+
+	// 64 bit FNV-1a, seed allows to chain several pieces of data into one key
+	static uint64_t hash(const void* pData, uint64_t size, uint64_t seed = HASH_SEED);
+
+	static inline uint64_t hash(const std::string& string, uint64_t seed = HASH_SEED) {
+		// Terminator is hashed too so that concatenations of different strings do not collide
+		return hash(string.c_str(), string.size() + 1, seed);
+	}
+
+	// Returns 0 and fills SPIR-V words on hit, 1 on miss or if stored entry is invalid
+	static int load(uint64_t key, std::vector<uint32_t>& spirv);
+
+	static int store(uint64_t key, const uint32_t* pSpirv, uint64_t wordCount);
+
+
+	static inline bool isEnabled() {
+		return properties.shaderCacheEnabled;
+	}
+
+
+private:
+	ShaderCache() {
+	}
+
+	static std::string getEntryFilename(uint64_t key);
+};
+} // namespace Engine
\ No newline at end of file
@@ -2,17 +2,21 @@
 
 #include <spdlog/spdlog.h>
 
+#include <cassert>
+#include <cstring>
+
 
 namespace Engine {
-int StagingBuffer::init(vk::Device device, VmaAllocator allocator, vk::DeviceSize size) {
-	vkDevice	 = device;
+int StagingBuffer::init(VmaAllocator allocator, vk::DeviceSize size) {
 	vmaAllocator = allocator;
 	vkBufferSize = size;
 
-	assert(vkDevice != vk::Device());
 	assert(vmaAllocator != nullptr);
 	assert(vkBufferSize > 0);
 
+	head = 0;
+	tail = 0;
+
 	vk::BufferCreateInfo bufferCreateInfo {};
 	bufferCreateInfo.usage = vk::BufferUsageFlagBits::eTransferSrc;
 	bufferCreateInfo.size  = vkBufferSize;
@@ -21,113 +25,52 @@ int StagingBuffer::init(vk::Device device, VmaAllocator allocator, vk::DeviceSiz
 
 	VmaAllocationCreateInfo allocationCreateInfo {};
 	allocationCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+	allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
 	VkBuffer buffer;
-	auto result = vk::Result(
-		vmaCreateBuffer(vmaAllocator, &cBufferCreateInfo, &allocationCreateInfo, &buffer, &vmaAllocation, nullptr));
+	VmaAllocationInfo allocationInfo {};
+	auto result = vk::Result(vmaCreateBuffer(vmaAllocator, &cBufferCreateInfo, &allocationCreateInfo, &buffer,
+											 &vmaAllocation, &allocationInfo));
 	if (result != vk::Result::eSuccess) {
 		spdlog::error("Failed to allocate buffer memory. Error code: {} ({})", result, vk::to_string(result));
 		return 1;
 	}
 
-	vkBuffer = vk::Buffer(buffer);
+	vkBuffer	= vk::Buffer(buffer);
+	pMappedData = static_cast<uint8_t*>(allocationInfo.pMappedData);
 
 	return 0;
 }
 
-int StagingBuffer::update(void* pData, uint64_t size) {
-	assert(size <= vkBufferSize);
-
-	void* pBufferData;
-	auto result = vk::Result(vmaMapMemory(vmaAllocator, vmaAllocation, &pBufferData));
-	if (result != vk::Result::eSuccess) {
-		spdlog::error("Failed to write buffer memory. Error code: {} ({})", result, vk::to_string(result));
-		return 1;
-	}
 
-	memcpy(pBufferData, pData, size);
-	vmaUnmapMemory(vmaAllocator, vmaAllocation);
-	return 0;
-}
+int StagingBuffer::allocate(uint64_t size, uint64_t alignment, vk::DeviceSize& offset) {
+	assert(vkBufferSize % alignment == 0);
 
+	uint64_t position = (head + alignment - 1) / alignment * alignment;
 
-int StagingBuffer::transfer(vk::Queue transferQueue, vk::CommandPool commandPool, vk::Buffer dstBuffer,
-							vk::DeviceSize size) {
-	vk::CommandBuffer commandBuffer;
-	if (beginCommandBuffer(commandPool, commandBuffer)) {
-		return 1;
+	// Allocation is moved to the beginning of buffer rather than split
+	if (position % vkBufferSize + size > vkBufferSize) {
+		position = (position / vkBufferSize + 1) * vkBufferSize;
 	}
 
-	vk::BufferCopy bufferCopy {};
-	bufferCopy.size = vkBufferSize;
-	commandBuffer.copyBuffer(vkBuffer, dstBuffer, 1, &bufferCopy);
-
-	if (endCommandBuffer(transferQueue, commandPool, commandBuffer)) {
+	if (position + size - tail > vkBufferSize) {
 		return 1;
 	}
 
+	head   = position + size;
+	offset = position % vkBufferSize;
+
 	return 0;
 }
 
-int StagingBuffer::transfer(vk::Queue transferQueue, vk::CommandPool commandPool, vk::Image dstImage,
-							vk::Extent3D size) {
-	vk::CommandBuffer commandBuffer;
-	if (beginCommandBuffer(commandPool, commandBuffer)) {
-		return 1;
-	}
-
-
-	vk::ImageMemoryBarrier imageMemoryBarrierBefore {};
-	imageMemoryBarrierBefore.oldLayout					   = vk::ImageLayout::eUndefined;
-	imageMemoryBarrierBefore.newLayout					   = vk::ImageLayout::eTransferDstOptimal;
-	imageMemoryBarrierBefore.srcAccessMask				   = {};
-	imageMemoryBarrierBefore.dstAccessMask				   = vk::AccessFlagBits::eTransferWrite;
-	imageMemoryBarrierBefore.image						   = dstImage;
-	imageMemoryBarrierBefore.subresourceRange.aspectMask   = vk::ImageAspectFlagBits::eColor;
-	imageMemoryBarrierBefore.subresourceRange.baseMipLevel = 0;
-	imageMemoryBarrierBefore.subresourceRange.levelCount   = 1;
-	imageMemoryBarrierBefore.subresourceRange.layerCount   = 1;
+void StagingBuffer::write(vk::DeviceSize offset, const void* pData, uint64_t size) {
+	assert(offset + size <= vkBufferSize);
 
-	vk::ImageMemoryBarrier imageMemoryBarrierAfter {};
-	imageMemoryBarrierAfter.oldLayout					  = vk::ImageLayout::eTransferDstOptimal;
-	imageMemoryBarrierAfter.newLayout					  = vk::ImageLayout::eTransferSrcOptimal;
-	imageMemoryBarrierAfter.srcAccessMask				  = vk::AccessFlagBits::eTransferWrite;
-	imageMemoryBarrierAfter.dstAccessMask				  = vk::AccessFlagBits::eTransferRead;
-	imageMemoryBarrierAfter.image						  = dstImage;
-	imageMemoryBarrierAfter.subresourceRange.aspectMask	  = vk::ImageAspectFlagBits::eColor;
-	imageMemoryBarrierAfter.subresourceRange.baseMipLevel = 0;
-	imageMemoryBarrierAfter.subresourceRange.levelCount	  = 1;
-	imageMemoryBarrierAfter.subresourceRange.layerCount	  = 1;
-
-
-	vk::BufferImageCopy region {};
-	region.bufferOffset		 = 0;
-	region.bufferRowLength	 = 0;
-	region.bufferImageHeight = 0;
-
-	region.imageSubresource.aspectMask	   = vk::ImageAspectFlagBits::eColor;
-	region.imageSubresource.mipLevel	   = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount	   = 1;
-
-	region.imageOffset = vk::Offset3D(0, 0, 0);
-	region.imageExtent = size;
-
-
-	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, 0,
-								  nullptr, 0, nullptr, 1, &imageMemoryBarrierBefore);
-
-	commandBuffer.copyBufferToImage(vkBuffer, dstImage, vk::ImageLayout::eTransferDstOptimal, 1, &region);
-
-	// commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {},
-	// 							  0, nullptr, 0, nullptr, 1, &imageMemoryBarrierAfter);
-
-
-	if (endCommandBuffer(transferQueue, commandPool, commandBuffer)) {
-		return 1;
-	}
+	memcpy(pMappedData + offset, pData, size);
+}
 
-	return 0;
+void StagingBuffer::flush() {
+	vmaFlushAllocation(vmaAllocator, vmaAllocation, 0, VK_WHOLE_SIZE);
 }
 
 
@@ -136,59 +79,7 @@ void StagingBuffer::dispose() {
 		vmaDestroyBuffer(vmaAllocator, vkBuffer, vmaAllocation);
 		vmaAllocation = nullptr;
 	}
-}
-
-
-int StagingBuffer::beginCommandBuffer(vk::CommandPool commandPool, vk::CommandBuffer& commandBuffer) {
-	vk::CommandBufferAllocateInfo commandBufferAllocateInfo {};
-	commandBufferAllocateInfo.level				 = vk::CommandBufferLevel::ePrimary;
-	commandBufferAllocateInfo.commandPool		 = commandPool;
-	commandBufferAllocateInfo.commandBufferCount = 1;
-
-	auto result = vkDevice.allocateCommandBuffers(&commandBufferAllocateInfo, &commandBuffer);
-	if (result != vk::Result::eSuccess) {
-		spdlog::error("Failed to allocate staging command buffer. Error code: {} ({})", result, vk::to_string(result));
-		return 1;
-	}
-
-	vk::CommandBufferBeginInfo commandBufferBeginInfo {};
-	commandBufferBeginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-
-	result = commandBuffer.begin(&commandBufferBeginInfo);
-	if (result != vk::Result::eSuccess) {
-		spdlog::error("Failed to record staging command buffer. Error code: {} ({})", result, vk::to_string(result));
-		return 1;
-	}
-
-	return 0;
-}
 
-int StagingBuffer::endCommandBuffer(vk::Queue transferQueue, vk::CommandPool commandPool,
-									vk::CommandBuffer& commandBuffer) {
-	auto result = commandBuffer.end();
-	if (result != vk::Result::eSuccess) {
-		spdlog::error("Failed to record staging command buffer. Error code: {} ({})", result, vk::to_string(result));
-		return 1;
-	}
-
-	vk::SubmitInfo submitInfo {};
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers	  = &commandBuffer;
-
-	result = transferQueue.submit(1, &submitInfo, nullptr);
-	if (result != vk::Result::eSuccess) {
-		spdlog::error("Failed to submit staging buffer. Error code: {} ({})", result, vk::to_string(result));
-		return 1;
-	}
-
-	result = transferQueue.waitIdle();
-	if (result != vk::Result::eSuccess) {
-		spdlog::error("Failed to wait for staging command buffer to complete. Error code: {} ({})", result,
-					  vk::to_string(result));
-		return 1;
-	}
-
-	vkDevice.freeCommandBuffers(commandPool, 1, &commandBuffer);
-	return 0;
+	pMappedData = nullptr;
 }
 } // namespace Engine
\ No newline at end of file
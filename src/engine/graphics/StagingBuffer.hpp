@@ -5,35 +5,59 @@
 
 #include "vk_mem_alloc.h"
 
+#include <cassert>
+#include <cstdint>
+
 
 namespace Engine {
+// Persistently mapped ring of host visible memory. Space is allocated at head and released up to a position
+// previously returned by getHead once GPU is done reading it. Positions grow monotonically, buffer offsets are
+// positions wrapped around buffer size.
 class StagingBuffer {
 private:
-	vk::Device vkDevice {};
 	VmaAllocator vmaAllocator {};
 
 	vk::Buffer vkBuffer {};
 	VmaAllocation vmaAllocation {};
 
+	uint8_t* pMappedData {};
+
 	vk::DeviceSize vkBufferSize {};
 
+	uint64_t head {};
+	uint64_t tail {};
+
 
 public:
-	[[nodiscard]] int init(vk::Device device, VmaAllocator allocator, vk::DeviceSize size);
-	[[nodiscard]] int update(void* pData, uint64_t size);
+	[[nodiscard]] int init(VmaAllocator allocator, vk::DeviceSize size);
+
+	// Fails if there is not enough free space until some of it is released. Allocations never wrap around the end of
+	// buffer, alignment has to divide buffer size.
+	[[nodiscard]] int allocate(uint64_t size, uint64_t alignment, vk::DeviceSize& offset);
 
-	[[nodiscard]] int transfer(vk::Queue transferQueue, vk::CommandPool commandPool, vk::Buffer dstBuffer,
-							   vk::DeviceSize size);
+	void write(vk::DeviceSize offset, const void* pData, uint64_t size);
 
-	[[nodiscard]] int transfer(vk::Queue transferQueue, vk::CommandPool commandPool, vk::Image dstImage,
-							   vk::Extent3D size);
+	// Makes written data visible to device if memory is not host coherent
+	void flush();
+
+	inline void release(uint64_t position) {
+		assert(position >= tail && position <= head);
+		tail = position;
+	}
 
 	void dispose();
 
 
-private:
-	[[nodiscard]] int beginCommandBuffer(vk::CommandPool commandPool, vk::CommandBuffer& commandBuffer);
-	[[nodiscard]] int endCommandBuffer(vk::Queue transferQueue, vk::CommandPool commandPool,
-									   vk::CommandBuffer& commandBuffer);
+	inline uint64_t getHead() const {
+		return head;
+	}
+
+	inline vk::Buffer getVkBuffer() const {
+		return vkBuffer;
+	}
+
+	inline vk::DeviceSize getSize() const {
+		return vkBufferSize;
+	}
 };
 } // namespace Engine
\ No newline at end of file
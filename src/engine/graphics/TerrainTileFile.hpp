@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace Engine {
+// Layout of cooked terrain files:
+// - Header
+// - LevelHeader for each level, finest first, each next level halves resolution
+// - Tiles of every level in row major order, each tile is heights (R16 unorm) followed by normals (RGBA8 unorm)
+// - Serialized min/max height pyramid
+class TerrainTileFile {
+public:
+	static constexpr uint32_t MAGIC	  = 0x4e525254; // "TRRN"
+	static constexpr uint32_t VERSION = 1;
+
+	static constexpr uint32_t TILE_SIZE		  = 128;
+	static constexpr uint32_t MAX_LEVEL_COUNT = 16;
+
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+
+		// Level 0 size in texels
+		uint32_t width;
+		uint32_t height;
+
+		uint32_t tileSize;
+		uint32_t levelCount;
+
+		// World size of level 0 texel and height of max normalized value
+		float texelSize;
+		float maxHeight;
+
+		uint64_t pyramidOffset;
+		uint64_t pyramidSize;
+	};
+
+	struct LevelHeader {
+		uint32_t width;
+		uint32_t height;
+
+		uint32_t tileCountX;
+		uint32_t tileCountY;
+
+		uint64_t offset;
+	};
+
+
+	static constexpr uint64_t getTileHeightsSize() {
+		return TILE_SIZE * TILE_SIZE * sizeof(uint16_t);
+	}
+
+	static constexpr uint64_t getTileNormalsSize() {
+		return TILE_SIZE * TILE_SIZE * 4;
+	}
+
+	static constexpr uint64_t getTileSize() {
+		return getTileHeightsSize() + getTileNormalsSize();
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "MeshBase.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <array>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace Engine {
+// Static mesh with 20 byte vertices instead of 56. Position is quantized relative to mesh bounds with w holding tangent
+// frame handedness, texture coordinates are half floats, normal and tangent are octahedral encoded.
+class CompressedStaticMesh : public MeshBase<CompressedStaticMesh> {
+public:
+	VERTEX_LAYOUT(glm::u16vec4, glm::u16vec2, glm::i16vec2, glm::i16vec2);
+	VERTEX_FORMATS(vk::Format::eR16G16B16A16Unorm, vk::Format::eR16G16Sfloat, vk::Format::eR16G16Snorm,
+				   vk::Format::eR16G16Snorm);
+
+public:
+	static const std::string getMeshTypeString() {
+		return "MESH_TYPE_STATIC_COMPRESSED";
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "engine/graphics/BoundingBox.hpp"
 #include "engine/graphics/BoundingSphere.hpp"
+#include "engine/graphics/Meshlet.hpp"
 
 #define VULKAN_HPP_NO_EXCEPTIONS 1
 #include <vulkan/vulkan.hpp>
@@ -10,7 +11,9 @@
 
 #include <glm/glm.hpp>
 
+#include <cstring>
 #include <map>
+#include <tuple>
 #include <typeindex>
 #include <vector>
 
@@ -26,6 +29,16 @@
 
 
 namespace Engine {
+// Vertex tuple without position, the rest of attributes are stored in a separate stream
+template <typename Vertex>
+struct VertexAttributes;
+
+template <typename Position, typename... Attributes>
+struct VertexAttributes<std::tuple<Position, Attributes...>> {
+	using Type = std::tuple<Attributes...>;
+};
+
+
 template <typename MeshType>
 class MeshBase {
 public:
@@ -34,6 +47,12 @@ public:
 	BoundingSphere boundingSphere {};
 	BoundingBox boundingBox {};
 
+	// Optional, index buffer has to be ordered by meshlets if present
+	std::vector<Meshlet> meshlets {};
+
+	// Maps quantized vertex positions back to object space: position = xyz + quantized * w
+	glm::vec4 positionDequantization { 0.0f, 0.0f, 0.0f, 1.0f };
+
 
 public:
 	virtual inline bool usesTessellation() {
@@ -57,27 +76,61 @@ public:
 		return getIndexBuffer().size() * sizeof(uint32_t);
 	}
 
-	static constexpr auto getVertexSize() {
-		return sizeof(typename MeshType::Vertex);
+	// Size of a vertex summed over all streams
+	static constexpr uint32_t getVertexSize() {
+		return getVertexStreamStride(0) + getVertexStreamStride(1);
+	}
+
+	// Vertices are uploaded as a position stream followed by an attribute stream if mesh has more than one attribute.
+	// Depth only passes fetch position stream alone.
+	static constexpr uint32_t getVertexStreamCount() {
+		return getNumAttributes() > 1 ? 2 : 1;
+	}
+
+	static constexpr uint32_t getVertexStreamStride(uint32_t streamIndex) {
+		if (streamIndex == 0) {
+			return sizeof(std::tuple_element_t<0, typename MeshType::Vertex>);
+		}
+
+		if constexpr (getNumAttributes() > 1) {
+			if (streamIndex == 1) {
+				return sizeof(typename VertexAttributes<typename MeshType::Vertex>::Type);
+			}
+		}
+
+		return 0;
 	}
 
 	static constexpr auto getNumAttributes() {
 		return std::tuple_size<typename MeshType::Vertex>::value;
 	}
 
+	// Offset within attribute's stream, position is the only attribute of the first one
 	template <uint Index>
 	static constexpr auto getAttributeOffset() {
-		typename MeshType::Vertex vertex;
-		return static_cast<uint32_t>(reinterpret_cast<char*>(&std::get<Index>(vertex)) -
-									 reinterpret_cast<char*>(&vertex));
+		if constexpr (Index == 0) {
+			return static_cast<uint32_t>(0);
+		} else {
+			typename VertexAttributes<typename MeshType::Vertex>::Type attributes;
+			return static_cast<uint32_t>(reinterpret_cast<char*>(&std::get<Index - 1>(attributes)) -
+										 reinterpret_cast<char*>(&attributes));
+		}
+	}
+
+	// Deinterleaves vertex buffer into per stream data ready for upload
+	inline std::vector<std::vector<uint8_t>> getVertexStreams() {
+		return getVertexStreamsImpl(std::make_index_sequence<getNumAttributes() - 1>());
 	}
 
 	// TODO: should MeshManager be responsible for populating vulkan related structures?
 	static constexpr auto getVertexInputBindingDescriptions() {
-		std::vector<vk::VertexInputBindingDescription> vertexInputBindingDescriptions(1);
-		vertexInputBindingDescriptions[0].binding	= 0;
-		vertexInputBindingDescriptions[0].stride	= getVertexSize();
-		vertexInputBindingDescriptions[0].inputRate = vk::VertexInputRate::eVertex;
+		std::vector<vk::VertexInputBindingDescription> vertexInputBindingDescriptions(getVertexStreamCount());
+
+		for (uint32_t streamIndex = 0; streamIndex < getVertexStreamCount(); streamIndex++) {
+			vertexInputBindingDescriptions[streamIndex].binding	  = streamIndex;
+			vertexInputBindingDescriptions[streamIndex].stride	  = getVertexStreamStride(streamIndex);
+			vertexInputBindingDescriptions[streamIndex].inputRate = vk::VertexInputRate::eVertex;
+		}
 
 		return vertexInputBindingDescriptions;
 	}
@@ -94,14 +147,36 @@ private:
 
 		static_assert(MeshType::getAttributeFormats().size() == getNumAttributes());
 
-		typename MeshType::Vertex vertex;
-
-		((vertexInputAttributeDescriptions[Indices].binding = 0), ...);
+		((vertexInputAttributeDescriptions[Indices].binding = Indices == 0 ? 0 : 1), ...);
 		((vertexInputAttributeDescriptions[Indices].location = Indices), ...);
 		((vertexInputAttributeDescriptions[Indices].format = MeshType::getAttributeFormats()[Indices]), ...);
 		((vertexInputAttributeDescriptions[Indices].offset = getAttributeOffset<Indices>()), ...);
 
 		return vertexInputAttributeDescriptions;
 	}
+
+	template <std::size_t... Indices>
+	inline std::vector<std::vector<uint8_t>> getVertexStreamsImpl(std::index_sequence<Indices...>) {
+		using Attributes = typename VertexAttributes<typename MeshType::Vertex>::Type;
+
+		const auto& vertexBuffer = getVertexBuffer();
+
+		std::vector<std::vector<uint8_t>> vertexStreams(getVertexStreamCount());
+		for (uint32_t streamIndex = 0; streamIndex < getVertexStreamCount(); streamIndex++) {
+			vertexStreams[streamIndex].resize(vertexBuffer.size() * getVertexStreamStride(streamIndex));
+		}
+
+		for (uint32_t i = 0; i < vertexBuffer.size(); i++) {
+			memcpy(&vertexStreams[0][i * getVertexStreamStride(0)], &std::get<0>(vertexBuffer[i]),
+				   getVertexStreamStride(0));
+
+			if constexpr (sizeof...(Indices) > 0) {
+				const Attributes attributes { std::get<Indices + 1>(vertexBuffer[i])... };
+				memcpy(&vertexStreams[1][i * getVertexStreamStride(1)], &attributes, getVertexStreamStride(1));
+			}
+		}
+
+		return vertexStreams;
+	}
 };
 } // namespace Engine
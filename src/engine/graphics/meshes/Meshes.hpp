@@ -1,4 +1,5 @@
 #pragma once
 
+#include "CompressedStaticMesh.hpp"
 #include "StaticMesh.hpp"
 #include "TerrainMesh.hpp"
\ No newline at end of file
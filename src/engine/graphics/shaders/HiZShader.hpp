@@ -0,0 +1,19 @@
+#pragma once
+
+#include "GraphicsShaderBase.hpp"
+
+#include <glm/glm.hpp>
+
+
+namespace Engine {
+class HiZShader : public GraphicsShaderBase<HiZShader> {
+public:
+	enum Flags {};
+
+
+public:
+	static constexpr const char* getFlagName(Flags flag) {
+		return "";
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BoxBlurShader.hpp"
+#include "HiZShader.hpp"
 #include "IrradianceShader.hpp"
 #include "PostFxShader.hpp"
 #include "ReflectionShader.hpp"
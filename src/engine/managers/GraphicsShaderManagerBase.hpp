@@ -1,9 +1,14 @@
 #pragma once
 
+#include "ConfigManager.hpp"
 #include "MaterialManager.hpp"
 #include "MeshManager.hpp"
 
+#include "engine/graphics/ShaderCache.hpp"
+
+#include "engine/utils/FileWatcher.hpp"
 #include "engine/utils/IO.hpp"
+#include "engine/utils/ThreadPool.hpp"
 
 #include <spdlog/spdlog.h>
 
@@ -12,8 +17,12 @@
 
 #include <shaderc/shaderc.hpp>
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
+#include <filesystem>
 #include <fstream>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -36,14 +45,62 @@ public:
 		}
 	};
 
+	enum class VariantState : uint8_t {
+		NONE,
+		PENDING,
+		READY,
+		FAILED,
+	};
+
 	struct ShaderInfo {
 		// TODO: access with enum
 		std::array<vk::ShaderModule, 6> shaderModules {};
+
+		// Variants are created on first use, modules are valid once ready
+		VariantState state {};
 	};
 
 
 private:
-	static std::tuple<std::vector<ShaderTypes>...> shaderObjectArrays;
+	static constexpr auto OPTIMIZATION_LEVEL = shaderc_optimization_level_performance;
+
+	// Preprocessed sources of a shader type, variants are compiled from them on demand
+	struct ShaderSourceInfo {
+		std::array<std::string, 6> filenames {};
+		std::array<std::string, 6> sources {};
+
+		// Hashes of sources and compiler configuration, cache keys of variants are derived from them
+		std::array<uint64_t, 6> sourceKeys {};
+
+		std::vector<const char*> flagNames {};
+
+		// Normalized paths of source files and every file included by them
+		std::vector<std::string> dependencies {};
+	};
+
+	// Single stage of a shader variant, compiled or loaded from cache by worker threads
+	struct CompileJob {
+		uint32_t renderPassIndex;
+		uint32_t shaderInfoIndex;
+		uint shaderStageIndex;
+
+		shaderc_shader_kind kind;
+
+		const std::string* pSource;
+		const char* pFilename;
+
+		std::vector<std::string> macroDefinitions;
+
+		uint64_t cacheKey;
+
+		bool isCached;
+		bool isFailed;
+
+		std::string errorMessage;
+		std::vector<uint32_t> spirvSource;
+	};
+
+	static std::array<ShaderSourceInfo, sizeof...(ShaderTypes)> shaderSourceInfos;
 
 	// Shader info arrays splitted by render pass
 	static std::vector<std::vector<ShaderInfo>> shaderInfoArrays;
@@ -51,42 +108,101 @@ private:
 	// Offsets within shaderInfos by ShaderType
 	static std::array<uint, sizeof...(ShaderTypes)> shaderInfoOffsets;
 
+	// Guards variant states, signaled whenever a pending variant is finished
+	static std::mutex variantMutex;
+	static std::condition_variable variantCondition;
+
+	// Shader info indices in order of first handle request, renderers create pipelines only for these
+	static std::mutex requestMutex;
+	static std::vector<uint32_t> requestedIndices;
+	static std::vector<bool> requestedFlags;
+
+	// Requested shader info indices whose variants were recreated after sources changed, guarded by requestMutex
+	static std::vector<uint32_t> invalidatedIndices;
+
+	// Modules of invalidated variants. Pipelines being created may still reference them, so they are kept until
+	// manager is disposed.
+	static std::vector<vk::ShaderModule> retiredShaderModules;
+
+	static FileWatcher fileWatcher;
+
 	static vk::Device vkDevice;
 
+	struct Properties {
+		// Compiles every variant at import instead of on first use, useful to fill shader cache
+		PROPERTY(bool, "Graphics", precompileShaderVariants, false);
+
+		// Recompiles affected variants when shader sources or their includes are modified
+		PROPERTY(bool, "Graphics", shaderHotReload, true);
+	};
+
+	static Properties properties;
+
 
 public:
 	static int init() {
 		assert(vkDevice != vk::Device());
 
+		if (ShaderCache::init()) {
+			return 1;
+		}
+
 		const auto rendererTypeCount = GraphicsShaderManagerBase::getRenderPassStringCount();
 		const auto meshTypeCount	 = MeshManager::getTypeCount();
 
-		// Resize shader object arrays to fit all of their variations
-		(std::get<std::vector<ShaderTypes>>(shaderObjectArrays)
-			 .resize(pow(2, ShaderTypes::getFlagCount()) * meshTypeCount * rendererTypeCount),
-		 ...);
-
-
 		shaderInfoOffsets[0] = 0;
 		for (uint shaderTypeIndex = 1; shaderTypeIndex < getTypeCount(); shaderTypeIndex++) {
 			shaderInfoOffsets[shaderTypeIndex] =
 				shaderInfoOffsets[shaderTypeIndex - 1] + meshTypeCount * getShaderSignatureCount(shaderTypeIndex - 1);
 		}
 
-		const auto lastShaderTypeIndex = getTypeCount() - 1;
 		shaderInfoArrays.resize(rendererTypeCount);
 		for (auto& shaderInfos : shaderInfoArrays) {
-			shaderInfos.resize(shaderInfoOffsets[lastShaderTypeIndex] +
-							   meshTypeCount * getShaderSignatureCount(lastShaderTypeIndex));
+			shaderInfos.resize(getShaderInfoCount());
+		}
+
+		requestedFlags.resize(getShaderInfoCount());
+
+		// Engine works without hot reload, so failing to watch files is not fatal
+		if (properties.shaderHotReload && fileWatcher.init()) {
+			spdlog::warn("Shader hot reload is disabled");
 		}
 
 		return 0;
 	}
 
+	static void dispose() {
+		for (auto& shaderModule : retiredShaderModules) {
+			vkDevice.destroyShaderModule(shaderModule);
+		}
+		retiredShaderModules.clear();
 
+		for (auto& shaderInfos : shaderInfoArrays) {
+			for (auto& shaderInfo : shaderInfos) {
+				for (auto& shaderModule : shaderInfo.shaderModules) {
+					if (shaderModule != vk::ShaderModule()) {
+						vkDevice.destroyShaderModule(shaderModule);
+						shaderModule = vk::ShaderModule();
+					}
+				}
+				shaderInfo.state = VariantState::NONE;
+			}
+		}
+
+		fileWatcher.close();
+	}
+
+
+	// Returns handle of a variant and marks it as used, so that renderers create pipelines for it
 	static Handle getHandle(uint meshTypeIndex, uint shaderTypeIndex, uint signature) {
 		uint32_t index = getShaderInfoIndex(shaderTypeIndex, meshTypeIndex, signature);
 
+		std::unique_lock lock(requestMutex);
+		if (!requestedFlags[index]) {
+			requestedFlags[index] = true;
+			requestedIndices.push_back(index);
+		}
+
 		return Handle(index);
 	}
 
@@ -124,13 +240,84 @@ public:
 	}
 
 
+	static uint getRequestedCount() {
+		std::unique_lock lock(requestMutex);
+		return requestedIndices.size();
+	}
+
+	// Returns shader info indices requested since given number of them was already processed
+	static std::vector<uint32_t> getRequestedIndices(uint processedCount) {
+		std::unique_lock lock(requestMutex);
+
+		if (processedCount >= requestedIndices.size()) {
+			return std::vector<uint32_t>();
+		}
+
+		return std::vector<uint32_t>(requestedIndices.begin() + processedCount, requestedIndices.end());
+	}
+
+	static uint getInvalidatedCount() {
+		std::unique_lock lock(requestMutex);
+		return invalidatedIndices.size();
+	}
+
+	// Returns requested shader info indices whose variants have to be recreated, since given number of them was
+	// already processed. Pipelines of these have to be rebuilt.
+	static std::vector<uint32_t> getInvalidatedIndices(uint processedCount) {
+		std::unique_lock lock(requestMutex);
+
+		if (processedCount >= invalidatedIndices.size()) {
+			return std::vector<uint32_t>();
+		}
+
+		return std::vector<uint32_t>(invalidatedIndices.begin() + processedCount, invalidatedIndices.end());
+	}
+
+	// Returns index of variant with no flags set of the same shader and mesh types. It is the cheapest one to create
+	// and is used in place of other variants until they are ready.
+	static uint32_t getFallbackIndex(uint32_t shaderInfoIndex) {
+		uint32_t shaderTypeIndex = 0;
+		uint32_t meshTypeIndex	 = 0;
+		uint32_t signature		 = 0;
+		getVariant(shaderInfoIndex, shaderTypeIndex, meshTypeIndex, signature);
+
+		return getShaderInfoIndex(shaderTypeIndex, meshTypeIndex, 0);
+	}
+
+
+	// Converts shader info index back to shader type, mesh type and signature
+	static void getVariant(uint32_t shaderInfoIndex, uint32_t& shaderTypeIndex, uint32_t& meshTypeIndex,
+						   uint32_t& signature) {
+		shaderTypeIndex = 0;
+		while (shaderTypeIndex + 1 < getTypeCount() && shaderInfoOffsets[shaderTypeIndex + 1] <= shaderInfoIndex) {
+			shaderTypeIndex++;
+		}
+
+		const auto signatureCount = getShaderSignatureCount(shaderTypeIndex);
+		const auto localIndex	  = shaderInfoIndex - shaderInfoOffsets[shaderTypeIndex];
+
+		meshTypeIndex = localIndex / signatureCount;
+		signature	  = localIndex % signatureCount;
+	}
+
+
 	static inline ShaderInfo& getShaderInfo(uint32_t renderPass, uint32_t shaderTypeIndex, uint32_t meshTypeIndex,
 											uint32_t signature) {
 		return shaderInfoArrays[renderPass][getShaderInfoIndex(shaderTypeIndex, meshTypeIndex, signature)];
 	}
 
+	static inline ShaderInfo& getShaderInfo(uint32_t renderPass, uint32_t shaderInfoIndex) {
+		return shaderInfoArrays[renderPass][shaderInfoIndex];
+	}
+
+	static inline uint32_t getShaderInfoCount() {
+		const auto lastShaderTypeIndex = getTypeCount() - 1;
+		return shaderInfoOffsets[lastShaderTypeIndex] +
+			   MeshManager::getTypeCount() * getShaderSignatureCount(lastShaderTypeIndex);
+	}
+
 
-	// Imports shader sources generating all variations
+	// Reads and preprocesses shader sources. Variants are compiled when first used, unless precompilation is enabled.
 	template <typename ShaderType>
 	static inline int importShaderSources(std::array<std::string, 6> glslSourceFilenames) {
 		std::string logMessage = "Importing shader(s): ";
@@ -153,147 +340,187 @@ public:
 
 		constexpr auto shaderFlagNames = ShaderType::getFlagNames();
 
-		shaderc::Compiler compiler;
+		ShaderSourceInfo sourceInfo {};
+		sourceInfo.filenames = glslSourceFilenames;
+		sourceInfo.flagNames = std::vector<const char*>(shaderFlagNames.begin(), shaderFlagNames.end());
 
-		std::array<std::string, 6> glslSources;
+		if (readShaderSources(sourceInfo)) {
+			return 1;
+		}
 
-		for (uint i = 0; i < 6; i++) {
-			if (!glslSourceFilenames[i].empty()) {
-				if (readTextFile(glslSourceFilenames[i], glslSources[i])) {
-					spdlog::error("Failed to open shader '{}' for compilation", glslSourceFilenames[i]);
-					return 1;
-				}
+		shaderSourceInfos[shaderTypeIndex] = std::move(sourceInfo);
 
-				std::string directoryName =
-					glslSourceFilenames[i].substr(0, glslSourceFilenames[i].find_last_of("\\/"));
+		watchDependencies(shaderSourceInfos[shaderTypeIndex]);
 
-				if (!directoryName.empty()) {
-					directoryName += "/";
-				}
+		if (properties.precompileShaderVariants) {
+			return precompileVariants(shaderTypeIndex);
+		}
 
-				// Preprocess #include directives
-				int position = 0;
-				while ((position = glslSources[i].find("#include", position)) != -1) {
-					auto includeLineLength = glslSources[i].find("\n", position) - position;
+		return 0;
+	}
 
-					auto filenamePosition = glslSources[i].find("\"", position);
-					auto filenameLength	  = glslSources[i].find("\"", filenamePosition + 1) - filenamePosition - 1;
 
-					if (position + includeLineLength < filenamePosition) {
-						spdlog::error("Failed preprocess shader '{}': include errors detected", glslSourceFilenames[i]);
-						return 1;
-					}
+	// Compiles variant for given render pass and creates its shader modules if it was not done yet. Thread safe,
+	// waits if the variant is being created by another thread.
+	static int createVariant(uint32_t renderPassIndex, uint32_t shaderInfoIndex) {
+		assert(vkDevice != vk::Device());
 
-					std::string filename = directoryName + glslSources[i].substr(filenamePosition + 1, filenameLength);
+		auto& shaderInfo = shaderInfoArrays[renderPassIndex][shaderInfoIndex];
 
-					std::string includeSource;
-					if (readTextFile(filename, includeSource)) {
-						spdlog::error("Failed preprocess shader '{}': cannot open '{}' to include",
-									  glslSourceFilenames[i], filename);
-						return 1;
-					}
+		{
+			std::unique_lock lock(variantMutex);
+			variantCondition.wait(lock, [&shaderInfo]() {
+				return shaderInfo.state != VariantState::PENDING;
+			});
 
-					glslSources[i].replace(position, includeLineLength, includeSource);
-				}
+			if (shaderInfo.state != VariantState::NONE) {
+				return shaderInfo.state == VariantState::READY ? 0 : 1;
 			}
+
+			shaderInfo.state = VariantState::PENDING;
 		}
 
+		std::vector<CompileJob> compileJobs {};
+		appendCompileJobs(renderPassIndex, shaderInfoIndex, compileJobs);
 
-		const std::array shaderStages = {
-			shaderc_glsl_vertex_shader,			 shaderc_glsl_geometry_shader, shaderc_glsl_tess_control_shader,
-			shaderc_glsl_tess_evaluation_shader, shaderc_glsl_fragment_shader, shaderc_glsl_compute_shader,
-		};
+		if (compileJobs.empty()) {
+			spdlog::error("Failed to create shader variant for '{}': sources were not imported",
+						  DerivedManager::getRenderPassStrings()[renderPassIndex]);
 
-		for (uint renderPassIndex = 0; renderPassIndex < getRenderPassStringCount(); renderPassIndex++) {
-			for (uint meshTypeIndex = 0; meshTypeIndex < MeshManager::getTypeCount(); meshTypeIndex++) {
-				bool useTessellation = MeshManager::getMeshTessellationUsage(meshTypeIndex);
+			finishVariant(shaderInfo, true);
+			return 1;
+		}
 
-				for (uint signature = 0; signature < ShaderType::getSignatureCount(); signature++) {
-					shaderc::CompileOptions options;
+		shaderc::Compiler compiler;
 
-					options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		bool isFailed = false;
+		for (auto& compileJob : compileJobs) {
+			compileVariant(compiler, compileJob);
 
-					options.AddMacroDefinition(DerivedManager::getRenderPassStrings()[renderPassIndex]);
-					options.AddMacroDefinition(MeshManager::getMeshTypeString(meshTypeIndex));
+			if (compileJob.isFailed) {
+				spdlog::error("Failed to compile shader '{}' for '{}'. Error message:\n{}", compileJob.pFilename,
+							  DerivedManager::getRenderPassStrings()[renderPassIndex], compileJob.errorMessage);
 
-					for (uint flagIndex = 0; flagIndex < ShaderType::getFlagCount(); flagIndex++) {
-						if ((1 << flagIndex) & signature) {
-							options.AddMacroDefinition(shaderFlagNames[flagIndex]);
-						}
-					}
+				isFailed = true;
+			}
+		}
 
-					uint32_t index = getShaderIndex<ShaderType>(renderPassIndex, meshTypeIndex, signature);
+		if (!isFailed && createShaderModules(compileJobs.data(), compileJobs.size(), shaderInfo)) {
+			isFailed = true;
+		}
 
-					for (uint shaderStageIndex = 0; shaderStageIndex < 6; shaderStageIndex++) {
-						if ((shaderStageIndex == 2 || shaderStageIndex == 3) && !useTessellation) {
-							continue;
-						}
-						if (!glslSources[shaderStageIndex].empty()) {
-							shaderc_shader_kind kind = shaderStages[shaderStageIndex];
+		finishVariant(shaderInfo, isFailed);
 
-							shaderc::SpvCompilationResult result =
-								compiler.CompileGlslToSpv(glslSources[shaderStageIndex], kind,
-														  glslSourceFilenames[shaderStageIndex].c_str(), options);
+		return isFailed ? 1 : 0;
+	}
 
-							if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
-								spdlog::error("Failed to compile shader '{}'. Error message:\n{}",
-											  glslSourceFilenames[shaderStageIndex], result.GetErrorMessage());
 
-								return 1;
-							}
+	// Reloads shader types depending on files modified since last call. Has to be called once per frame.
+	static int reloadChangedSources() {
+		if (!fileWatcher.isOpen()) {
+			return 0;
+		}
 
-							std::vector<uint32_t> spirvSource(result.cbegin(), result.cend());
+		std::vector<std::string> changedFilenames {};
+		fileWatcher.poll(changedFilenames);
 
-							std::get<shaderTypeIndex>(shaderObjectArrays)[index].setShaderSource(
-								shaderStageIndex, spirvSource.data(), spirvSource.size() * 4);
-						}
-					}
-				}
-			}
+		if (changedFilenames.empty()) {
+			return 0;
 		}
 
-		createShaderModules<ShaderType>();
+		for (auto& filename : changedFilenames) {
+			filename = std::filesystem::path(filename).lexically_normal().string();
+		}
 
-		return 0;
+		int result = 0;
+		for (uint shaderTypeIndex = 0; shaderTypeIndex < getTypeCount(); shaderTypeIndex++) {
+			const auto& dependencies = shaderSourceInfos[shaderTypeIndex].dependencies;
+
+			bool isAffected = std::any_of(dependencies.begin(), dependencies.end(), [&](const auto& dependency) {
+				return std::find(changedFilenames.begin(), changedFilenames.end(), dependency) !=
+					   changedFilenames.end();
+			});
+
+			if (isAffected && reloadShaderSources(shaderTypeIndex)) {
+				result = 1;
+			}
+		}
+
+		return result;
 	}
 
-	template <typename ShaderType>
-	static int createShaderModules() {
-		assert(vkDevice != vk::Device());
+	// Reads sources of a shader type again and resets its created variants, so that they are compiled from new
+	// sources on next use. Old sources are kept if new ones cannot be read.
+	static int reloadShaderSources(uint32_t shaderTypeIndex) {
+		ShaderSourceInfo sourceInfo {};
+		sourceInfo.filenames = shaderSourceInfos[shaderTypeIndex].filenames;
+		sourceInfo.flagNames = shaderSourceInfos[shaderTypeIndex].flagNames;
+
+		std::string logMessage = "Reloading shader(s): ";
+		for (const auto& filename : sourceInfo.filenames) {
+			if (!filename.empty()) {
+				logMessage += (logMessage.back() == ' ' ? "'" : ", '") + filename + "'";
+			}
+		}
+		spdlog::info(logMessage + "...");
 
-		constexpr auto shaderTypeIndex = getTypeIndex<ShaderType>();
+		if (readShaderSources(sourceInfo)) {
+			spdlog::error("Failed to reload shader, previous sources are kept");
+			return 1;
+		}
 
-		for (uint32_t renderPassIndex = 0; renderPassIndex < getRenderPassStringCount(); renderPassIndex++) {
-			for (uint32_t meshTypeIndex = 0; meshTypeIndex < MeshManager::getTypeCount(); meshTypeIndex++) {
-				for (uint32_t signature = 0; signature < ShaderType::getSignatureCount(); signature++) {
+		const auto firstShaderInfoIndex = shaderInfoOffsets[shaderTypeIndex];
+		const auto shaderInfoCount		= MeshManager::getTypeCount() * getShaderSignatureCount(shaderTypeIndex);
 
-					uint32_t index			 = getShaderIndex<ShaderType>(renderPassIndex, meshTypeIndex, signature);
-					uint32_t shaderInfoIndex = getShaderInfoIndex(shaderTypeIndex, meshTypeIndex, signature);
+		{
+			std::unique_lock lock(variantMutex);
 
-					for (uint shaderStageIndex = 0; shaderStageIndex < 6; shaderStageIndex++) {
-						auto shaderSource =
-							std::get<shaderTypeIndex>(shaderObjectArrays)[index].getShaderSource(shaderStageIndex);
+			// Variants being compiled reference current sources
+			variantCondition.wait(lock, [&]() {
+				for (const auto& shaderInfos : shaderInfoArrays) {
+					for (uint i = 0; i < shaderInfoCount; i++) {
+						if (shaderInfos[firstShaderInfoIndex + i].state == VariantState::PENDING) {
+							return false;
+						}
+					}
+				}
+				return true;
+			});
 
-						if (!shaderSource.empty()) {
-							vk::ShaderModuleCreateInfo shaderModuleCreateInfo {};
-							shaderModuleCreateInfo.codeSize = shaderSource.size();
-							shaderModuleCreateInfo.pCode	= reinterpret_cast<const uint32_t*>(shaderSource.data());
+			shaderSourceInfos[shaderTypeIndex] = std::move(sourceInfo);
 
-							auto result = vkDevice.createShaderModule(
-								&shaderModuleCreateInfo, nullptr,
-								&shaderInfoArrays[renderPassIndex][shaderInfoIndex].shaderModules[shaderStageIndex]);
+			for (auto& shaderInfos : shaderInfoArrays) {
+				for (uint i = 0; i < shaderInfoCount; i++) {
+					auto& shaderInfo = shaderInfos[firstShaderInfoIndex + i];
 
-							if (result != vk::Result::eSuccess) {
-								spdlog::error("[vulkan] Failed to create shader module. Error code: {} ({})", result,
-											  vk::to_string(result));
-								return 1;
-							}
+					for (auto& shaderModule : shaderInfo.shaderModules) {
+						if (shaderModule != vk::ShaderModule()) {
+							retiredShaderModules.push_back(shaderModule);
+							shaderModule = vk::ShaderModule();
 						}
 					}
+					shaderInfo.state = VariantState::NONE;
+				}
+			}
+		}
+
+		{
+			std::unique_lock lock(requestMutex);
+
+			for (uint i = 0; i < shaderInfoCount; i++) {
+				if (requestedFlags[firstShaderInfoIndex + i]) {
+					invalidatedIndices.push_back(firstShaderInfoIndex + i);
 				}
 			}
 		}
 
+		// Sources may include new files
+		watchDependencies(shaderSourceInfos[shaderTypeIndex]);
+
+		if (properties.precompileShaderVariants) {
+			return precompileVariants(shaderTypeIndex);
+		}
+
 		return 0;
 	}
 
@@ -362,10 +589,317 @@ protected:
 
 
 private:
-	template <typename ShaderType>
-	static inline uint32_t getShaderIndex(uint32_t renderPassIndex, uint32_t meshTypeIndex, uint32_t signature) {
-		return renderPassIndex * MeshManager::getTypeCount() * ShaderType::getSignatureCount() +
-			   meshTypeIndex * ShaderType::getSignatureCount() + signature;
+	// Reads source files of given filenames, preprocesses includes and computes source keys
+	static int readShaderSources(ShaderSourceInfo& sourceInfo) {
+		sourceInfo.dependencies.clear();
+
+		for (uint i = 0; i < 6; i++) {
+			const auto& sourceFilename = sourceInfo.filenames[i];
+			auto& source			   = sourceInfo.sources[i];
+
+			source.clear();
+
+			if (!sourceFilename.empty()) {
+				if (readTextFile(sourceFilename, source)) {
+					spdlog::error("Failed to open shader '{}' for compilation", sourceFilename);
+					return 1;
+				}
+
+				addDependency(sourceInfo, sourceFilename);
+
+				std::string directoryName = sourceFilename.substr(0, sourceFilename.find_last_of("\\/"));
+
+				if (!directoryName.empty()) {
+					directoryName += "/";
+				}
+
+				// Preprocess #include directives
+				int position = 0;
+				while ((position = source.find("#include", position)) != -1) {
+					auto includeLineLength = source.find("\n", position) - position;
+
+					auto filenamePosition = source.find("\"", position);
+					auto filenameLength	  = source.find("\"", filenamePosition + 1) - filenamePosition - 1;
+
+					if (position + includeLineLength < filenamePosition) {
+						spdlog::error("Failed preprocess shader '{}': include errors detected", sourceFilename);
+						return 1;
+					}
+
+					std::string filename = directoryName + source.substr(filenamePosition + 1, filenameLength);
+
+					std::string includeSource;
+					if (readTextFile(filename, includeSource)) {
+						spdlog::error("Failed preprocess shader '{}': cannot open '{}' to include", sourceFilename,
+									  filename);
+						return 1;
+					}
+
+					addDependency(sourceInfo, filename);
+
+					source.replace(position, includeLineLength, includeSource);
+				}
+			}
+		}
+
+
+		// Cache keys cover compiler version and options shared by all variants, then preprocessed source
+		uint spvVersion	 = 0;
+		uint spvRevision = 0;
+		shaderc_get_spv_version(&spvVersion, &spvRevision);
+
+		const uint64_t optionsKey =
+			ShaderCache::hash(fmt::format("spv {}.{}, optimization {}", spvVersion, spvRevision,
+										  static_cast<int>(OPTIMIZATION_LEVEL)));
+
+		for (uint i = 0; i < 6; i++) {
+			sourceInfo.sourceKeys[i] = ShaderCache::hash(sourceInfo.sources[i], optionsKey);
+		}
+
+		return 0;
+	}
+
+	static void addDependency(ShaderSourceInfo& sourceInfo, const std::string& filename) {
+		auto dependency = std::filesystem::path(filename).lexically_normal().string();
+
+		auto& dependencies = sourceInfo.dependencies;
+		if (std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end()) {
+			dependencies.push_back(std::move(dependency));
+		}
+	}
+
+	// Watches directories of all dependencies, failures only disable reloading of files in them
+	static void watchDependencies(const ShaderSourceInfo& sourceInfo) {
+		if (!fileWatcher.isOpen()) {
+			return;
+		}
+
+		for (const auto& dependency : sourceInfo.dependencies) {
+			auto directory = std::filesystem::path(dependency).parent_path().string();
+			fileWatcher.addDirectory(directory.empty() ? "." : directory);
+		}
+	}
+
+
+	// Appends jobs for every stage of a variant
+	static void appendCompileJobs(uint32_t renderPassIndex, uint32_t shaderInfoIndex,
+								  std::vector<CompileJob>& compileJobs) {
+		const std::array shaderStages = {
+			shaderc_glsl_vertex_shader,			 shaderc_glsl_geometry_shader, shaderc_glsl_tess_control_shader,
+			shaderc_glsl_tess_evaluation_shader, shaderc_glsl_fragment_shader, shaderc_glsl_compute_shader,
+		};
+
+		uint32_t shaderTypeIndex = 0;
+		uint32_t meshTypeIndex	 = 0;
+		uint32_t signature		 = 0;
+		getVariant(shaderInfoIndex, shaderTypeIndex, meshTypeIndex, signature);
+
+		const auto& sourceInfo = shaderSourceInfos[shaderTypeIndex];
+
+		bool useTessellation = MeshManager::getMeshTessellationUsage(meshTypeIndex);
+
+		std::vector<std::string> macroDefinitions {};
+		macroDefinitions.push_back(DerivedManager::getRenderPassStrings()[renderPassIndex]);
+		macroDefinitions.push_back(MeshManager::getMeshTypeString(meshTypeIndex));
+
+		for (uint flagIndex = 0; flagIndex < sourceInfo.flagNames.size(); flagIndex++) {
+			if ((1 << flagIndex) & signature) {
+				macroDefinitions.push_back(sourceInfo.flagNames[flagIndex]);
+			}
+		}
+
+		uint64_t macroKey = ShaderCache::HASH_SEED;
+		for (const auto& macroDefinition : macroDefinitions) {
+			macroKey = ShaderCache::hash(macroDefinition, macroKey);
+		}
+
+		for (uint shaderStageIndex = 0; shaderStageIndex < 6; shaderStageIndex++) {
+			if ((shaderStageIndex == 2 || shaderStageIndex == 3) && !useTessellation) {
+				continue;
+			}
+			if (!sourceInfo.sources[shaderStageIndex].empty()) {
+				CompileJob compileJob {};
+				compileJob.renderPassIndex	= renderPassIndex;
+				compileJob.shaderInfoIndex	= shaderInfoIndex;
+				compileJob.shaderStageIndex = shaderStageIndex;
+				compileJob.kind				= shaderStages[shaderStageIndex];
+				compileJob.pSource			= &sourceInfo.sources[shaderStageIndex];
+				compileJob.pFilename		= sourceInfo.filenames[shaderStageIndex].c_str();
+				compileJob.macroDefinitions = macroDefinitions;
+
+				compileJob.cacheKey =
+					ShaderCache::hash(&macroKey, sizeof(macroKey), sourceInfo.sourceKeys[shaderStageIndex]);
+				compileJob.cacheKey =
+					ShaderCache::hash(&compileJob.kind, sizeof(compileJob.kind), compileJob.cacheKey);
+
+				compileJobs.push_back(std::move(compileJob));
+			}
+		}
+	}
+
+	static void compileVariant(shaderc::Compiler& compiler, CompileJob& compileJob) {
+		if (!ShaderCache::load(compileJob.cacheKey, compileJob.spirvSource)) {
+			compileJob.isCached = true;
+			return;
+		}
+
+		shaderc::CompileOptions options;
+
+		options.SetOptimizationLevel(OPTIMIZATION_LEVEL);
+
+		for (const auto& macroDefinition : compileJob.macroDefinitions) {
+			options.AddMacroDefinition(macroDefinition);
+		}
+
+		shaderc::SpvCompilationResult result =
+			compiler.CompileGlslToSpv(*compileJob.pSource, compileJob.kind, compileJob.pFilename, options);
+
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+			compileJob.isFailed		= true;
+			compileJob.errorMessage = result.GetErrorMessage();
+			return;
+		}
+
+		compileJob.spirvSource.assign(result.cbegin(), result.cend());
+
+		// Failing to store is not fatal, variant is just compiled again next time
+		ShaderCache::store(compileJob.cacheKey, compileJob.spirvSource.data(), compileJob.spirvSource.size());
+	}
+
+	static int createShaderModules(const CompileJob* pCompileJobs, uint compileJobCount, ShaderInfo& shaderInfo) {
+		for (uint i = 0; i < compileJobCount; i++) {
+			const auto& compileJob = pCompileJobs[i];
+
+			vk::ShaderModuleCreateInfo shaderModuleCreateInfo {};
+			shaderModuleCreateInfo.codeSize = compileJob.spirvSource.size() * sizeof(uint32_t);
+			shaderModuleCreateInfo.pCode	= compileJob.spirvSource.data();
+
+			auto result = vkDevice.createShaderModule(&shaderModuleCreateInfo, nullptr,
+													  &shaderInfo.shaderModules[compileJob.shaderStageIndex]);
+
+			if (result != vk::Result::eSuccess) {
+				spdlog::error("[vulkan] Failed to create shader module. Error code: {} ({})", result,
+							  vk::to_string(result));
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	static void finishVariant(ShaderInfo& shaderInfo, bool isFailed) {
+		std::unique_lock lock(variantMutex);
+
+		shaderInfo.state = isFailed ? VariantState::FAILED : VariantState::READY;
+		variantCondition.notify_all();
+	}
+
+
+	// Compiles all variants of a shader type not created yet on worker threads
+	static int precompileVariants(uint32_t shaderTypeIndex) {
+		const auto firstShaderInfoIndex = shaderInfoOffsets[shaderTypeIndex];
+		const auto shaderInfoCount		= MeshManager::getTypeCount() * getShaderSignatureCount(shaderTypeIndex);
+
+		std::vector<CompileJob> compileJobs {};
+
+		{
+			std::unique_lock lock(variantMutex);
+
+			for (uint renderPassIndex = 0; renderPassIndex < getRenderPassStringCount(); renderPassIndex++) {
+				for (uint i = 0; i < shaderInfoCount; i++) {
+					auto& shaderInfo = shaderInfoArrays[renderPassIndex][firstShaderInfoIndex + i];
+
+					if (shaderInfo.state == VariantState::NONE) {
+						shaderInfo.state = VariantState::PENDING;
+						appendCompileJobs(renderPassIndex, firstShaderInfoIndex + i, compileJobs);
+					}
+				}
+			}
+		}
+
+		// Each thread uses its own compiler instance
+		const uint threadCount = std::max<uint>(std::thread::hardware_concurrency(), 1);
+
+		std::vector<shaderc::Compiler> compilers(threadCount);
+
+		ThreadPool threadPool {};
+		threadPool.init(
+			[&compilers](uint threadIndex, void* pData) {
+				compileVariant(compilers[threadIndex], *static_cast<CompileJob*>(pData));
+			},
+			threadCount);
+
+		for (auto& compileJob : compileJobs) {
+			threadPool.appendData(&compileJob);
+		}
+
+		threadPool.waitForAll();
+		threadPool.terminate();
+
+
+		// Results are collected in job order, so the same variants are reported regardless of scheduling. Jobs of a
+		// variant are consecutive.
+		std::array<const CompileJob*, 6> pFailedJobs {};
+		std::array<uint, 6> failedCounts {};
+
+		uint cachedCount   = 0;
+		uint compiledCount = 0;
+
+		for (uint firstJobIndex = 0; firstJobIndex < compileJobs.size();) {
+			const auto& firstJob = compileJobs[firstJobIndex];
+
+			uint jobCount = 0;
+			bool isFailed = false;
+			while (firstJobIndex + jobCount < compileJobs.size()) {
+				const auto& compileJob = compileJobs[firstJobIndex + jobCount];
+				if (compileJob.renderPassIndex != firstJob.renderPassIndex ||
+					compileJob.shaderInfoIndex != firstJob.shaderInfoIndex) {
+					break;
+				}
+
+				if (compileJob.isFailed) {
+					if (failedCounts[compileJob.shaderStageIndex]++ == 0) {
+						pFailedJobs[compileJob.shaderStageIndex] = &compileJob;
+					}
+					isFailed = true;
+				} else if (compileJob.isCached) {
+					cachedCount++;
+				} else {
+					compiledCount++;
+				}
+
+				jobCount++;
+			}
+
+			auto& shaderInfo = shaderInfoArrays[firstJob.renderPassIndex][firstJob.shaderInfoIndex];
+
+			if (!isFailed && createShaderModules(&firstJob, jobCount, shaderInfo)) {
+				isFailed = true;
+			}
+
+			finishVariant(shaderInfo, isFailed);
+
+			firstJobIndex += jobCount;
+		}
+
+		// Errors are reported once per source, variants of it usually fail for the same reason
+		bool isFailed = false;
+		for (uint i = 0; i < 6; i++) {
+			if (pFailedJobs[i] != nullptr) {
+				spdlog::error("Failed to compile shader '{}' ({} variant(s) failed). Error message:\n{}",
+							  pFailedJobs[i]->pFilename, failedCounts[i], pFailedJobs[i]->errorMessage);
+
+				isFailed = true;
+			}
+		}
+
+		if (isFailed) {
+			return 1;
+		}
+
+		spdlog::info("{} shader variant stage(s) loaded from cache, {} compiled", cachedCount, compiledCount);
+
+		return 0;
 	}
 
 
@@ -397,8 +931,8 @@ private:
 
 
 template <typename DerivedManager, typename... ShaderTypes>
-std::tuple<std::vector<ShaderTypes>...>
-	GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::shaderObjectArrays {};
+std::array<typename GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::ShaderSourceInfo, sizeof...(ShaderTypes)>
+	GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::shaderSourceInfos {};
 
 template <typename DerivedManager, typename... ShaderTypes>
 std::vector<std::vector<typename GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::ShaderInfo>>
@@ -408,6 +942,34 @@ template <typename DerivedManager, typename... ShaderTypes>
 std::array<uint, sizeof...(ShaderTypes)>
 	GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::shaderInfoOffsets {};
 
+template <typename DerivedManager, typename... ShaderTypes>
+std::mutex GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::variantMutex {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+std::condition_variable GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::variantCondition {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+std::mutex GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::requestMutex {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+std::vector<uint32_t> GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::requestedIndices {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+std::vector<bool> GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::requestedFlags {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+std::vector<uint32_t> GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::invalidatedIndices {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+std::vector<vk::ShaderModule> GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::retiredShaderModules {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+FileWatcher GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::fileWatcher {};
+
 template <typename DerivedManager, typename... ShaderTypes>
 vk::Device GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::vkDevice {};
+
+template <typename DerivedManager, typename... ShaderTypes>
+typename GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::Properties
+	GraphicsShaderManagerBase<DerivedManager, ShaderTypes...>::properties {};
 } // namespace Engine
\ No newline at end of file
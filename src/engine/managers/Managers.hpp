@@ -8,4 +8,8 @@
 #include "MaterialManager.hpp"
 #include "MeshManager.hpp"
 #include "ScriptManager.hpp"
-#include "TextureManager.hpp"
\ No newline at end of file
+#include "TerrainStreamingManager.hpp"
+#include "TextureManager.hpp"
+#include "TextureStreamingManager.hpp"
+#include "UploadManager.hpp"
+#include "VisibilityManager.hpp"
\ No newline at end of file
@@ -2,6 +2,10 @@
 
 #include "ResourceManagerBase.hpp"
 
+#include "engine/managers/ConfigManager.hpp"
+
+#include "engine/graphics/DescriptorSetArray.hpp"
+
 #include "engine/graphics/materials/Materials.hpp"
 
 #define VULKAN_HPP_NO_EXCEPTIONS 1
@@ -9,43 +13,42 @@
 
 #include "vk_mem_alloc.h"
 
+#include <algorithm>
+
 
 namespace Engine {
+// Material uniform blocks of all materials are stored in a single storage buffer indexed by material index, so the
+// material descriptor set is bound once per command buffer
 class MaterialManager : public ResourceManagerBase<MaterialManager, SimpleMaterial> {
-public:
-	struct MaterialInfo {
-		vk::Buffer uniformBuffer; // TODO: move uniformbuffer out; not needed for rendering
-		vk::DescriptorSet descriptorSet;
-	};
-
-
 private:
-	struct AllocationInfo {
-		VmaAllocation vmaAllocation {};
-		uint descriptorPoolIndex {};
-	};
-
-	struct DescriptorPoolInfo {
-		vk::DescriptorPool vkDescriptorPool {};
-		uint descriptorSetCount {};
-	};
+	static DescriptorSetArray descriptorSetArray;
 
+	// Persistently mapped material buffer
+	static uint8_t* pMaterialBuffer;
 
-private:
-	static std::vector<MaterialInfo> materialInfos;
-	static std::vector<AllocationInfo> allocationInfos;
+	static vk::Device vkDevice;
+	static VmaAllocator vmaAllocator;
 
-	static std::vector<DescriptorPoolInfo> descriptorPoolInfos;
 
-	static vk::DescriptorSetLayout vkDescriptorSetLayout;
+	struct Properties {
+		PROPERTY(uint, "Graphics", maxMaterialHandles, 4096);
+	};
 
-	static vk::Device vkDevice;
-	static VmaAllocator vmaAllocator;
+	static Properties properties;
 
 
 public:
 	static int init();
 
+	// Material buffer has fixed capacity, so creation fails once it is full rather than leaving shaders to read past
+	// its end
+	[[nodiscard]] static int createObject(uint32_t typeIndex, std::string name, Handle& handle);
+
+	template <typename Type>
+	[[nodiscard]] static inline int createObject(std::string name, Handle& handle) {
+		return createObject(getTypeIndex<Type>(), name, handle);
+	}
+
 	static void postCreate(Handle& handle);
 	static void update(Handle& handle);
 
@@ -60,23 +63,32 @@ public:
 
 
 	static inline auto getVkDescriptorSetLayout() {
-		return vkDescriptorSetLayout;
+		return descriptorSetArray.getVkDescriptorSetLayout();
+	}
+
+	static inline auto getVkDescriptorSet() {
+		return descriptorSetArray.getVkDescriptorSet(0);
 	}
 
 
-	static inline MaterialInfo& getMaterialInfo(const Handle& handle) {
-		return materialInfos[handle.getIndex()];
+	// Distance between material blocks in material buffer, matches std430 array stride of the largest block
+	static constexpr uint32_t getMaterialBlockStride() {
+		return getMaterialBlockStrideImpl(std::make_index_sequence<getTypeCount()>());
 	}
 
+	template <std::size_t... Indices>
+	static constexpr uint32_t getMaterialBlockStrideImpl(std::index_sequence<Indices...>) {
+		const uint32_t size = std::max(
+			{ std::tuple_element<Indices, decltype(getTypeTuple())>::type::getMaterialUniformBlockSize()... });
+
+		return (size + 15) / 16 * 16;
+	}
 
-	static int createDescriptorPool();
 
 	static void dispose();
 
 
 private:
 	MaterialManager() {};
-
-	static void destroy(uint32_t index);
 };
 } // namespace Engine
\ No newline at end of file
@@ -1,14 +1,28 @@
 #include "MeshManager.hpp"
 
+#include "engine/managers/UploadManager.hpp"
+
 
 namespace Engine {
 std::vector<MeshManager::MeshInfo> MeshManager::meshInfos {};
 
+std::vector<MeshManager::MeshInfo> MeshManager::pendingMeshInfos {};
+std::vector<uint64_t> MeshManager::pendingBatchIds {};
+
+std::vector<MeshManager::VertexArena> MeshManager::vertexArenas {};
+MeshManager::Arena MeshManager::indexArena {
+	{ vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst, VMA_MEMORY_USAGE_GPU_ONLY }
+};
+
+std::deque<MeshManager::ReleasedRanges> MeshManager::releasedRanges {};
+
+uint64_t MeshManager::frameIndex {};
+uint MeshManager::framesInFlightCount { 1 };
+
 vk::Device MeshManager::vkDevice {};
 VmaAllocator MeshManager::vmaAllocator {};
 
-vk::Queue MeshManager::vkTransferQueue {};
-vk::CommandPool MeshManager::vkCommandPool {};
+MeshManager::Properties MeshManager::properties {};
 
 
 int MeshManager::init() {
@@ -16,8 +30,48 @@ int MeshManager::init() {
 
 	assert(vkDevice != vk::Device());
 	assert(vmaAllocator != nullptr);
-	assert(vkTransferQueue != vk::Queue());
-	assert(vkCommandPool != vk::CommandPool());
+
+
+	// Allocate arenas, they are written on transfer queue and read on graphics queue
+
+	const vk::DeviceSize vertexArenaSize = vk::DeviceSize(properties.meshVertexArenaSize) * 1024 * 1024;
+	const vk::DeviceSize indexArenaSize	 = vk::DeviceSize(properties.meshIndexArenaSize) * 1024 * 1024;
+
+	vertexArenas.clear();
+
+	for (uint typeIndex = 0; typeIndex < getTypeCount(); typeIndex++) {
+		const uint32_t vertexCapacity = vertexArenaSize / getVertexSize(typeIndex);
+
+		auto& vertexArena = vertexArenas.emplace_back();
+
+		for (uint streamIndex = 0; streamIndex < getVertexStreamCount(typeIndex); streamIndex++) {
+			auto& streamBuffer = vertexArena.streamBuffers.emplace_back(
+				vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+				VMA_MEMORY_USAGE_GPU_ONLY);
+
+			const vk::DeviceSize streamSize =
+				vk::DeviceSize(vertexCapacity) * getVertexStreamStride(typeIndex, streamIndex);
+
+			auto result = streamBuffer.allocate(vmaAllocator, streamSize, UploadManager::getQueueFamilyIndices());
+			if (result != vk::Result::eSuccess) {
+				spdlog::error("[MeshManager] Failed to allocate vertex arena for '{}'. Error code: {} ({})",
+							  getMeshTypeString(typeIndex), result, vk::to_string(result));
+				return 1;
+			}
+		}
+
+		vertexArena.allocator.init(vertexCapacity);
+	}
+
+	auto result = indexArena.buffer.allocate(vmaAllocator, indexArenaSize, UploadManager::getQueueFamilyIndices());
+	if (result != vk::Result::eSuccess) {
+		spdlog::error("[MeshManager] Failed to allocate index arena. Error code: {} ({})", result,
+					  vk::to_string(result));
+		return 1;
+	}
+
+	indexArena.allocator.init(indexArenaSize / sizeof(uint32_t));
+
 
 	return ResourceManagerBase::init();
 };
@@ -25,37 +79,200 @@ int MeshManager::init() {
 
 void MeshManager::postCreate(Handle& handle) {
 	meshInfos.push_back({});
+
+	pendingMeshInfos.push_back({});
+	pendingBatchIds.push_back(0);
 }
 
 void MeshManager::update(Handle& handle) {
-	auto& meshInfo = getMeshInfo(handle);
+	MeshData meshData {};
+	std::vector<std::vector<uint8_t>> vertexStreams {};
+	std::vector<uint16_t> shortIndexBuffer {};
+
+	getMeshData(handle, meshData, vertexStreams, shortIndexBuffer);
+
+	update(handle, meshData);
+}
+
+void MeshManager::update() {
+	frameIndex++;
+
+	// Frame a range was released in is complete once as many frames have started after it as there are in flight
+	while (!releasedRanges.empty() && releasedRanges.front().frameIndex + framesInFlightCount <= frameIndex) {
+		const auto& ranges = releasedRanges.front();
+
+		vertexArenas[ranges.typeIndex].allocator.free(ranges.vertexOffset, ranges.vertexCount);
+		indexArena.allocator.free(ranges.indexArenaOffset, ranges.indexArenaSize);
+
+		releasedRanges.pop_front();
+	}
+}
+
+void MeshManager::update(Handle& handle, const MeshData& meshData) {
+	const uint32_t index	 = handle.getIndex();
+	const uint32_t typeIndex = getTypeIndex(handle);
+	auto& vertexArena		 = vertexArenas[typeIndex];
+
+	// Superseded upload is never published, but its copies may still be executing, so its ranges are released the
+	// same way as published ones
+	if (pendingBatchIds[index] != 0) {
+		releaseArenaRanges(typeIndex, pendingMeshInfos[index]);
+		pendingBatchIds[index] = 0;
+	}
+
+	auto& meshInfo = pendingMeshInfos[index];
+	meshInfo	   = {};
+
+	meshInfo.boundingSphere = meshData.boundingSphere;
+	meshInfo.boundingBox	= meshData.boundingBox;
+	meshInfo.meshlets.assign(meshData.pMeshlets, meshData.pMeshlets + meshData.meshletCount);
+
+	meshInfo.positionDequantization = meshData.positionDequantization;
+
+
+	const uint32_t vertexCount = meshData.vertexCount;
+	const uint32_t indexCount  = meshData.indexCount;
 
-	vk::DeviceSize vertexBufferSize;
-	void* vertexBufferData;
+	// Nothing to upload, empty mesh is published right away
+	if (vertexCount == 0 || indexCount == 0) {
+		meshInfo.meshlets.clear();
 
-	vk::DeviceSize indexBufferSize;
-	void* indexBufferData;
-	uint32_t indexCount = 0;
+		publishMeshInfo(index, typeIndex);
+		return;
+	}
+
+
+	const auto indexType	 = meshData.indexType;
+	const uint32_t indexSize = indexType == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+
+	uint64_t vertexOffset;
+	if (vertexArena.allocator.allocate(vertexCount, vertexOffset)) {
+		spdlog::error("[MeshManager] Vertex arena for '{}' is out of memory ({} of {} vertices free)",
+					  getMeshTypeString(typeIndex), vertexArena.allocator.getFreeSize(),
+					  vertexArena.allocator.getCapacity());
+		return;
+	}
+
+	uint64_t indexArenaOffset;
+	if (indexArena.allocator.allocate(getIndexArenaSize(indexCount, indexType), indexArenaOffset)) {
+		spdlog::error("[MeshManager] Index arena is out of memory ({} of {} indices free)",
+					  indexArena.allocator.getFreeSize(), indexArena.allocator.getCapacity());
+
+		vertexArena.allocator.free(vertexOffset, vertexCount);
+		return;
+	}
+
+	meshInfo.vkIndexBuffer = indexArena.buffer.getVkBuffer();
+
+	meshInfo.vertexOffset = vertexOffset;
+	meshInfo.vertexCount  = vertexCount;
+	meshInfo.firstIndex	  = indexArenaOffset * sizeof(uint32_t) / indexSize;
+	meshInfo.indexCount	  = indexCount;
+	meshInfo.indexType	  = indexType;
+
+
+	const uint32_t vertexStreamCount = getVertexStreamCount(typeIndex);
+
+	bool isUploaded = true;
+
+	for (uint streamIndex = 0; streamIndex < vertexStreamCount; streamIndex++) {
+		const uint32_t stride = getVertexStreamStride(typeIndex, streamIndex);
+
+		const auto& streamBuffer = vertexArena.streamBuffers[streamIndex];
+
+		meshInfo.vkVertexBuffers[streamIndex] = streamBuffer.getVkBuffer();
+
+		isUploaded &= !UploadManager::uploadBuffer(streamBuffer.getVkBuffer(), vk::DeviceSize(vertexOffset) * stride,
+												   meshData.pVertexStreams[streamIndex],
+												   vk::DeviceSize(vertexCount) * stride);
+	}
+	meshInfo.vertexStreamCount = vertexStreamCount;
+
+	isUploaded &= !UploadManager::uploadBuffer(indexArena.buffer.getVkBuffer(),
+											   vk::DeviceSize(indexArenaOffset) * sizeof(uint32_t), meshData.pIndices,
+											   vk::DeviceSize(indexCount) * indexSize);
+
+	if (!isUploaded) {
+		spdlog::error("[MeshManager] Failed to upload mesh {}", index);
+
+		releaseArenaRanges(typeIndex, meshInfo);
+		meshInfo = {};
+		return;
+	}
+
+
+	const uint64_t batchId = UploadManager::getBatchId(UploadManager::Stream::TRANSFER);
+	pendingBatchIds[index] = batchId;
+
+	UploadManager::onComplete(UploadManager::Stream::TRANSFER, [index, typeIndex, batchId]() {
+		if (pendingBatchIds[index] == batchId) {
+			publishMeshInfo(index, typeIndex);
+		}
+	});
+}
+
+void MeshManager::getMeshData(const Handle& handle, MeshData& meshData,
+							  std::vector<std::vector<uint8_t>>& vertexStreams, std::vector<uint16_t>& shortIndexBuffer) {
+	const uint32_t* pIndices = nullptr;
 
 	apply(handle, [&](auto& mesh) {
-		meshInfo.boundingSphere = mesh.boundingSphere;
-		meshInfo.boundingBox = mesh.boundingBox;
+		meshData.boundingSphere = mesh.boundingSphere;
+		meshData.boundingBox	= mesh.boundingBox;
+		meshData.pMeshlets		= mesh.meshlets.data();
+		meshData.meshletCount	= mesh.meshlets.size();
 
-		vertexBufferSize = mesh.getVertexBufferSize();
-		vertexBufferData = mesh.getVertexBuffer().data();
+		meshData.positionDequantization = mesh.positionDequantization;
 
-		indexBufferSize = mesh.getIndexBufferSize();
-		indexBufferData = mesh.getIndexBuffer().data();
-		indexCount		= mesh.getIndexBuffer().size();
+		vertexStreams		 = mesh.getVertexStreams();
+		meshData.vertexCount = mesh.getVertexBuffer().size();
+
+		pIndices			= mesh.getIndexBuffer().data();
+		meshData.indexCount = mesh.getIndexBuffer().size();
 	});
 
+	for (uint streamIndex = 0; streamIndex < vertexStreams.size(); streamIndex++) {
+		meshData.pVertexStreams[streamIndex] = vertexStreams[streamIndex].data();
+	}
 
-	meshInfo.vertexBuffer.allocate(vmaAllocator, vertexBufferSize);
-	meshInfo.vertexBuffer.writeStaged(vkDevice, vkTransferQueue, vkCommandPool, vertexBufferData);
+	// Narrow indices where possible, halving index bandwidth
+	if (meshData.vertexCount < 65536) {
+		shortIndexBuffer.assign(pIndices, pIndices + meshData.indexCount);
 
-	meshInfo.indexCount = indexCount;
-	meshInfo.indexBuffer.allocate(vmaAllocator, indexBufferSize);
-	meshInfo.indexBuffer.writeStaged(vkDevice, vkTransferQueue, vkCommandPool, indexBufferData);
+		meshData.indexType = vk::IndexType::eUint16;
+		meshData.pIndices  = shortIndexBuffer.data();
+	} else {
+		meshData.indexType = vk::IndexType::eUint32;
+		meshData.pIndices  = pIndices;
+	}
 }
 
+
+
+void MeshManager::publishMeshInfo(uint32_t index, uint32_t typeIndex) {
+	// Replaced ranges may still be read by frames in flight, they are queued with current frame index and returned to
+	// arenas by update once as many frames as there are in flight have completed
+	releaseArenaRanges(typeIndex, meshInfos[index]);
+
+	meshInfos[index] = std::move(pendingMeshInfos[index]);
+
+	pendingMeshInfos[index] = {};
+	pendingBatchIds[index]	= 0;
+}
+
+void MeshManager::releaseArenaRanges(uint32_t typeIndex, const MeshInfo& meshInfo) {
+	if (meshInfo.vertexCount == 0 || meshInfo.indexCount == 0) {
+		return;
+	}
+
+	ReleasedRanges ranges {};
+	ranges.frameIndex		= frameIndex;
+	ranges.typeIndex		= typeIndex;
+	ranges.vertexOffset		= meshInfo.vertexOffset;
+	ranges.vertexCount		= meshInfo.vertexCount;
+	ranges.indexArenaOffset = getIndexArenaOffset(meshInfo.firstIndex, meshInfo.indexType);
+	ranges.indexArenaSize	= getIndexArenaSize(meshInfo.indexCount, meshInfo.indexType);
+
+	releasedRanges.push_back(ranges);
+}
 } // namespace Engine
\ No newline at end of file
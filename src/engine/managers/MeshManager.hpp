@@ -2,48 +2,133 @@
 
 #include "ResourceManagerBase.hpp"
 
+#include "engine/managers/ConfigManager.hpp"
+
 #include "engine/graphics/BoundingBox.hpp"
 #include "engine/graphics/BoundingSphere.hpp"
 #include "engine/graphics/Buffer.hpp"
 
 #include "engine/graphics/meshes/Meshes.hpp"
 
+#include "engine/utils/FreeListAllocator.hpp"
+
 
 #define VULKAN_HPP_NO_EXCEPTIONS 1
 #include <vulkan/vulkan.hpp>
 
 #include "vk_mem_alloc.h"
 
+#include <deque>
+
 
 namespace Engine {
-class MeshManager : public ResourceManagerBase<MeshManager, StaticMesh, TerrainMesh> {
+// Mesh data is sub-allocated from one vertex buffer per vertex layout and one index buffer shared by all meshes
+class MeshManager : public ResourceManagerBase<MeshManager, StaticMesh, TerrainMesh, CompressedStaticMesh> {
 public:
+	// Position stream and attribute stream
+	static constexpr uint MAX_VERTEX_STREAM_COUNT = 2;
+
 	// info required for rendering
 	struct MeshInfo {
 		BoundingSphere boundingSphere {};
 		BoundingBox boundingBox {};
 
-		// TODO: keep vk::Buffer's only
-		Buffer vertexBuffer = { vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-								VMA_MEMORY_USAGE_GPU_ONLY };
-		Buffer indexBuffer	= { vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-								VMA_MEMORY_USAGE_GPU_ONLY };
+		// Arena buffers, shared by all meshes with the same vertex layout. Position stream is always the first one.
+		std::array<vk::Buffer, MAX_VERTEX_STREAM_COUNT> vkVertexBuffers {};
+		uint32_t vertexStreamCount {};
 
-		vk::Buffer vkVertexBuffer {};
 		vk::Buffer vkIndexBuffer {};
 
+		// Location within arena buffers, in vertices and indices
+		int32_t vertexOffset {};
+		uint32_t vertexCount {};
+
+		// In units of index type, 16 bit indices are used for meshes with fewer than 65536 vertices
+		uint32_t firstIndex {};
 		uint32_t indexCount {};
+
+		vk::IndexType indexType { vk::IndexType::eUint32 };
+
+		// Empty if mesh is always drawn as a whole
+		std::vector<Meshlet> meshlets {};
+
+		glm::vec4 positionDequantization { 0.0f, 0.0f, 0.0f, 1.0f };
+	};
+
+	// Mesh data in the layout it is stored on GPU. Data is referenced rather than owned, so it may point into a mapped
+	// file and be copied into staging memory directly.
+	struct MeshData {
+		BoundingSphere boundingSphere {};
+		BoundingBox boundingBox {};
+
+		const Meshlet* pMeshlets {};
+		uint32_t meshletCount {};
+
+		glm::vec4 positionDequantization { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		uint32_t vertexCount {};
+		std::array<const void*, MAX_VERTEX_STREAM_COUNT> pVertexStreams {};
+
+		uint32_t indexCount {};
+		vk::IndexType indexType { vk::IndexType::eUint32 };
+		const void* pIndices {};
+	};
+
+
+private:
+	struct Arena {
+		Buffer buffer;
+		FreeListAllocator allocator {};
+	};
+
+	// Vertex streams of a mesh are allocated at the same vertex offset in every stream buffer
+	struct VertexArena {
+		std::vector<Buffer> streamBuffers {};
+		FreeListAllocator allocator {};
+	};
+
+	// Arena ranges released during a frame, in arena allocator units
+	struct ReleasedRanges {
+		uint64_t frameIndex {};
+		uint32_t typeIndex {};
+
+		uint64_t vertexOffset {};
+		uint64_t vertexCount {};
+
+		uint64_t indexArenaOffset {};
+		uint64_t indexArenaSize {};
 	};
 
 
 private:
 	static std::vector<MeshInfo> meshInfos;
 
+	// Mesh infos waiting for their uploads, published into mesh infos once upload batch of the latest update of a mesh
+	// is complete. Batch id is zero if nothing is pending.
+	static std::vector<MeshInfo> pendingMeshInfos;
+	static std::vector<uint64_t> pendingBatchIds;
+
+	// Vertex arenas are indexed by mesh type index
+	static std::vector<VertexArena> vertexArenas;
+	static Arena indexArena;
+
+	// Released ranges may still be read by frames in flight, they are returned to arenas once those are complete
+	static std::deque<ReleasedRanges> releasedRanges;
+
+	static uint64_t frameIndex;
+	static uint framesInFlightCount;
+
 	static vk::Device vkDevice;
 	static VmaAllocator vmaAllocator;
 
-	static vk::Queue vkTransferQueue;
-	static vk::CommandPool vkCommandPool;
+
+	struct Properties {
+		// Sizes in megabytes
+		PROPERTY(uint, "Graphics", meshVertexArenaSize, 128);
+		PROPERTY(uint, "Graphics", meshIndexArenaSize, 64);
+	};
+
+	static Properties properties;
 
 
 public:
@@ -52,6 +137,19 @@ public:
 	static void postCreate(Handle& handle);
 	static void update(Handle& handle);
 
+	// Returns ranges released by frames which are complete now to arenas. Has to be called once per frame after
+	// waiting for the frame in flight being reused.
+	static void update();
+
+	// Uploads mesh data in GPU layout, contents of mesh object are left untouched. Upload is not waited for, previous
+	// mesh info is kept until it is complete.
+	static void update(Handle& handle, const MeshData& meshData);
+
+	// Converts mesh into GPU layout. Converted vertex streams and narrowed indices are stored in given vectors, which
+	// have to outlive mesh data.
+	static void getMeshData(const Handle& handle, MeshData& meshData, std::vector<std::vector<uint8_t>>& vertexStreams,
+							std::vector<uint16_t>& shortIndexBuffer);
+
 
 	static void setVkDevice(vk::Device device) {
 		vkDevice = device;
@@ -61,12 +159,8 @@ public:
 		vmaAllocator = allocator;
 	}
 
-	static void setVkTransferQueue(vk::Queue queue) {
-		vkTransferQueue = queue;
-	}
-
-	static void setVkCommandPool(vk::CommandPool commandPool) {
-		vkCommandPool = commandPool;
+	static void setFramesInFlightCount(uint count) {
+		framesInFlightCount = count;
 	}
 
 
@@ -74,6 +168,15 @@ public:
 		return meshInfos[handle.getIndex()];
 	}
 
+	static inline MeshInfo& getMeshInfo(uint32_t index) {
+		return meshInfos[index];
+	}
+
+	// Tells whether mesh has an uploaded mesh info to draw, mesh info stays empty until its first upload is complete
+	static inline bool isPublished(uint32_t index) {
+		return meshInfos[index].indexCount != 0 && meshInfos[index].vertexStreamCount != 0;
+	}
+
 
 	static inline std::string getMeshTypeString(const Handle& handle) {
 		std::string string;
@@ -118,6 +221,51 @@ public:
 	}
 
 
+	static inline uint32_t getVertexStreamCount(uint32_t typeIndex) {
+		return getVertexStreamCountImpl(typeIndex, std::make_index_sequence<getTypeCount()>());
+	}
+
+	template <std::size_t... Indices>
+	static inline uint32_t getVertexStreamCountImpl(uint32_t typeIndex, std::index_sequence<Indices...>) {
+		uint32_t streamCount {};
+
+		((streamCount = Indices == typeIndex ? std::get<Indices>(getTypeTuple()).getVertexStreamCount() : streamCount),
+		 ...);
+
+		return streamCount;
+	}
+
+	static inline uint32_t getVertexStreamStride(uint32_t typeIndex, uint32_t streamIndex) {
+		return getVertexStreamStrideImpl(typeIndex, streamIndex, std::make_index_sequence<getTypeCount()>());
+	}
+
+	template <std::size_t... Indices>
+	static inline uint32_t getVertexStreamStrideImpl(uint32_t typeIndex, uint32_t streamIndex,
+													 std::index_sequence<Indices...>) {
+		uint32_t stride {};
+
+		((stride =
+			  Indices == typeIndex ? std::get<Indices>(getTypeTuple()).getVertexStreamStride(streamIndex) : stride),
+		 ...);
+
+		return stride;
+	}
+
+
+	static inline uint32_t getVertexSize(uint32_t typeIndex) {
+		return getVertexSizeImpl(typeIndex, std::make_index_sequence<getTypeCount()>());
+	}
+
+	template <std::size_t... Indices>
+	static inline uint32_t getVertexSizeImpl(uint32_t typeIndex, std::index_sequence<Indices...>) {
+		uint32_t vertexSize {};
+
+		((vertexSize = Indices == typeIndex ? std::get<Indices>(getTypeTuple()).getVertexSize() : vertexSize), ...);
+
+		return vertexSize;
+	}
+
+
 	static auto getVertexInputAttributeDescriptions(uint32_t meshTypeIndex) {
 		return getVertexInputAttributeDescriptionsImpl(meshTypeIndex, std::make_index_sequence<getTypeCount()>());
 	}
@@ -154,14 +302,34 @@ public:
 
 
 	static void destroy() {
-		for (auto& meshInfo : meshInfos) {
-			meshInfo.vertexBuffer.destroy();
-			meshInfo.indexBuffer.destroy();
+		for (auto& vertexArena : vertexArenas) {
+			for (auto& streamBuffer : vertexArena.streamBuffers) {
+				streamBuffer.destroy();
+			}
 		}
+		vertexArenas.clear();
+		releasedRanges.clear();
+
+		indexArena.buffer.destroy();
 	}
 
 
 private:
 	MeshManager() {};
+
+	// Replaces mesh info with pending one, ranges of replaced mesh info are released once frames in flight complete
+	static void publishMeshInfo(uint32_t index, uint32_t typeIndex);
+
+	// Queues ranges of mesh info to be returned to arenas once frames in flight are complete
+	static void releaseArenaRanges(uint32_t typeIndex, const MeshInfo& meshInfo);
+
+	// Index arena is allocated in 32 bit units, two 16 bit indices share one
+	static inline uint32_t getIndexArenaOffset(uint32_t firstIndex, vk::IndexType indexType) {
+		return indexType == vk::IndexType::eUint16 ? firstIndex / 2 : firstIndex;
+	}
+
+	static inline uint32_t getIndexArenaSize(uint32_t indexCount, vk::IndexType indexType) {
+		return indexType == vk::IndexType::eUint16 ? (indexCount + 1) / 2 : indexCount;
+	}
 };
 } // namespace Engine
\ No newline at end of file
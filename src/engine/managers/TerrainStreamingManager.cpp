@@ -0,0 +1,352 @@
+#include "TerrainStreamingManager.hpp"
+
+#include "GlobalStateManager.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace Engine {
+MappedFile TerrainStreamingManager::file {};
+TerrainTileFile::Header TerrainStreamingManager::header {};
+
+std::array<TerrainStreamingManager::Level, TerrainStreamingManager::MAX_LEVEL_COUNT> TerrainStreamingManager::levels {};
+
+ThreadPool TerrainStreamingManager::threadPool {};
+
+TerrainStreamingManager::Properties TerrainStreamingManager::properties {};
+
+
+int TerrainStreamingManager::init() {
+	spdlog::info("Initializing TerrainStreamingManager...");
+
+	const uint clipmapSize = properties.terrainClipmapSize;
+
+	if (clipmapSize == 0 || clipmapSize % TerrainTileFile::TILE_SIZE != 0) {
+		spdlog::error("[TerrainStreamingManager] Clipmap size {} is not a multiple of tile size {}", clipmapSize,
+					  TerrainTileFile::TILE_SIZE);
+		return 1;
+	}
+
+	threadPool.init(loadThreadFunc, std::max<uint>(properties.terrainStreamingThreadCount, 1));
+
+	return 0;
+}
+
+
+int TerrainStreamingManager::load(std::string filename) {
+	spdlog::info("Loading terrain '{}'...", filename);
+
+	// Previous terrain loads may still be in flight
+	threadPool.waitForAll();
+
+	if (file.open(filename)) {
+		return 1;
+	}
+
+	const uint8_t* pData = file.getData();
+	const uint64_t size	 = file.getSize();
+
+	if (size < sizeof(TerrainTileFile::Header)) {
+		spdlog::error("[TerrainStreamingManager] '{}' is too small to be a terrain file", filename);
+		file.close();
+		return 1;
+	}
+
+	memcpy(&header, pData, sizeof(header));
+
+	if (header.magic != TerrainTileFile::MAGIC || header.version != TerrainTileFile::VERSION ||
+		header.tileSize != TerrainTileFile::TILE_SIZE || header.levelCount == 0 ||
+		header.levelCount > MAX_LEVEL_COUNT) {
+		spdlog::error("[TerrainStreamingManager] '{}' is not a supported terrain file", filename);
+		file.close();
+		return 1;
+	}
+
+	const uint64_t levelHeadersOffset = sizeof(TerrainTileFile::Header);
+
+	if (levelHeadersOffset + header.levelCount * sizeof(TerrainTileFile::LevelHeader) > size ||
+		header.pyramidOffset + header.pyramidSize > size) {
+		spdlog::error("[TerrainStreamingManager] '{}' is truncated", filename);
+		file.close();
+		return 1;
+	}
+
+	for (uint levelIndex = 0; levelIndex < header.levelCount; levelIndex++) {
+		auto& level = levels[levelIndex];
+
+		memcpy(&level.header, &pData[levelHeadersOffset + levelIndex * sizeof(TerrainTileFile::LevelHeader)],
+			   sizeof(TerrainTileFile::LevelHeader));
+
+		const uint64_t tileCount = level.header.tileCountX * level.header.tileCountY;
+		if (level.header.offset + tileCount * TerrainTileFile::getTileSize() > size) {
+			spdlog::error("[TerrainStreamingManager] Level {} of '{}' is truncated", levelIndex, filename);
+			file.close();
+			return 1;
+		}
+
+		level.origin		= {};
+		level.pendingOrigin = {};
+		level.isResident	= false;
+		level.isFailed		= false;
+		level.pendingLoads.clear();
+		level.loadedCount = 0;
+	}
+
+
+	auto& terrainState = GlobalStateManager::getWritable<TerrainState>();
+
+	terrainState.size	   = static_cast<int>(header.width * header.texelSize);
+	terrainState.maxHeight = static_cast<uint>(header.maxHeight);
+	terrainState.version++;
+
+	if (terrainState.heightPyramid.deserialize(&pData[header.pyramidOffset], header.pyramidSize)) {
+		file.close();
+		return 1;
+	}
+
+
+	// Create clipmaps, one layer per level
+
+	const uint clipmapSize = properties.terrainClipmapSize;
+
+	if (terrainState.heightClipmapHandle.getIndex() == 0) {
+		terrainState.heightClipmapHandle = TextureManager::createObject<Texture2D>("terrain_height_clipmap");
+		terrainState.normalClipmapHandle = TextureManager::createObject<Texture2D>("terrain_normal_clipmap");
+	}
+
+	auto createClipmap = [&](TextureManager::Handle& handle, vk::Format format) {
+		handle.apply([&](auto& texture) {
+			// Single layer would be created with a non array view
+			texture.size	   = vk::Extent3D(clipmapSize, clipmapSize, 1);
+			texture.layerCount = std::max(header.levelCount, 2u);
+
+			texture.format		= format;
+			texture.usage		= vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+			texture.imageAspect = vk::ImageAspectFlagBits::eColor;
+
+			texture.useMipMapping = false;
+		});
+		handle.update();
+
+		// Moves clipmap out of undefined layout, non resident texels are never sampled
+		return TextureManager::updateRegions(handle, {}, true);
+	};
+
+	if (createClipmap(terrainState.heightClipmapHandle, vk::Format::eR16Unorm) ||
+		createClipmap(terrainState.normalClipmapHandle, vk::Format::eR8G8B8A8Unorm)) {
+		file.close();
+		return 1;
+	}
+
+
+	// Coarsest level is loaded right away so there is always something to draw
+
+	const uint coarsestLevelIndex = header.levelCount - 1;
+
+	requestLoads(coarsestLevelIndex, glm::ivec2(0));
+	threadPool.waitForAll();
+
+	if (commitLoads(coarsestLevelIndex)) {
+		file.close();
+		return 1;
+	}
+
+	return 0;
+}
+
+
+int TerrainStreamingManager::update(glm::vec3 cameraPosition) {
+	if (!isLoaded()) {
+		return 0;
+	}
+
+	const uint windowTileCount = getWindowTileCount();
+
+	// At least one level is committed per frame, so a full window reload can never stall
+	const uint64_t maxUploadSize = windowTileCount * windowTileCount * TerrainTileFile::getTileSize();
+	uint64_t uploadSize			 = 0;
+
+	for (uint levelIndex = 0; levelIndex < header.levelCount; levelIndex++) {
+		auto& level = levels[levelIndex];
+
+		if (level.isFailed) {
+			continue;
+		}
+
+		if (!level.pendingLoads.empty()) {
+			if (level.loadedCount.load(std::memory_order_acquire) < level.pendingLoads.size() ||
+				uploadSize >= maxUploadSize) {
+				continue;
+			}
+
+			uploadSize += level.pendingLoads.size() * TerrainTileFile::getTileSize();
+
+			if (commitLoads(levelIndex)) {
+				level.isFailed = true;
+				return 1;
+			}
+			continue;
+		}
+
+
+		glm::ivec2 targetOrigin = getTargetOrigin(levelIndex, cameraPosition);
+
+		if (level.isResident && targetOrigin == level.origin) {
+			continue;
+		}
+
+		// Small camera movements step window by a tile at a time, teleports reload whole window
+		glm::ivec2 offset = targetOrigin - level.origin;
+
+		if (level.isResident && std::max(std::abs(offset.x), std::abs(offset.y)) < static_cast<int>(windowTileCount)) {
+			requestLoads(levelIndex, level.origin + glm::sign(offset));
+		} else {
+			requestLoads(levelIndex, targetOrigin);
+		}
+	}
+
+	return 0;
+}
+
+
+std::array<glm::vec4, TerrainStreamingManager::MAX_LEVEL_COUNT> TerrainStreamingManager::getClipmapLevels() {
+	std::array<glm::vec4, MAX_LEVEL_COUNT> clipmapLevels {};
+
+	for (uint levelIndex = 0; levelIndex < header.levelCount; levelIndex++) {
+		const auto& level = levels[levelIndex];
+
+		clipmapLevels[levelIndex] = glm::vec4(glm::vec2(level.origin * static_cast<int>(TerrainTileFile::TILE_SIZE)),
+											  header.texelSize * (1u << levelIndex), level.isResident ? 1.0f : 0.0f);
+	}
+
+	return clipmapLevels;
+}
+
+
+glm::ivec2 TerrainStreamingManager::getTargetOrigin(uint levelIndex, glm::vec3 cameraPosition) {
+	const auto& levelHeader = levels[levelIndex].header;
+
+	const int windowTileCount = getWindowTileCount();
+
+	const float levelTexelSize = header.texelSize * (1u << levelIndex);
+	const float terrainSize	   = header.width * header.texelSize;
+
+	glm::vec2 texelPosition = (glm::vec2(cameraPosition.x, cameraPosition.z) + 0.5f * terrainSize) / levelTexelSize;
+	glm::ivec2 tile			= glm::ivec2(glm::floor(texelPosition / static_cast<float>(TerrainTileFile::TILE_SIZE)));
+
+	glm::ivec2 maxOrigin = glm::ivec2(levelHeader.tileCountX, levelHeader.tileCountY) - windowTileCount;
+
+	return glm::clamp(tile - windowTileCount / 2, glm::ivec2(0), glm::max(maxOrigin, glm::ivec2(0)));
+}
+
+void TerrainStreamingManager::requestLoads(uint levelIndex, glm::ivec2 newOrigin) {
+	auto& level = levels[levelIndex];
+
+	const int windowTileCount = getWindowTileCount();
+
+	level.pendingOrigin = newOrigin;
+	level.pendingLoads.clear();
+	level.loadedCount = 0;
+
+	for (int y = newOrigin.y; y < newOrigin.y + windowTileCount; y++) {
+		for (int x = newOrigin.x; x < newOrigin.x + windowTileCount; x++) {
+			bool isResident = level.isResident && x >= level.origin.x && x < level.origin.x + windowTileCount &&
+							  y >= level.origin.y && y < level.origin.y + windowTileCount;
+
+			if (!isResident) {
+				level.pendingLoads.push_back({ levelIndex, glm::ivec2(x, y), {} });
+			}
+		}
+	}
+
+	// Vector is not touched until all loads complete, so pointers stay valid
+	for (auto& tileLoad : level.pendingLoads) {
+		threadPool.appendData(&tileLoad);
+	}
+}
+
+int TerrainStreamingManager::commitLoads(uint levelIndex) {
+	auto& level = levels[levelIndex];
+
+	const uint windowTileCount = getWindowTileCount();
+
+	std::vector<TextureManager::TextureRegion> heightRegions {};
+	std::vector<TextureManager::TextureRegion> normalRegions {};
+
+	heightRegions.reserve(level.pendingLoads.size());
+	normalRegions.reserve(level.pendingLoads.size());
+
+	for (const auto& tileLoad : level.pendingLoads) {
+		// Tile goes in place of the one that left window on the opposite side
+		glm::uvec2 slot = glm::uvec2(tileLoad.tile) % windowTileCount * TerrainTileFile::TILE_SIZE;
+
+		TextureManager::TextureRegion region {};
+		region.layer  = levelIndex;
+		region.offset = vk::Offset2D(slot.x, slot.y);
+		region.extent = vk::Extent2D(TerrainTileFile::TILE_SIZE, TerrainTileFile::TILE_SIZE);
+
+		region.pData = tileLoad.data.data();
+		region.size	 = TerrainTileFile::getTileHeightsSize();
+		heightRegions.push_back(region);
+
+		region.pData = tileLoad.data.data() + TerrainTileFile::getTileHeightsSize();
+		region.size	 = TerrainTileFile::getTileNormalsSize();
+		normalRegions.push_back(region);
+	}
+
+	const auto& terrainState = GlobalStateManager::get<TerrainState>();
+
+	level.pendingLoads.clear();
+
+	if (TextureManager::updateRegions(terrainState.heightClipmapHandle, heightRegions) ||
+		TextureManager::updateRegions(terrainState.normalClipmapHandle, normalRegions)) {
+		spdlog::error("[TerrainStreamingManager] Failed to upload tiles of level {}", levelIndex);
+		level.isResident = false;
+		return 1;
+	}
+
+	level.origin	 = level.pendingOrigin;
+	level.isResident = true;
+
+	return 0;
+}
+
+
+void TerrainStreamingManager::loadThreadFunc(uint threadIndex, void* pData) {
+	auto& tileLoad = *static_cast<TileLoad*>(pData);
+	auto& level	   = levels[tileLoad.levelIndex];
+
+	const uint64_t tileSize = TerrainTileFile::getTileSize();
+
+	tileLoad.data.resize(tileSize);
+
+	const glm::ivec2 tileCount = glm::ivec2(level.header.tileCountX, level.header.tileCountY);
+
+	// Windows larger than level hang over its edge
+	if (glm::all(glm::greaterThanEqual(tileLoad.tile, glm::ivec2(0))) &&
+		glm::all(glm::lessThan(tileLoad.tile, tileCount))) {
+		uint64_t offset = level.header.offset + (tileLoad.tile.y * tileCount.x + tileLoad.tile.x) * tileSize;
+		memcpy(tileLoad.data.data(), &file.getData()[offset], tileSize);
+	} else {
+		memset(tileLoad.data.data(), 0, tileSize);
+	}
+
+	level.loadedCount.fetch_add(1, std::memory_order_release);
+}
+
+
+void TerrainStreamingManager::dispose() {
+	threadPool.terminate();
+
+	for (auto& level : levels) {
+		level.pendingLoads.clear();
+		level.isResident = false;
+	}
+
+	file.close();
+}
+} // namespace Engine
\ No newline at end of file
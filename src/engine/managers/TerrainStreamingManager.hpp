@@ -0,0 +1,120 @@
+#pragma once
+
+#include "engine/graphics/TerrainTileFile.hpp"
+
+#include "engine/managers/ConfigManager.hpp"
+
+#include "engine/utils/MappedFile.hpp"
+#include "engine/utils/ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+
+namespace Engine {
+// Streams tiles of a cooked terrain file into clipmaps around the camera. Every level of the file keeps a window of
+// clipmap size texels resident in its own layer of height and normal texture arrays. Windows are addressed toroidally,
+// so a moving window only loads tiles entering it. Tiles are copied from memory mapped file on background threads and
+// a window step is committed once all its tiles are loaded. Coarsest level always covers the whole terrain.
+class TerrainStreamingManager {
+public:
+	static constexpr uint MAX_LEVEL_COUNT = TerrainTileFile::MAX_LEVEL_COUNT;
+
+
+private:
+	struct TileLoad {
+		uint levelIndex;
+		glm::ivec2 tile;
+
+		// Heights followed by normals
+		std::vector<uint8_t> data;
+	};
+
+	struct Level {
+		TerrainTileFile::LevelHeader header {};
+
+		// Window origin in tiles, committed one is used by shaders
+		glm::ivec2 origin {};
+		glm::ivec2 pendingOrigin {};
+
+		bool isResident {};
+
+		// Set once tiles of level could not be uploaded, level is not streamed anymore and coarser ones cover it
+		bool isFailed {};
+
+		// Tiles entering the window with pending origin, not modified until all of them are loaded
+		std::vector<TileLoad> pendingLoads {};
+		std::atomic<uint> loadedCount {};
+	};
+
+	static MappedFile file;
+	static TerrainTileFile::Header header;
+
+	static std::array<Level, MAX_LEVEL_COUNT> levels;
+
+	static ThreadPool threadPool;
+
+	struct Properties {
+		// Resident window size of each level in texels, multiple of tile size
+		PROPERTY(uint, "Graphics", terrainClipmapSize, 1024);
+
+		PROPERTY(uint, "Graphics", terrainStreamingThreadCount, 2);
+	};
+
+	static Properties properties;
+
+
+public:
+	static int init();
+
+	// Maps cooked terrain file, creates clipmaps and loads coarsest level. Terrain state is updated from file header.
+	static int load(std::string filename);
+
+	// Moves level windows toward camera, commits loaded steps and issues new loads. Has to be called once per frame
+	// before terrain is rendered.
+	static int update(glm::vec3 cameraPosition);
+
+	// Per level window origin in level texels, level texel size in world units and residency flag
+	static std::array<glm::vec4, MAX_LEVEL_COUNT> getClipmapLevels();
+
+
+	static inline bool isLoaded() {
+		return file.isOpen();
+	}
+
+	static inline uint getClipmapSize() {
+		return properties.terrainClipmapSize;
+	}
+
+	static inline uint getClipmapLevelCount() {
+		return header.levelCount;
+	}
+
+
+	static void dispose();
+
+
+private:
+	TerrainStreamingManager() {
+	}
+
+	static inline uint getWindowTileCount() {
+		return properties.terrainClipmapSize / TerrainTileFile::TILE_SIZE;
+	}
+
+	// Window origin centered on camera and clamped to level
+	static glm::ivec2 getTargetOrigin(uint levelIndex, glm::vec3 cameraPosition);
+
+	// Queues loads of tiles in window at new origin which are not in committed window
+	static void requestLoads(uint levelIndex, glm::ivec2 newOrigin);
+
+	// Writes loaded tiles into clipmaps and commits pending origin
+	static int commitLoads(uint levelIndex);
+
+	static void loadThreadFunc(uint threadIndex, void* pData);
+};
+} // namespace Engine
\ No newline at end of file
@@ -11,12 +11,12 @@ std::vector<VmaAllocation> TextureManager::allocationInfos {};
 vk::Device TextureManager::vkDevice {};
 VmaAllocator TextureManager::vmaAllocator {};
 
-vk::Queue TextureManager::vkTransferQueue {};
-vk::CommandPool TextureManager::vkCommandPool {};
+DescriptorSetArray TextureManager::descriptorSetArray {};
 
-StagingBuffer TextureManager::stagingBuffer {};
+std::vector<vk::ImageView> TextureManager::descriptorImageViews {};
+std::vector<std::vector<uint32_t>> TextureManager::pendingDescriptorIndices {};
 
-DescriptorSetArray TextureManager::descriptorSetArray {};
+uint TextureManager::framesInFlightCount { 1 };
 
 vk::Sampler TextureManager::vkSampler {};
 
@@ -28,14 +28,6 @@ int TextureManager::init() {
 
 	assert(vkDevice != vk::Device());
 	assert(vmaAllocator != nullptr);
-	assert(vkTransferQueue != vk::Queue());
-	assert(vkCommandPool != vk::CommandPool());
-
-	uint maxTextureSize = properties.maxTextureSize;
-	if (stagingBuffer.init(vkDevice, vmaAllocator, maxTextureSize * maxTextureSize * 4)) {
-		return 1;
-	}
-
 
 	if (ResourceManagerBase::init()) {
 		return 1;
@@ -71,11 +63,15 @@ int TextureManager::init() {
 	// descriptorSetArray.setBindingCount(2);
 	descriptorSetArray.setBindingLayoutInfo(0, vk::DescriptorType::eSampler, 0);
 	descriptorSetArray.setBindingLayoutInfo(1, vk::DescriptorType::eSampledImage, 0, properties.maxTextureHandles);
+	descriptorSetArray.setElementCount(framesInFlightCount);
 	descriptorSetArray.setVkDevice(vkDevice);
 	descriptorSetArray.setVmaAllocator(vmaAllocator);
 	descriptorSetArray.init();
 
-	descriptorSetArray.updateImage(0, 0, 0, vkSampler, {});
+	descriptorSetArray.updateImages(0, 0, vkSampler, {});
+
+	descriptorImageViews.resize(properties.maxTextureHandles);
+	pendingDescriptorIndices.resize(framesInFlightCount);
 
 
 	// Update fallback textures
@@ -93,10 +89,21 @@ int TextureManager::init() {
 	});
 	fallbackTextureHandle.update();
 
+	// Fallback texture is bound in place of every pending one, so it has to be ready before the first frame
+	if (UploadManager::wait()) {
+		return 1;
+	}
+
 
+	// No frame is in flight yet, so every set is written right away
 	// TODO: update all at once
-	for (uint i = 1; i < properties.maxTextureHandles; i++) {
-		descriptorSetArray.updateImage(0, 1, i, {}, textureInfos[0].imageView);
+	for (uint i = 0; i < properties.maxTextureHandles; i++) {
+		descriptorImageViews[i] = textureInfos[0].imageView;
+		descriptorSetArray.updateImages(1, i, {}, descriptorImageViews[i]);
+	}
+
+	for (auto& pendingIndices : pendingDescriptorIndices) {
+		pendingIndices.clear();
 	}
 
 
@@ -170,6 +177,21 @@ void TextureManager::update(Handle& handle) {
 	});
 
 
+	// TODO: another way of preventing reading from texture used as an attachment
+	// Array views are not compatible with texture2D descriptors, those are bound by their users directly
+	textureInfo.hasDescriptor = !(imageCreateInfo.usage & vk::ImageUsageFlagBits::eColorAttachment) &&
+								!(imageCreateInfo.usage & vk::ImageUsageFlagBits::eDepthStencilAttachment) &&
+								imageViewCreateInfo.viewType == vk::ImageViewType::e2D;
+
+	// Textures bound through descriptor set may be uploaded on transfer queue and sampled on graphics queue
+	const auto& queueFamilyIndices = UploadManager::getQueueFamilyIndices();
+	if (textureInfo.hasDescriptor && queueFamilyIndices.size() > 1) {
+		imageCreateInfo.sharingMode			  = vk::SharingMode::eConcurrent;
+		imageCreateInfo.queueFamilyIndexCount = queueFamilyIndices.size();
+		imageCreateInfo.pQueueFamilyIndices	  = queueFamilyIndices.data();
+	}
+
+
 	// TODO: separate image creation from updating
 	// Create image
 
@@ -205,15 +227,6 @@ void TextureManager::update(Handle& handle) {
 	}
 
 
-	// Update descriptor set
-
-	// TODO: another way of preventing reading from texture used as an attachment
-	if (!(imageCreateInfo.usage & vk::ImageUsageFlagBits::eColorAttachment) &&
-		!(imageCreateInfo.usage & vk::ImageUsageFlagBits::eDepthStencilAttachment)) {
-		descriptorSetArray.updateImage(0, 1, handle.getIndex(), {}, textureInfo.imageView);
-	}
-
-
 	// Write texture data
 
 	void* pTextureData;
@@ -225,151 +238,278 @@ void TextureManager::update(Handle& handle) {
 		textureSize		= texture.size;
 	});
 
-	if (textureDataSize > 0) {
-		if (stagingBuffer.update(pTextureData, textureDataSize)) {
-			return;
-		}
-		if (stagingBuffer.transfer(vkTransferQueue, vkCommandPool, textureInfo.image, textureSize)) {
-			return;
+	if (textureDataSize == 0) {
+		if (textureInfo.hasDescriptor) {
+			setDescriptor(handle.getIndex(), textureInfo.imageView);
 		}
+		return;
+	}
 
+	// Mip maps are generated with blits, which transfer queue does not support. Exclusively owned images stay on
+	// graphics queue.
+	auto stream = (mipLevels > 1 || !textureInfo.hasDescriptor) ? UploadManager::Stream::GRAPHICS
+																 : UploadManager::Stream::TRANSFER;
 
-		// Generate mip maps
+	vk::DeviceSize stagingOffset;
+	if (UploadManager::stage(pTextureData, textureDataSize, stagingOffset)) {
+		return;
+	}
 
-		// TODO: abstract one-time command buffer
-		// Begin one-time command buffer
+	vk::CommandBuffer commandBuffer;
+	if (UploadManager::getCommandBuffer(stream, commandBuffer)) {
+		return;
+	}
 
-		vk::CommandBuffer commandBuffer {};
+	recordLayoutTransition(commandBuffer, stream, textureInfo, 0, mipLevels, vk::ImageLayout::eUndefined,
+						   vk::ImageLayout::eTransferDstOptimal);
 
-		vk::CommandBufferAllocateInfo commandBufferAllocateInfo {};
-		commandBufferAllocateInfo.level				 = vk::CommandBufferLevel::ePrimary;
-		commandBufferAllocateInfo.commandPool		 = vkCommandPool;
-		commandBufferAllocateInfo.commandBufferCount = 1;
+	vk::BufferImageCopy copyRegion {};
+	copyRegion.bufferOffset					   = stagingOffset;
+	copyRegion.imageSubresource.aspectMask	   = textureInfo.imageAspect;
+	copyRegion.imageSubresource.mipLevel	   = 0;
+	copyRegion.imageSubresource.baseArrayLayer = 0;
+	copyRegion.imageSubresource.layerCount	   = 1;
+	copyRegion.imageExtent					   = textureSize;
 
-		auto result = vkDevice.allocateCommandBuffers(&commandBufferAllocateInfo, &commandBuffer);
-		if (result != vk::Result::eSuccess) {
-			spdlog::error("Failed to allocate staging command buffer. Error code: {} ({})", result,
-						  vk::to_string(result));
-			return;
-		}
+	commandBuffer.copyBufferToImage(UploadManager::getVkStagingBuffer(), textureInfo.image,
+									vk::ImageLayout::eTransferDstOptimal, 1, &copyRegion);
 
-		vk::CommandBufferBeginInfo commandBufferBeginInfo {};
-		commandBufferBeginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
 
-		result = commandBuffer.begin(&commandBufferBeginInfo);
-		if (result != vk::Result::eSuccess) {
-			spdlog::error("Failed to record staging command buffer. Error code: {} ({})", result,
-						  vk::to_string(result));
-			return;
-		}
+	// Generate mip maps
 
+	// TODO: 3D texture support
+	vk::Offset3D mipSize = { static_cast<int32_t>(textureSize.width), static_cast<int32_t>(textureSize.height), 1 };
 
-		// TODO: 3D texture support
-		vk::Offset3D mipSize = { static_cast<int32_t>(textureSize.width), static_cast<int32_t>(textureSize.height), 1 };
+	vk::ImageMemoryBarrier imageMemoryBarrier {};
+	imageMemoryBarrier.image					   = textureInfo.image;
+	imageMemoryBarrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+	imageMemoryBarrier.subresourceRange.levelCount = 1;
+	imageMemoryBarrier.subresourceRange.layerCount = textureInfo.arrayLayers;
 
-		vk::ImageMemoryBarrier imageMemoryBarrier {};
-		imageMemoryBarrier.image					   = textureInfo.image;
-		imageMemoryBarrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-		imageMemoryBarrier.subresourceRange.levelCount = 1;
-		imageMemoryBarrier.subresourceRange.layerCount = 1;
+	for (uint level = 0; level < mipLevels - 1; level++) {
+		imageMemoryBarrier.subresourceRange.baseMipLevel = level;
+		imageMemoryBarrier.oldLayout					 = vk::ImageLayout::eTransferDstOptimal;
+		imageMemoryBarrier.newLayout					 = vk::ImageLayout::eTransferSrcOptimal;
+		imageMemoryBarrier.srcAccessMask				 = vk::AccessFlagBits::eTransferWrite;
+		imageMemoryBarrier.dstAccessMask				 = vk::AccessFlagBits::eTransferRead;
 
-		for (uint level = 0; level < mipLevels - 1; level++) {
-			imageMemoryBarrier.subresourceRange.baseMipLevel = level;
-			imageMemoryBarrier.oldLayout					 = vk::ImageLayout::eTransferDstOptimal;
-			imageMemoryBarrier.newLayout					 = vk::ImageLayout::eTransferSrcOptimal;
-			imageMemoryBarrier.srcAccessMask				 = vk::AccessFlagBits::eTransferWrite;
-			imageMemoryBarrier.dstAccessMask				 = vk::AccessFlagBits::eTransferRead;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {},
+									  0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 
-			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
-										  {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 
+		vk::ImageBlit imageBlit {};
 
-			imageMemoryBarrier.subresourceRange.baseMipLevel = level + 1;
-			imageMemoryBarrier.oldLayout					 = vk::ImageLayout::eUndefined;
-			imageMemoryBarrier.newLayout					 = vk::ImageLayout::eTransferDstOptimal;
-			imageMemoryBarrier.srcAccessMask				 = {};
-			imageMemoryBarrier.dstAccessMask				 = vk::AccessFlagBits::eTransferWrite;
+		imageBlit.srcSubresource.aspectMask		= vk::ImageAspectFlagBits::eColor;
+		imageBlit.srcSubresource.mipLevel		= level;
+		imageBlit.srcSubresource.baseArrayLayer = 0;
+		imageBlit.srcSubresource.layerCount		= 1;
+		imageBlit.srcOffsets[0]					= vk::Offset3D { 0, 0, 0 };
+		imageBlit.srcOffsets[1]					= vk::Offset3D { mipSize.x, mipSize.y, 1 };
 
-			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
-										  {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+		mipSize.x = std::max(1, mipSize.x / 2);
+		mipSize.y = std::max(1, mipSize.y / 2);
 
+		imageBlit.dstSubresource.aspectMask		= vk::ImageAspectFlagBits::eColor;
+		imageBlit.dstSubresource.mipLevel		= level + 1;
+		imageBlit.dstSubresource.baseArrayLayer = 0;
+		imageBlit.dstSubresource.layerCount		= 1;
+		imageBlit.dstOffsets[0]					= vk::Offset3D { 0, 0, 0 };
+		imageBlit.dstOffsets[1]					= vk::Offset3D { mipSize.x, mipSize.y, 1 };
 
-			vk::ImageBlit imageBlit {};
+		commandBuffer.blitImage(textureInfo.image, vk::ImageLayout::eTransferSrcOptimal, textureInfo.image,
+								vk::ImageLayout::eTransferDstOptimal, 1, &imageBlit, vk::Filter::eLinear);
 
-			imageBlit.srcSubresource.aspectMask		= vk::ImageAspectFlagBits::eColor;
-			imageBlit.srcSubresource.mipLevel		= level;
-			imageBlit.srcSubresource.baseArrayLayer = 0;
-			imageBlit.srcSubresource.layerCount		= 1;
-			imageBlit.srcOffsets[0]					= vk::Offset3D { 0, 0, 0 };
-			imageBlit.srcOffsets[1]					= vk::Offset3D { mipSize.x, mipSize.y, 1 };
 
-			mipSize.x = std::max(1, mipSize.x / 2);
-			mipSize.y = std::max(1, mipSize.y / 2);
+		imageMemoryBarrier.subresourceRange.baseMipLevel = level;
+		imageMemoryBarrier.oldLayout					 = vk::ImageLayout::eTransferSrcOptimal;
+		imageMemoryBarrier.newLayout					 = vk::ImageLayout::eShaderReadOnlyOptimal;
+		imageMemoryBarrier.srcAccessMask				 = vk::AccessFlagBits::eTransferRead;
+		imageMemoryBarrier.dstAccessMask				 = vk::AccessFlagBits::eShaderRead;
+
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader,
+									  {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+	}
 
-			imageBlit.dstSubresource.aspectMask		= vk::ImageAspectFlagBits::eColor;
-			imageBlit.dstSubresource.mipLevel		= level + 1;
-			imageBlit.dstSubresource.baseArrayLayer = 0;
-			imageBlit.dstSubresource.layerCount		= 1;
-			imageBlit.dstOffsets[0]					= vk::Offset3D { 0, 0, 0 };
-			imageBlit.dstOffsets[1]					= vk::Offset3D { mipSize.x, mipSize.y, 1 };
+	recordLayoutTransition(commandBuffer, stream, textureInfo, mipLevels - 1, 1, vk::ImageLayout::eTransferDstOptimal,
+						   vk::ImageLayout::eShaderReadOnlyOptimal);
 
-			commandBuffer.blitImage(textureInfo.image, vk::ImageLayout::eTransferSrcOptimal, textureInfo.image,
-									vk::ImageLayout::eTransferDstOptimal, 1, &imageBlit, vk::Filter::eLinear);
+	textureInfo.uploadBatchId = UploadManager::getBatchId(stream);
 
 
-			imageMemoryBarrier.subresourceRange.baseMipLevel = level;
-			imageMemoryBarrier.oldLayout					 = vk::ImageLayout::eTransferSrcOptimal;
-			imageMemoryBarrier.newLayout					 = vk::ImageLayout::eShaderReadOnlyOptimal;
-			imageMemoryBarrier.srcAccessMask				 = vk::AccessFlagBits::eTransferRead;
-			imageMemoryBarrier.dstAccessMask				 = vk::AccessFlagBits::eShaderRead;
+	// Update descriptor set
 
-			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-										  vk::PipelineStageFlagBits::eFragmentShader, {}, 0, nullptr, 0, nullptr, 1,
-										  &imageMemoryBarrier);
+	if (textureInfo.hasDescriptor) {
+		// Graphics stream is submitted before rendering, so texture may be sampled right away
+		if (stream == UploadManager::Stream::GRAPHICS) {
+			setDescriptor(handle.getIndex(), textureInfo.imageView);
+		} else {
+			setDescriptor(handle.getIndex(), textureInfos[0].imageView);
+			publishOnComplete(stream, handle.getIndex());
 		}
+	}
+}
 
-		imageMemoryBarrier.subresourceRange.baseMipLevel = mipLevels - 1;
-		imageMemoryBarrier.oldLayout					 = vk::ImageLayout::eTransferDstOptimal;
-		imageMemoryBarrier.newLayout					 = vk::ImageLayout::eShaderReadOnlyOptimal;
-		imageMemoryBarrier.srcAccessMask				 = vk::AccessFlagBits::eTransferWrite;
-		imageMemoryBarrier.dstAccessMask				 = vk::AccessFlagBits::eShaderRead;
+int TextureManager::updateRegions(const Handle& handle, const std::vector<TextureRegion>& regions,
+								  bool discardContents) {
+	auto& textureInfo = textureInfos[handle.getIndex()];
 
-		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader,
-									  {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+	if (textureInfo.image == vk::Image()) {
+		spdlog::error("[TextureManager] Failed to update regions of texture {}: texture is not created",
+					  handle.getIndex());
+		return 1;
+	}
 
+	// Contents in use are overwritten in order with rendering
+	auto stream = (discardContents && textureInfo.hasDescriptor) ? UploadManager::Stream::TRANSFER
+																  : UploadManager::Stream::GRAPHICS;
 
-		// End one-time command buffer
+	if (stream == UploadManager::Stream::TRANSFER) {
+		setDescriptor(handle.getIndex(), textureInfos[0].imageView);
+	}
 
-		result = commandBuffer.end();
-		if (result != vk::Result::eSuccess) {
-			spdlog::error("Failed to record staging command buffer. Error code: {} ({})", result,
-						  vk::to_string(result));
-			return;
+	auto layout = discardContents ? vk::ImageLayout::eUndefined : vk::ImageLayout::eShaderReadOnlyOptimal;
+
+	vk::CommandBuffer commandBuffer {};
+	uint64_t batchId = 0;
+
+	for (const auto& region : regions) {
+		vk::DeviceSize stagingOffset;
+		if (UploadManager::stage(region.pData, region.size, stagingOffset)) {
+			return 1;
+		}
+
+		if (UploadManager::getCommandBuffer(stream, commandBuffer)) {
+			return 1;
 		}
 
-		vk::SubmitInfo submitInfo {};
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers	  = &commandBuffer;
+		// Staging may submit current batch, image is transitioned again in every batch regions are copied in
+		if (UploadManager::getBatchId(stream) != batchId) {
+			recordLayoutTransition(commandBuffer, stream, textureInfo, 0, textureInfo.mipLevels, layout,
+								   vk::ImageLayout::eTransferDstOptimal);
 
-		result = vkTransferQueue.submit(1, &submitInfo, nullptr);
-		if (result != vk::Result::eSuccess) {
-			spdlog::error("Failed to submit staging buffer. Error code: {} ({})", result, vk::to_string(result));
-			return;
+			layout	= vk::ImageLayout::eTransferDstOptimal;
+			batchId = UploadManager::getBatchId(stream);
 		}
 
-		result = vkTransferQueue.waitIdle();
-		if (result != vk::Result::eSuccess) {
-			spdlog::error("Failed to wait for staging command buffer to complete. Error code: {} ({})", result,
-						  vk::to_string(result));
-			return;
+		vk::BufferImageCopy copyRegion {};
+		copyRegion.bufferOffset = stagingOffset;
+
+		copyRegion.imageSubresource.aspectMask	   = textureInfo.imageAspect;
+		copyRegion.imageSubresource.mipLevel	   = region.mipLevel;
+		copyRegion.imageSubresource.baseArrayLayer = region.layer;
+		copyRegion.imageSubresource.layerCount	   = 1;
+
+		copyRegion.imageOffset = vk::Offset3D(region.offset.x, region.offset.y, 0);
+		copyRegion.imageExtent = vk::Extent3D(region.extent.width, region.extent.height, 1);
+
+		commandBuffer.copyBufferToImage(UploadManager::getVkStagingBuffer(), textureInfo.image,
+										vk::ImageLayout::eTransferDstOptimal, 1, &copyRegion);
+	}
+
+	// Discarded contents are still transitioned if there are no regions
+	if (batchId == 0) {
+		if (UploadManager::getCommandBuffer(stream, commandBuffer)) {
+			return 1;
 		}
+	}
 
-		vkDevice.freeCommandBuffers(vkCommandPool, 1, &commandBuffer);
+	recordLayoutTransition(commandBuffer, stream, textureInfo, 0, textureInfo.mipLevels, layout,
+						   vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	textureInfo.uploadBatchId = UploadManager::getBatchId(stream);
+
+	if (stream == UploadManager::Stream::TRANSFER) {
+		publishOnComplete(stream, handle.getIndex());
 	}
+
+	return 0;
+}
+
+
+void TextureManager::recordLayoutTransition(vk::CommandBuffer commandBuffer, UploadManager::Stream stream,
+											const TextureInfo& textureInfo, uint baseMipLevel, uint levelCount,
+											vk::ImageLayout oldLayout, vk::ImageLayout newLayout) {
+	vk::PipelineStageFlags shaderStages {};
+	vk::AccessFlags shaderAccess {};
+
+	// Transfer queue synchronizes with other queues through fences only
+	if (stream == UploadManager::Stream::GRAPHICS) {
+		shaderStages = vk::PipelineStageFlagBits::eAllGraphics;
+		shaderAccess = vk::AccessFlagBits::eShaderRead;
+	}
+
+	vk::ImageMemoryBarrier imageMemoryBarrier {};
+	imageMemoryBarrier.oldLayout					   = oldLayout;
+	imageMemoryBarrier.newLayout					   = newLayout;
+	imageMemoryBarrier.image						   = textureInfo.image;
+	imageMemoryBarrier.subresourceRange.aspectMask	   = textureInfo.imageAspect;
+	imageMemoryBarrier.subresourceRange.baseMipLevel   = baseMipLevel;
+	imageMemoryBarrier.subresourceRange.levelCount	   = levelCount;
+	imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
+	imageMemoryBarrier.subresourceRange.layerCount	   = textureInfo.arrayLayers;
+
+	vk::PipelineStageFlags srcStages {};
+	vk::PipelineStageFlags dstStages {};
+
+	if (newLayout == vk::ImageLayout::eTransferDstOptimal) {
+		// Earlier copies are included for images written in several batches
+		imageMemoryBarrier.srcAccessMask = shaderAccess | vk::AccessFlagBits::eTransferWrite;
+		imageMemoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+		srcStages = shaderStages | vk::PipelineStageFlagBits::eTopOfPipe | vk::PipelineStageFlagBits::eTransfer;
+		dstStages = vk::PipelineStageFlagBits::eTransfer;
+	} else {
+		imageMemoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		imageMemoryBarrier.dstAccessMask = shaderAccess;
+
+		srcStages = vk::PipelineStageFlagBits::eTransfer;
+		dstStages = shaderStages | vk::PipelineStageFlagBits::eBottomOfPipe;
+	}
+
+	commandBuffer.pipelineBarrier(srcStages, dstStages, {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+}
+
+void TextureManager::updateDescriptorSet(uint frameIndex) {
+	auto& pendingIndices = pendingDescriptorIndices[frameIndex];
+
+	// Index queued several times is written with its latest image view each time
+	for (auto index : pendingIndices) {
+		descriptorSetArray.updateImage(frameIndex, 1, index, {}, descriptorImageViews[index]);
+	}
+
+	pendingIndices.clear();
+}
+
+
+void TextureManager::setDescriptor(uint32_t index, vk::ImageView imageView) {
+	// Views are not compared, a recreated texture may get the handle value of its destroyed view
+	descriptorImageViews[index] = imageView;
+
+	for (auto& pendingIndices : pendingDescriptorIndices) {
+		pendingIndices.push_back(index);
+	}
+}
+
+void TextureManager::publishOnComplete(UploadManager::Stream stream, uint32_t index) {
+	auto imageView = textureInfos[index].imageView;
+
+	UploadManager::onComplete(stream, [index, imageView]() {
+		// Texture may have been recreated since
+		if (textureInfos[index].imageView == imageView) {
+			setDescriptor(index, imageView);
+		}
+	});
 }
 
 
 void TextureManager::destroy(uint32_t index) {
+	// Pending upload may still be writing into image
+	if (!UploadManager::isComplete(textureInfos[index].uploadBatchId)) {
+		if (UploadManager::wait(textureInfos[index].uploadBatchId)) {
+			spdlog::error("[TextureManager] Failed to wait for upload of texture {}", index);
+		}
+	}
+
 	if (textureInfos[index].imageView != vk::ImageView()) {
 		vkDevice.destroyImageView(textureInfos[index].imageView);
 	}
@@ -385,7 +525,6 @@ void TextureManager::dispose() {
 	for (uint i = 0; i < textureInfos.size(); i++) {
 		destroy(i);
 	}
-	stagingBuffer.dispose();
 
 	vkDevice.destroySampler(vkSampler);
 }
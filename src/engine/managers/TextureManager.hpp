@@ -5,9 +5,9 @@
 #include "engine/graphics/textures/Texture2D.hpp"
 
 #include "engine/graphics/DescriptorSetArray.hpp"
-#include "engine/graphics/StagingBuffer.hpp"
 
 #include "engine/managers/ConfigManager.hpp"
+#include "engine/managers/UploadManager.hpp"
 
 #define VULKAN_HPP_NO_EXCEPTIONS 1
 #include <vulkan/vulkan.hpp>
@@ -27,6 +27,24 @@ public:
 
 		uint arrayLayers {};
 		uint mipLevels {};
+
+		// Texture is bound through descriptor set, which points to fallback texture while an upload is pending
+		bool hasDescriptor {};
+
+		// Last upload batch writing into texture
+		uint64_t uploadBatchId {};
+	};
+
+	// Part of a single layer and mip level, pixel data is tightly packed
+	struct TextureRegion {
+		uint layer {};
+		uint mipLevel {};
+
+		vk::Offset2D offset {};
+		vk::Extent2D extent {};
+
+		const void* pData {};
+		uint64_t size {};
 	};
 
 
@@ -38,12 +56,14 @@ private:
 	static vk::Device vkDevice;
 	static VmaAllocator vmaAllocator;
 
-	static vk::Queue vkTransferQueue;
-	static vk::CommandPool vkCommandPool;
+	// One descriptor set per frame in flight, so sets of frames still executing on GPU are never written
+	static DescriptorSetArray descriptorSetArray;
 
-	static StagingBuffer stagingBuffer;
+	// Image view every descriptor should point to and descriptors of each set not pointing to it yet
+	static std::vector<vk::ImageView> descriptorImageViews;
+	static std::vector<std::vector<uint32_t>> pendingDescriptorIndices;
 
-	static DescriptorSetArray descriptorSetArray;
+	static uint framesInFlightCount;
 
 	static vk::Sampler vkSampler;
 
@@ -63,6 +83,17 @@ public:
 	static void postCreate(Handle& handle);
 	static void update(Handle& handle);
 
+	// Writes regions into existing texture without recreating it, mip levels are not regenerated. Previous contents
+	// are discarded if requested, which is also required for the first write into texture created without pixel data.
+	// Regions are uploaded asynchronously, a texture without earlier contents samples fallback texture until its
+	// upload is complete.
+	[[nodiscard]] static int updateRegions(const Handle& handle, const std::vector<TextureRegion>& regions,
+										   bool discardContents = false);
+
+	// Writes descriptors changed since the set of given frame in flight was last updated. Has to be called once per
+	// frame after frame's fence is waited on and before its rendering commands are recorded.
+	static void updateDescriptorSet(uint frameIndex);
+
 
 	static inline void setVkDevice(vk::Device device) {
 		vkDevice = device;
@@ -72,13 +103,8 @@ public:
 		vmaAllocator = allocator;
 	}
 
-	static inline void setVkTransferQueue(vk::Queue queue) {
-		vkTransferQueue = queue;
-	}
-
-	// FIXME: create own command pool
-	static inline void setVkCommandPool(vk::CommandPool commandPool) {
-		vkCommandPool = commandPool;
+	static inline void setFramesInFlightCount(uint count) {
+		framesInFlightCount = count;
 	}
 
 
@@ -86,9 +112,20 @@ public:
 		return textureInfos[handle.getIndex()];
 	}
 
+	// Tells whether the last upload into texture is complete and its descriptor points to it
+	static inline bool isUploadComplete(const Handle& handle) {
+		return UploadManager::isComplete(textureInfos[handle.getIndex()].uploadBatchId);
+	}
+
+
+	// Shared repeating linear sampler
+	static inline vk::Sampler getVkSampler() {
+		return vkSampler;
+	}
+
 
-	static inline auto getVkDescriptorSet() {
-		return descriptorSetArray.getVkDescriptorSet(0);
+	static inline auto getVkDescriptorSet(uint frameIndex) {
+		return descriptorSetArray.getVkDescriptorSet(frameIndex);
 	}
 
 	static inline auto getVkDescriptorSetLayout() {
@@ -106,5 +143,17 @@ private:
 
 	// Destroys resource given it's index
 	static void destroy(uint32_t index);
+
+	// Records layout transition of given mip levels of all layers. Stages and accesses outside of transfer are limited
+	// to ones supported by transfer queue unless graphics stream is used.
+	static void recordLayoutTransition(vk::CommandBuffer commandBuffer, UploadManager::Stream stream,
+									   const TextureInfo& textureInfo, uint baseMipLevel, uint levelCount,
+									   vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+
+	// Queues descriptor of texture to point to given image view in every set
+	static void setDescriptor(uint32_t index, vk::ImageView imageView);
+
+	// Points descriptor of texture to its image view once given stream completes current batch
+	static void publishOnComplete(UploadManager::Stream stream, uint32_t index);
 };
 } // namespace Engine
\ No newline at end of file
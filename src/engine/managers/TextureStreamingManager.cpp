@@ -0,0 +1,178 @@
+#include "TextureStreamingManager.hpp"
+
+#include "engine/graphics/CookedTextureFile.hpp"
+
+#include "engine/utils/Importer.hpp"
+
+#include <spdlog/spdlog.h>
+
+
+namespace Engine {
+std::list<TextureStreamingManager::Request> TextureStreamingManager::requests {};
+
+std::unordered_map<uint32_t, TextureStreamingManager::Status> TextureStreamingManager::statuses {};
+
+ThreadPool TextureStreamingManager::threadPool {};
+
+TextureStreamingManager::Properties TextureStreamingManager::properties {};
+
+
+int TextureStreamingManager::init() {
+	spdlog::info("Initializing TextureStreamingManager...");
+
+	threadPool.init(loadThreadFunc, std::max<uint>(properties.textureStreamingThreadCount, 1));
+
+	return 0;
+}
+
+
+TextureManager::Handle TextureStreamingManager::request(std::string name, std::string filename,
+														std::string cookedFilename, vk::Format format,
+														Callback callback) {
+	spdlog::info("Streaming texture '{}'...", filename);
+
+	auto& request		   = requests.emplace_back();
+	request.handle		   = TextureManager::createObject<Texture2D>(name);
+	request.filename	   = filename;
+	request.cookedFilename = cookedFilename;
+	request.format		   = format;
+	request.callback	   = std::move(callback);
+
+	statuses[request.handle.getId()] = Status::LOADING;
+
+	threadPool.appendData(&request);
+
+	return request.handle;
+}
+
+void TextureStreamingManager::update() {
+	const uint64_t uploadBudget = uint64_t(properties.textureStreamingUploadBudget) * 1024 * 1024;
+
+	uint64_t uploadedSize = 0;
+
+	for (auto it = requests.begin(); it != requests.end();) {
+		auto& request = *it;
+		auto& status  = statuses[request.handle.getId()];
+
+		if (status == Status::LOADING && request.isLoaded.load(std::memory_order_acquire)) {
+			if (uploadedSize > 0 && uploadedSize >= uploadBudget) {
+				it++;
+				continue;
+			}
+
+			if (request.result || upload(request)) {
+				status = Status::FAILED;
+			} else {
+				status = Status::UPLOADING;
+
+				for (const auto& pixels : request.levelPixels) {
+					uploadedSize += pixels.size();
+				}
+			}
+
+			// Pixels are staged already
+			request.levelPixels = {};
+		}
+
+		if (status == Status::UPLOADING && TextureManager::isUploadComplete(request.handle)) {
+			status = Status::READY;
+		}
+
+		if (status == Status::READY || status == Status::FAILED) {
+			if (request.callback) {
+				request.callback(request.handle, status);
+			}
+
+			statuses.erase(request.handle.getId());
+			it = requests.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+TextureStreamingManager::Status TextureStreamingManager::getStatus(const TextureManager::Handle& handle) {
+	auto it = statuses.find(handle.getId());
+	if (it == statuses.end()) {
+		return Status::NONE;
+	}
+
+	return it->second;
+}
+
+
+int TextureStreamingManager::upload(Request& request) {
+	const auto& levelExtents = request.levelExtents;
+
+	std::vector<TextureManager::TextureRegion> regions(request.levelPixels.size());
+
+	for (uint level = 0; level < regions.size(); level++) {
+		auto& region	= regions[level];
+		region.mipLevel = level;
+		region.extent	= levelExtents[level];
+		region.pData	= request.levelPixels[level].data();
+		region.size		= request.levelPixels[level].size();
+	}
+
+	// Texture is created without pixel data, mip levels averaged by loading thread are written afterwards, so that
+	// no blits are needed and upload may run on transfer queue
+	request.handle.apply<Texture2D>([&](auto& texture) {
+		texture.size = vk::Extent3D(levelExtents[0].width, levelExtents[0].height, 1);
+
+		texture.format		= request.format;
+		texture.usage		= vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+		texture.imageAspect = vk::ImageAspectFlagBits::eColor;
+
+		texture.useMipMapping = true;
+
+		texture.releasePixelData();
+	});
+	request.handle.update();
+
+	if (TextureManager::updateRegions(request.handle, regions, true)) {
+		spdlog::error("[TextureStreamingManager] Failed to upload '{}'", request.filename);
+		return 1;
+	}
+
+	return 0;
+}
+
+void TextureStreamingManager::loadThreadFunc(uint threadIndex, void* pData) {
+	auto& request = *static_cast<Request*>(pData);
+
+	const bool isCooked = !request.cookedFilename.empty();
+
+	// Cooked file which can not be read is written again from source
+	if (isCooked &&
+		Importer::isCookedFileUpToDate(request.filename, request.cookedFilename, CookedTextureFile::MAGIC,
+									   CookedTextureFile::VERSION) &&
+		!Importer::loadCookedTextureMipLevels(request.cookedFilename, request.format, request.levelPixels,
+											  request.levelExtents)) {
+		request.isLoaded.store(true, std::memory_order_release);
+		return;
+	}
+
+	request.levelPixels.clear();
+	request.levelExtents.clear();
+
+	request.result =
+		Importer::loadTextureMipLevels(request.filename, request.format, request.levelPixels, request.levelExtents);
+
+	// Texture is streamed anyway, it is simply decoded again next session
+	if (!request.result && isCooked &&
+		Importer::writeCookedTexture(request.cookedFilename, request.format, request.levelPixels,
+									 request.levelExtents)) {
+		spdlog::warn("[TextureStreamingManager] Failed to cook '{}'", request.cookedFilename);
+	}
+
+	request.isLoaded.store(true, std::memory_order_release);
+}
+
+
+void TextureStreamingManager::dispose() {
+	threadPool.terminate();
+
+	requests.clear();
+	statuses.clear();
+}
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "engine/managers/ConfigManager.hpp"
+#include "engine/managers/TextureManager.hpp"
+
+#include "engine/utils/ThreadPool.hpp"
+
+#define VULKAN_HPP_NO_EXCEPTIONS 1
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Engine {
+// Loads textures requested during a session without stalling the frame. Cooked files are read, or images are decoded
+// and their mip chains are averaged, on background threads. Loaded textures are uploaded through transfer stream from
+// update within a per frame budget. Descriptor of a requested texture points to fallback texture until its upload is
+// complete.
+class TextureStreamingManager {
+public:
+	enum class Status : uint8_t {
+		// Texture is not being streamed, either it was not requested or its final status was passed to callback
+		NONE,
+		LOADING,
+		UPLOADING,
+		READY,
+		FAILED,
+	};
+
+	// Called from update once texture is ready to be sampled or failed to load
+	using Callback = std::function<void(const TextureManager::Handle& handle, Status status)>;
+
+
+private:
+	struct Request {
+		TextureManager::Handle handle {};
+
+		std::string filename {};
+		std::string cookedFilename {};
+		vk::Format format {};
+
+		Callback callback {};
+
+		// Written by loading thread before isLoaded is set
+		std::vector<std::vector<uint8_t>> levelPixels {};
+		std::vector<vk::Extent2D> levelExtents {};
+		int result {};
+
+		std::atomic<bool> isLoaded {};
+	};
+
+	// Requests are referenced by loading threads, so they are not moved until complete
+	static std::list<Request> requests;
+
+	// Statuses of textures being streamed by object id, erased once request completes
+	static std::unordered_map<uint32_t, Status> statuses;
+
+	static ThreadPool threadPool;
+
+	struct Properties {
+		PROPERTY(uint, "Graphics", textureStreamingThreadCount, 2);
+
+		// Pixel data staged per frame in megabytes, at least one texture is uploaded every frame
+		PROPERTY(uint, "Graphics", textureStreamingUploadBudget, 16);
+	};
+
+	static Properties properties;
+
+
+public:
+	static int init();
+
+	// Creates texture object and queues its loading. Only 8 bit RGBA formats are supported. Texture is read from
+	// cooked file if it is up to date, otherwise source is decoded and cooked file is written from it. Empty cooked
+	// filename disables cooking.
+	static TextureManager::Handle request(std::string name, std::string filename, std::string cookedFilename,
+										  vk::Format format, Callback callback = {});
+
+	// Uploads loaded textures and completes uploaded ones. Has to be called once per frame before uploads are
+	// submitted.
+	static void update();
+
+	static Status getStatus(const TextureManager::Handle& handle);
+
+
+	static void dispose();
+
+
+private:
+	TextureStreamingManager() {
+	}
+
+	// Creates texture image and records upload of its mip levels
+	[[nodiscard]] static int upload(Request& request);
+
+	static void loadThreadFunc(uint threadIndex, void* pData);
+};
+} // namespace Engine
\ No newline at end of file
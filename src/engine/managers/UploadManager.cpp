@@ -0,0 +1,388 @@
+#include "UploadManager.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace Engine {
+vk::Device UploadManager::vkDevice {};
+VmaAllocator UploadManager::vmaAllocator {};
+
+std::array<UploadManager::StreamInfo, UploadManager::STREAM_COUNT> UploadManager::streamInfos {};
+
+std::vector<uint32_t> UploadManager::queueFamilyIndices {};
+
+StagingBuffer UploadManager::stagingBuffer {};
+
+std::deque<std::pair<UploadManager::Stream, uint>> UploadManager::submittedBatches {};
+uint64_t UploadManager::submittedStagingPosition {};
+
+uint64_t UploadManager::nextBatchId = 1;
+
+UploadManager::Properties UploadManager::properties {};
+
+
+int UploadManager::init() {
+	spdlog::info("Initializing UploadManager...");
+
+	assert(vkDevice != vk::Device());
+	assert(vmaAllocator != nullptr);
+
+	const auto& graphicsStreamInfo = streamInfos[uint(Stream::GRAPHICS)];
+	const auto& transferStreamInfo = streamInfos[uint(Stream::TRANSFER)];
+
+	assert(graphicsStreamInfo.queue != vk::Queue());
+	assert(transferStreamInfo.queue != vk::Queue());
+
+	queueFamilyIndices = { graphicsStreamInfo.queueFamilyIndex };
+	if (transferStreamInfo.queueFamilyIndex != graphicsStreamInfo.queueFamilyIndex) {
+		queueFamilyIndices.push_back(transferStreamInfo.queueFamilyIndex);
+	}
+
+	if (hasDedicatedTransferQueue()) {
+		spdlog::info("[UploadManager] Using dedicated transfer queue family {}", transferStreamInfo.queueFamilyIndex);
+	}
+
+
+	const vk::DeviceSize stagingBufferSize = vk::DeviceSize(properties.uploadStagingBufferSize) * 1024 * 1024;
+	if (stagingBuffer.init(vmaAllocator, stagingBufferSize)) {
+		return 1;
+	}
+
+	submittedStagingPosition = 0;
+
+
+	// Create batches
+
+	const uint batchCount = std::max<uint>(properties.uploadBatchCount, 1);
+
+	for (auto& streamInfo : streamInfos) {
+		vk::CommandPoolCreateInfo commandPoolCreateInfo {};
+		commandPoolCreateInfo.flags =
+			vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+		commandPoolCreateInfo.queueFamilyIndex = streamInfo.queueFamilyIndex;
+
+		auto result = vkDevice.createCommandPool(&commandPoolCreateInfo, nullptr, &streamInfo.commandPool);
+		if (result != vk::Result::eSuccess) {
+			spdlog::error("[UploadManager] Failed to create command pool. Error code: {} ({})", result,
+						  vk::to_string(result));
+			return 1;
+		}
+
+		std::vector<vk::CommandBuffer> commandBuffers(batchCount);
+
+		vk::CommandBufferAllocateInfo commandBufferAllocateInfo {};
+		commandBufferAllocateInfo.level				 = vk::CommandBufferLevel::ePrimary;
+		commandBufferAllocateInfo.commandPool		 = streamInfo.commandPool;
+		commandBufferAllocateInfo.commandBufferCount = batchCount;
+
+		result = vkDevice.allocateCommandBuffers(&commandBufferAllocateInfo, commandBuffers.data());
+		if (result != vk::Result::eSuccess) {
+			spdlog::error("[UploadManager] Failed to allocate command buffers. Error code: {} ({})", result,
+						  vk::to_string(result));
+			return 1;
+		}
+
+		streamInfo.batches.resize(batchCount);
+		streamInfo.currentBatchIndex = 0;
+
+		for (uint batchIndex = 0; batchIndex < batchCount; batchIndex++) {
+			auto& batch			= streamInfo.batches[batchIndex];
+			batch.commandBuffer = commandBuffers[batchIndex];
+
+			vk::FenceCreateInfo fenceCreateInfo {};
+
+			result = vkDevice.createFence(&fenceCreateInfo, nullptr, &batch.fence);
+			if (result != vk::Result::eSuccess) {
+				spdlog::error("[UploadManager] Failed to create fence. Error code: {} ({})", result,
+							  vk::to_string(result));
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+int UploadManager::update() {
+	if (flush()) {
+		return 1;
+	}
+
+	bool isRetired = true;
+	while (isRetired) {
+		if (retireBatch(false, isRetired)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int UploadManager::flush() {
+	std::vector<Stream> recordedStreams {};
+
+	for (uint streamIndex = 0; streamIndex < STREAM_COUNT; streamIndex++) {
+		const auto& streamInfo = streamInfos[streamIndex];
+		if (streamInfo.batches.empty()) {
+			continue;
+		}
+
+		const auto& batch = streamInfo.batches[streamInfo.currentBatchIndex];
+
+		if (batch.id != 0 && !batch.isSubmitted) {
+			recordedStreams.push_back(Stream(streamIndex));
+		}
+	}
+
+	if (recordedStreams.empty()) {
+		return 0;
+	}
+
+	stagingBuffer.flush();
+
+	for (uint i = 0; i < recordedStreams.size(); i++) {
+		auto& streamInfo = streamInfos[uint(recordedStreams[i])];
+		auto& batch		 = streamInfo.batches[streamInfo.currentBatchIndex];
+
+		// Copied data is made available to any later access, on graphics queue this also orders it with rendering
+		vk::MemoryBarrier memoryBarrier {};
+		memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		memoryBarrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+
+		batch.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+											vk::PipelineStageFlagBits::eAllCommands, {}, 1, &memoryBarrier, 0, nullptr,
+											0, nullptr);
+
+		auto result = batch.commandBuffer.end();
+		if (result != vk::Result::eSuccess) {
+			spdlog::error("[UploadManager] Failed to record upload command buffer. Error code: {} ({})", result,
+						  vk::to_string(result));
+			return 1;
+		}
+
+		vk::SubmitInfo submitInfo {};
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers	  = &batch.commandBuffer;
+
+		result = streamInfo.queue.submit(1, &submitInfo, batch.fence);
+		if (result != vk::Result::eSuccess) {
+			spdlog::error("[UploadManager] Failed to submit upload command buffer. Error code: {} ({})", result,
+						  vk::to_string(result));
+			return 1;
+		}
+
+		// Batches of one flush share staged data, it is released with the last of them as they complete in order
+		if (i + 1 == recordedStreams.size()) {
+			submittedStagingPosition = stagingBuffer.getHead();
+		}
+
+		batch.isSubmitted	  = true;
+		batch.stagingPosition = submittedStagingPosition;
+
+		submittedBatches.push_back({ recordedStreams[i], streamInfo.currentBatchIndex });
+
+		streamInfo.currentBatchIndex = (streamInfo.currentBatchIndex + 1) % streamInfo.batches.size();
+	}
+
+	return 0;
+}
+
+int UploadManager::wait(uint64_t batchId) {
+	if (flush()) {
+		return 1;
+	}
+
+	while (!submittedBatches.empty() && (batchId == 0 || !isComplete(batchId))) {
+		bool isRetired;
+		if (retireBatch(true, isRetired)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void UploadManager::dispose() {
+	if (vkDevice == vk::Device()) {
+		return;
+	}
+
+	if (wait()) {
+		spdlog::warn("[UploadManager] Failed to wait for uploads to complete");
+	}
+
+	for (auto& streamInfo : streamInfos) {
+		for (auto& batch : streamInfo.batches) {
+			vkDevice.destroyFence(batch.fence);
+		}
+		streamInfo.batches.clear();
+
+		if (streamInfo.commandPool != vk::CommandPool()) {
+			vkDevice.destroyCommandPool(streamInfo.commandPool);
+			streamInfo.commandPool = vk::CommandPool();
+		}
+	}
+
+	stagingBuffer.dispose();
+}
+
+
+int UploadManager::stage(const void* pData, uint64_t size, vk::DeviceSize& offset) {
+	if (size > stagingBuffer.getSize()) {
+		spdlog::error("[UploadManager] Failed to stage {} bytes: staging buffer is too small", size);
+		return 1;
+	}
+
+	while (stagingBuffer.allocate(size, STAGING_ALIGNMENT, offset)) {
+		// Ring is full of data of recorded and pending batches, space is released as they complete
+		if (flush()) {
+			return 1;
+		}
+
+		if (submittedBatches.empty()) {
+			spdlog::error("[UploadManager] Failed to stage {} bytes: staging buffer is full", size);
+			return 1;
+		}
+
+		bool isRetired;
+		if (retireBatch(true, isRetired)) {
+			return 1;
+		}
+	}
+
+	stagingBuffer.write(offset, pData, size);
+
+	return 0;
+}
+
+int UploadManager::uploadBuffer(vk::Buffer dstBuffer, vk::DeviceSize dstOffset, const void* pData,
+								vk::DeviceSize size) {
+	vk::DeviceSize stagingOffset;
+	if (stage(pData, size, stagingOffset)) {
+		return 1;
+	}
+
+	vk::CommandBuffer commandBuffer;
+	if (getCommandBuffer(Stream::TRANSFER, commandBuffer)) {
+		return 1;
+	}
+
+	vk::BufferCopy bufferCopy {};
+	bufferCopy.srcOffset = stagingOffset;
+	bufferCopy.dstOffset = dstOffset;
+	bufferCopy.size		 = size;
+	commandBuffer.copyBuffer(stagingBuffer.getVkBuffer(), dstBuffer, 1, &bufferCopy);
+
+	return 0;
+}
+
+int UploadManager::getCommandBuffer(Stream stream, vk::CommandBuffer& commandBuffer) {
+	auto& streamInfo = streamInfos[uint(stream)];
+	auto& batch		 = streamInfo.batches[streamInfo.currentBatchIndex];
+
+	// All batches of stream are in flight, the oldest one is reused
+	while (batch.isSubmitted) {
+		bool isRetired;
+		if (retireBatch(true, isRetired)) {
+			return 1;
+		}
+	}
+
+	if (batch.id == 0) {
+		vk::CommandBufferBeginInfo commandBufferBeginInfo {};
+		commandBufferBeginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+		auto result = batch.commandBuffer.begin(&commandBufferBeginInfo);
+		if (result != vk::Result::eSuccess) {
+			spdlog::error("[UploadManager] Failed to record upload command buffer. Error code: {} ({})", result,
+						  vk::to_string(result));
+			return 1;
+		}
+
+		batch.id = nextBatchId++;
+	}
+
+	commandBuffer = batch.commandBuffer;
+
+	return 0;
+}
+
+void UploadManager::onComplete(Stream stream, std::function<void()> callback) {
+	auto& streamInfo = streamInfos[uint(stream)];
+	auto& batch		 = streamInfo.batches[streamInfo.currentBatchIndex];
+
+	assert(batch.id != 0 && !batch.isSubmitted);
+
+	batch.callbacks.push_back(std::move(callback));
+}
+
+bool UploadManager::isComplete(uint64_t batchId) {
+	for (const auto& streamInfo : streamInfos) {
+		for (const auto& batch : streamInfo.batches) {
+			if (batch.id == batchId && batchId != 0) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+int UploadManager::retireBatch(bool waitForFence, bool& isRetired) {
+	isRetired = false;
+
+	if (submittedBatches.empty()) {
+		return 0;
+	}
+
+	const auto [stream, batchIndex] = submittedBatches.front();
+
+	auto& batch = streamInfos[uint(stream)].batches[batchIndex];
+
+	vk::Result result;
+	if (waitForFence) {
+		result = vkDevice.waitForFences(1, &batch.fence, true, UINT64_MAX);
+	} else {
+		result = vkDevice.getFenceStatus(batch.fence);
+		if (result == vk::Result::eNotReady) {
+			return 0;
+		}
+	}
+
+	if (result != vk::Result::eSuccess) {
+		spdlog::error("[UploadManager] Failed to wait for upload batch. Error code: {} ({})", result,
+					  vk::to_string(result));
+		return 1;
+	}
+
+	result = vkDevice.resetFences(1, &batch.fence);
+	if (result != vk::Result::eSuccess) {
+		spdlog::error("[UploadManager] Failed to reset fence. Error code: {} ({})", result, vk::to_string(result));
+		return 1;
+	}
+
+	stagingBuffer.release(batch.stagingPosition);
+
+	// Batch is reset before callbacks are called, so they observe it as complete
+	auto callbacks = std::move(batch.callbacks);
+
+	batch.callbacks.clear();
+	batch.id		  = 0;
+	batch.isSubmitted = false;
+
+	submittedBatches.pop_front();
+
+	for (const auto& callback : callbacks) {
+		callback();
+	}
+
+	isRetired = true;
+
+	return 0;
+}
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "engine/graphics/StagingBuffer.hpp"
+
+#include "engine/managers/ConfigManager.hpp"
+
+#define VULKAN_HPP_NO_EXCEPTIONS 1
+#include <vulkan/vulkan.hpp>
+
+#include "vk_mem_alloc.h"
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <vector>
+
+
+namespace Engine {
+// Uploads data to GPU resources without waiting for it. Data is copied into a persistently mapped staging ring and
+// copies are recorded into batches, which are submitted together once per frame or whenever ring runs out of space.
+// Completion of each batch is tracked with a fence, callbacks registered for a batch are called from update once it
+// is complete. Resources shared between queues have to be created with concurrent sharing among queue families
+// returned by getQueueFamilyIndices. Has to be used from main thread only.
+class UploadManager {
+public:
+	// Transfer stream runs on a dedicated transfer queue if device has one, so it is only suitable for resources not
+	// in use by rendering yet. Graphics stream is submitted to graphics queue before the frame and is ordered with it,
+	// it is used to overwrite data in use and for commands transfer queue does not support, such as blits.
+	enum class Stream : uint8_t {
+		TRANSFER,
+		GRAPHICS,
+	};
+
+	static constexpr uint STREAM_COUNT = 2;
+
+	// Alignment of staged data, satisfies buffer to image copy offset requirements of every format
+	static constexpr uint64_t STAGING_ALIGNMENT = 16;
+
+
+private:
+	struct Batch {
+		vk::CommandBuffer commandBuffer {};
+		vk::Fence fence {};
+
+		// Zero if batch is neither recorded nor pending
+		uint64_t id {};
+		bool isSubmitted {};
+
+		// Staging ring position released once batch is complete
+		uint64_t stagingPosition {};
+
+		std::vector<std::function<void()>> callbacks {};
+	};
+
+	struct StreamInfo {
+		vk::Queue queue {};
+		uint32_t queueFamilyIndex {};
+
+		vk::CommandPool commandPool {};
+
+		std::vector<Batch> batches {};
+
+		// Batch being recorded or the next one to record
+		uint currentBatchIndex {};
+	};
+
+	static vk::Device vkDevice;
+	static VmaAllocator vmaAllocator;
+
+	static std::array<StreamInfo, STREAM_COUNT> streamInfos;
+
+	static std::vector<uint32_t> queueFamilyIndices;
+
+	static StagingBuffer stagingBuffer;
+
+	// Submitted batches in submission order, as stream and batch indices
+	static std::deque<std::pair<Stream, uint>> submittedBatches;
+
+	// Staging ring position up to which data of submitted batches reaches
+	static uint64_t submittedStagingPosition;
+
+	static uint64_t nextBatchId;
+
+	struct Properties {
+		// Size in megabytes, limits size of a single upload
+		PROPERTY(uint, "Graphics", uploadStagingBufferSize, 64);
+
+		// Batches in flight per stream before recording has to wait for the oldest one
+		PROPERTY(uint, "Graphics", uploadBatchCount, 4);
+	};
+
+	static Properties properties;
+
+
+public:
+	static int init();
+
+	// Submits recorded batches and completes finished ones. Has to be called once per frame before rendering commands
+	// are submitted.
+	static int update();
+
+	// Submits batches recorded into so far
+	static int flush();
+
+	// Waits for given batch, or every batch if id is zero, and completes it along with all batches submitted before
+	static int wait(uint64_t batchId = 0);
+
+	// Waits for all uploads and destroys staging resources
+	static void dispose();
+
+
+	// Copies data into staging ring, flushing and waiting for older batches if it is full. Staged data is valid for
+	// commands recorded into current batches, which may be submitted by staging, so command buffer has to be requested
+	// after data recorded into it is staged.
+	[[nodiscard]] static int stage(const void* pData, uint64_t size, vk::DeviceSize& offset);
+
+	// Records copy of data into buffer range on transfer stream, range must not be in use by GPU
+	[[nodiscard]] static int uploadBuffer(vk::Buffer dstBuffer, vk::DeviceSize dstOffset, const void* pData,
+										  vk::DeviceSize size);
+
+	// Returns command buffer of current batch of a stream, beginning it if needed
+	[[nodiscard]] static int getCommandBuffer(Stream stream, vk::CommandBuffer& commandBuffer);
+
+	// Identifier of current batch of a stream, valid once command buffer was requested
+	static inline uint64_t getBatchId(Stream stream) {
+		const auto& streamInfo = streamInfos[uint(stream)];
+		return streamInfo.batches[streamInfo.currentBatchIndex].id;
+	}
+
+	// Registers callback called once current batch of a stream is complete
+	static void onComplete(Stream stream, std::function<void()> callback);
+
+	static bool isComplete(uint64_t batchId);
+
+
+	static inline void setVkDevice(vk::Device device) {
+		vkDevice = device;
+	}
+
+	static inline void setVulkanMemoryAllocator(VmaAllocator allocator) {
+		vmaAllocator = allocator;
+	}
+
+	static inline void setVkGraphicsQueue(vk::Queue queue, uint32_t queueFamilyIndex) {
+		streamInfos[uint(Stream::GRAPHICS)].queue			 = queue;
+		streamInfos[uint(Stream::GRAPHICS)].queueFamilyIndex = queueFamilyIndex;
+	}
+
+	// Graphics queue may be used if device has no dedicated transfer queue
+	static inline void setVkTransferQueue(vk::Queue queue, uint32_t queueFamilyIndex) {
+		streamInfos[uint(Stream::TRANSFER)].queue			 = queue;
+		streamInfos[uint(Stream::TRANSFER)].queueFamilyIndex = queueFamilyIndex;
+	}
+
+
+	// Distinct families of both streams, resources need concurrent sharing if there are several
+	static inline const std::vector<uint32_t>& getQueueFamilyIndices() {
+		return queueFamilyIndices;
+	}
+
+	static inline bool hasDedicatedTransferQueue() {
+		return queueFamilyIndices.size() > 1;
+	}
+
+	static inline vk::Buffer getVkStagingBuffer() {
+		return stagingBuffer.getVkBuffer();
+	}
+
+
+private:
+	UploadManager() {
+	}
+
+	// Completes oldest submitted batch, waiting for it if requested. Nothing is retired if it is not complete yet.
+	[[nodiscard]] static int retireBatch(bool waitForFence, bool& isRetired);
+};
+} // namespace Engine
\ No newline at end of file
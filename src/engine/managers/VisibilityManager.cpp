@@ -0,0 +1,398 @@
+#include "VisibilityManager.hpp"
+
+#include "EntityManager.hpp"
+#include "MeshManager.hpp"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+
+namespace Engine {
+std::vector<VisibilityManager::ViewInfo> VisibilityManager::viewInfos {};
+std::vector<VisibilityManager::ObjectInfo> VisibilityManager::objectInfos {};
+
+ThreadPool VisibilityManager::threadPool {};
+std::vector<VisibilityManager::CullThreadInfo> VisibilityManager::cullThreadInfos {};
+
+bool VisibilityManager::shadowCascadesEnabled {};
+
+VisibilityManager::OcclusionBuffer VisibilityManager::occlusionBuffer {};
+
+uint VisibilityManager::shadowMapSize {};
+
+VisibilityManager::Properties VisibilityManager::properties {};
+
+
+int VisibilityManager::init(uint threadCount, uint shadowMapSize) {
+	assert(threadCount > 0);
+	assert(shadowMapSize > 0);
+
+	const uint viewCount = VIEW_SHADOW_CASCADE_0 + properties.directionalLightCascadeCount;
+
+	if (viewCount > MAX_VIEW_COUNT) {
+		spdlog::error("Too many views requested for visibility culling ({} > {})", viewCount, MAX_VIEW_COUNT);
+		return 1;
+	}
+
+	viewInfos.resize(viewCount);
+
+	VisibilityManager::shadowMapSize = shadowMapSize;
+
+	threadPool.init(cullThreadFunc, threadCount);
+
+	cullThreadInfos.resize(threadCount * 2);
+
+	return 0;
+}
+
+
+void VisibilityManager::update() {
+	updateViews();
+
+	objectInfos.resize(EntityManager::getEntityCount());
+
+	for (auto& objectInfo : objectInfos) {
+		objectInfo.viewMask = 0;
+	}
+
+	for (uint i = 0; i < cullThreadInfos.size(); i++) {
+		cullThreadInfos[i].fragmentIndex = i;
+		cullThreadInfos[i].fragmentCount = cullThreadInfos.size();
+
+		threadPool.appendData(&cullThreadInfos[i]);
+	}
+
+	threadPool.waitForAll();
+}
+
+
+void VisibilityManager::updateViews() {
+	auto& cameraView = viewInfos[VIEW_CAMERA];
+
+	EntityManager::forEach<TransformComponent, CameraComponent>([&](const auto& transform, const auto& camera) {
+		// TODO: Check if active camera
+		auto viewVector = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+		viewVector		= glm::rotate(transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f)) * viewVector;
+		viewVector		= glm::rotate(transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f)) * viewVector;
+		viewVector		= glm::rotate(transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f)) * viewVector;
+
+		cameraView.position	 = transform.position;
+		cameraView.direction = glm::vec3(viewVector);
+
+		cameraView.viewMatrix = glm::lookAtLH(cameraView.position, cameraView.position + cameraView.direction,
+											  glm::vec3(0.0f, 1.0f, 0.0f));
+
+		cameraView.projectionMatrix = camera.getProjectionMatrix();
+
+		cameraView.pixelScale	 = cameraView.projectionMatrix[1][1] * camera.viewport.y * 0.5f;
+		cameraView.isPerspective = camera.isPerspective;
+	});
+
+	cameraView.frustum = cameraView.projectionMatrix * cameraView.viewMatrix;
+
+
+	shadowCascadesEnabled = false;
+
+	EntityManager::forEach<TransformComponent, LightComponent>([&](const auto& transform, auto& light) {
+		if (light.castsShadows && light.type == LightComponent::Type::DIRECTIONAL) {
+			auto lightDirection = glm::vec4(0.0f, -1.0f, 0.0f, 0.0f);
+			lightDirection		= glm::rotate(transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f)) * lightDirection;
+			lightDirection		= glm::rotate(transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f)) * lightDirection;
+			lightDirection		= glm::rotate(transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f)) * lightDirection;
+
+			for (uint cascade = 0; cascade < properties.directionalLightCascadeCount; cascade++) {
+				auto& cascadeView = viewInfos[VIEW_SHADOW_CASCADE_0 + cascade];
+
+				float cascadeHalfSize = properties.directionalLightCascadeBase * std::pow(2, cascade * 2 + 1);
+
+				cascadeView.position = cameraView.position +
+									   cascadeHalfSize * properties.directionalLightCascadeOffset * cameraView.direction;
+				cascadeView.direction = glm::vec3(lightDirection);
+
+				cascadeView.viewMatrix = glm::lookAtLH(cascadeView.position, cascadeView.position + cascadeView.direction,
+													   glm::vec3(0.0f, 1.0f, 0.0f));
+
+				cascadeView.projectionMatrix =
+					glm::orthoLH_ZO(-cascadeHalfSize, cascadeHalfSize, -cascadeHalfSize, cascadeHalfSize,
+									-cascadeHalfSize * 4.0f, cascadeHalfSize);
+
+				cascadeView.frustum = cascadeView.projectionMatrix * cascadeView.viewMatrix;
+
+				cascadeView.pixelScale	  = cascadeView.projectionMatrix[1][1] * shadowMapSize * 0.5f;
+				cascadeView.isPerspective = false;
+			}
+
+			light.shadowMapIndex = 0;
+
+			shadowCascadesEnabled = true;
+		}
+	});
+}
+
+
+void VisibilityManager::cullThreadFunc(uint threadIndex, void* pData) {
+	const auto& cullThreadInfo = *static_cast<CullThreadInfo*>(pData);
+
+	const auto& cameraFrustum = viewInfos[VIEW_CAMERA].frustum;
+
+	const uint cascadeCount = shadowCascadesEnabled ? properties.directionalLightCascadeCount : 0;
+
+	const bool testOcclusion = properties.occlusionCulling && occlusionBuffer.isValid;
+
+	EntityManager::forEachIndexed<TransformComponent, ModelComponent>(
+		[&](auto entityHandle, const auto& transform, const auto& model) {
+			auto& objectInfo = objectInfos[entityHandle.getIndex()];
+
+			objectInfo.transformMatrix = transform.getTransformMatrix();
+
+			// Missing levels repeat the last available one
+			uint lodCount = 1;
+			while (lodCount < MAX_LOD_COUNT && model.meshHandles[lodCount].getIndex() != 0) {
+				lodCount++;
+			}
+
+			// Levels are uploaded one at a time, ones not published yet are replaced by the nearest published level,
+			// preferring the coarser one
+			std::array<bool, MAX_LOD_COUNT> publishedFlags {};
+			bool hasPublishedLod = false;
+
+			for (uint lod = 0; lod < lodCount; lod++) {
+				publishedFlags[lod] = MeshManager::isPublished(model.meshHandles[lod].getIndex());
+				hasPublishedLod |= publishedFlags[lod];
+			}
+
+			if (!hasPublishedLod) {
+				objectInfo.viewMask = 0;
+				return;
+			}
+
+			for (uint lod = 0; lod < MAX_LOD_COUNT; lod++) {
+				const int targetLod = std::min(lod, lodCount - 1);
+
+				int nearestLod = targetLod;
+				for (int distance = 1; !publishedFlags[nearestLod]; distance++) {
+					if (targetLod + distance < static_cast<int>(lodCount) && publishedFlags[targetLod + distance]) {
+						nearestLod = targetLod + distance;
+					} else if (targetLod - distance >= 0 && publishedFlags[targetLod - distance]) {
+						nearestLod = targetLod - distance;
+					}
+				}
+
+				objectInfo.meshIndices[lod] = model.meshHandles[nearestLod].getIndex();
+			}
+
+			objectInfo.materialIndex = model.materialHandles[0].getIndex();
+			objectInfo.pipelineIndex = model.shaderHandles[0].getIndex();
+
+			const auto& meshInfo = MeshManager::getMeshInfo(objectInfo.meshIndices[0]);
+
+			const auto boundingBox	  = meshInfo.boundingBox.transform(objectInfo.transformMatrix);
+			const auto boundingSphere = BoundingSphere(boundingBox);
+
+			uint32_t viewMask = 0;
+
+			if (cameraFrustum.intersects(boundingBox)) {
+				const float pixelSize = getPixelSize(viewInfos[VIEW_CAMERA], boundingSphere);
+
+				if (pixelSize >= properties.lodMinPixelSize && !(testOcclusion && isOccluded(boundingBox))) {
+					viewMask |= 1 << VIEW_CAMERA;
+
+					auto& lodIndex = objectInfo.lodIndices[VIEW_CAMERA];
+					lodIndex	   = selectLod(pixelSize, lodCount, lodIndex);
+				}
+			}
+
+			// An object fully contained in a cascade is skipped by all following (larger) cascades
+			bool isContained = false;
+
+			for (uint cascade = 0; cascade < cascadeCount && !isContained; cascade++) {
+				const uint viewIndex = VIEW_SHADOW_CASCADE_0 + cascade;
+
+				const auto& cascadeView = viewInfos[viewIndex];
+
+				if (cascadeView.frustum.intersects(boundingBox)) {
+					const float pixelSize = getPixelSize(cascadeView, boundingSphere);
+
+					if (pixelSize >= properties.lodMinPixelSize) {
+						viewMask |= 1 << viewIndex;
+
+						auto& lodIndex = objectInfo.lodIndices[viewIndex];
+						lodIndex	   = selectLod(pixelSize, lodCount, lodIndex);
+					}
+
+					isContained = cascadeView.frustum.contains(boundingBox);
+				}
+			}
+
+			objectInfo.viewMask = viewMask;
+		},
+		cullThreadInfo.fragmentIndex, cullThreadInfo.fragmentCount);
+}
+
+
+void VisibilityManager::updateOcclusionBuffer(const float* pDepths, uint width, uint height,
+											  const glm::mat4& viewProjectionMatrix) {
+	if (!properties.occlusionCulling) {
+		return;
+	}
+
+	const uint levelCount = 1 + std::log2(std::max(width, height));
+
+	auto& levels	 = occlusionBuffer.levels;
+	auto& levelSizes = occlusionBuffer.levelSizes;
+
+	levels.resize(levelCount);
+	levelSizes.resize(levelCount);
+
+	levels[0].assign(pDepths, pDepths + width * height);
+	levelSizes[0] = { width, height };
+
+	for (uint level = 1; level < levelCount; level++) {
+		const auto& srcLevel = levels[level - 1];
+		const auto srcSize	 = levelSizes[level - 1];
+
+		auto& dstLevel = levels[level];
+		auto& dstSize  = levelSizes[level];
+
+		// Rounding up and clamping source coordinates keeps odd rows and columns covered
+		dstSize = { (srcSize.x + 1) / 2, (srcSize.y + 1) / 2 };
+		dstLevel.resize(dstSize.x * dstSize.y);
+
+		for (uint y = 0; y < dstSize.y; y++) {
+			const uint srcY0 = y * 2;
+			const uint srcY1 = std::min(srcY0 + 1, srcSize.y - 1);
+
+			for (uint x = 0; x < dstSize.x; x++) {
+				const uint srcX0 = x * 2;
+				const uint srcX1 = std::min(srcX0 + 1, srcSize.x - 1);
+
+				dstLevel[y * dstSize.x + x] =
+					std::max(std::max(srcLevel[srcY0 * srcSize.x + srcX0], srcLevel[srcY0 * srcSize.x + srcX1]),
+							 std::max(srcLevel[srcY1 * srcSize.x + srcX0], srcLevel[srcY1 * srcSize.x + srcX1]));
+			}
+		}
+	}
+
+	occlusionBuffer.viewProjectionMatrix = viewProjectionMatrix;
+	occlusionBuffer.isValid				 = true;
+}
+
+
+bool VisibilityManager::isOccluded(const BoundingBox& boundingBox) {
+	const auto& levels	   = occlusionBuffer.levels;
+	const auto& levelSizes = occlusionBuffer.levelSizes;
+
+	const auto size = glm::vec2(levelSizes[0]);
+
+	glm::vec2 minPosition { FLT_MAX };
+	glm::vec2 maxPosition { -FLT_MAX };
+	float minDepth = FLT_MAX;
+
+	for (const auto& point : boundingBox.points) {
+		const auto clipPosition = occlusionBuffer.viewProjectionMatrix * glm::vec4(point, 1.0f);
+
+		// Box crosses camera plane
+		if (clipPosition.w <= 0.0f) {
+			return false;
+		}
+
+		const auto ndcPosition = glm::vec3(clipPosition) / clipPosition.w;
+
+		// Viewport is flipped, first row of depth buffer is at the top of the screen
+		const auto position = glm::vec2(ndcPosition.x * 0.5f + 0.5f, 0.5f - ndcPosition.y * 0.5f) * size;
+
+		minPosition = glm::min(minPosition, position);
+		maxPosition = glm::max(maxPosition, position);
+		minDepth	= std::min(minDepth, ndcPosition.z);
+	}
+
+	minPosition = glm::max(minPosition, glm::vec2(0.0f));
+	maxPosition = glm::min(maxPosition, size - 1.0f);
+
+	if (minPosition.x > maxPosition.x || minPosition.y > maxPosition.y || minDepth < 0.0f) {
+		return false;
+	}
+
+	// Pick a level where the box covers at most 2x2 texels
+	const float extent = std::max(maxPosition.x - minPosition.x, maxPosition.y - minPosition.y);
+	const uint level   = std::min<uint>(std::ceil(std::log2(std::max(extent, 1.0f))), levels.size() - 1);
+
+	const auto& levelDepths = levels[level];
+	const auto levelSize	= levelSizes[level];
+
+	const uint x0 = std::min(uint(minPosition.x) >> level, levelSize.x - 1);
+	const uint y0 = std::min(uint(minPosition.y) >> level, levelSize.y - 1);
+	const uint x1 = std::min(uint(maxPosition.x) >> level, levelSize.x - 1);
+	const uint y1 = std::min(uint(maxPosition.y) >> level, levelSize.y - 1);
+
+	float maxDepth = 0.0f;
+
+	for (uint y = y0; y <= y1; y++) {
+		for (uint x = x0; x <= x1; x++) {
+			maxDepth = std::max(maxDepth, levelDepths[y * levelSize.x + x]);
+		}
+	}
+
+	return minDepth > maxDepth;
+}
+
+
+float VisibilityManager::getPixelSize(const ViewInfo& viewInfo, const BoundingSphere& boundingSphere) {
+	const float diameter = boundingSphere.radius * 2.0f * viewInfo.pixelScale;
+
+	if (!viewInfo.isPerspective) {
+		return diameter;
+	}
+
+	const float distance = glm::length(boundingSphere.center - viewInfo.position);
+
+	// Camera is inside of the sphere
+	if (distance <= boundingSphere.radius) {
+		return FLT_MAX;
+	}
+
+	return diameter / distance;
+}
+
+uint VisibilityManager::selectLod(float pixelSize, uint lodCount, uint previousLod) {
+	auto lodForSize = [&](float size) {
+		uint lod		= 0;
+		float threshold = properties.lodPixelSize;
+
+		while (lod + 1 < lodCount && size < threshold) {
+			lod++;
+			threshold *= properties.lodPixelSizeFactor;
+		}
+
+		return lod;
+	};
+
+	previousLod = std::min(previousLod, lodCount - 1);
+
+	const uint lod = lodForSize(pixelSize);
+
+	// Switch only after crossing a threshold by a margin, avoids popping back and forth around it
+	if (lod < previousLod) {
+		return std::min(lodForSize(pixelSize * (1.0f - properties.lodHysteresis)), previousLod);
+	}
+	if (lod > previousLod) {
+		return std::max(lodForSize(pixelSize * (1.0f + properties.lodHysteresis)), previousLod);
+	}
+
+	return lod;
+}
+
+
+void VisibilityManager::dispose() {
+	threadPool.terminate();
+
+	objectInfos.clear();
+	viewInfos.clear();
+
+	occlusionBuffer = {};
+}
+} // namespace Engine
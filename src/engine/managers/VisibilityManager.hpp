@@ -0,0 +1,176 @@
+#pragma once
+
+#include "engine/managers/ConfigManager.hpp"
+
+#include "engine/graphics/BoundingSphere.hpp"
+#include "engine/graphics/Frustum.hpp"
+
+#include "engine/utils/ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace Engine {
+// Computes all per-frame views (camera and directional light cascades) and culls every object against all of them in
+// a single traversal. Passes consume cached per-object view masks instead of culling on their own. Level of detail is
+// selected per view from projected bounding sphere size.
+class VisibilityManager {
+public:
+	static constexpr uint VIEW_CAMERA			  = 0;
+	static constexpr uint VIEW_SHADOW_CASCADE_0 = 1;
+
+	static constexpr uint MAX_VIEW_COUNT = 32;
+	static constexpr uint MAX_LOD_COUNT	 = 4;
+
+
+	struct ViewInfo {
+		glm::mat4 viewMatrix { 1.0f };
+		glm::mat4 projectionMatrix { 1.0f };
+
+		glm::vec3 position {};
+		glm::vec3 direction { 0.0f, 0.0f, 1.0f };
+
+		Frustum frustum {};
+
+		// Size in pixels of a unit length at unit distance for perspective views, at any distance otherwise
+		float pixelScale {};
+		bool isPerspective {};
+	};
+
+	struct ObjectInfo {
+		glm::mat4 transformMatrix {};
+
+		// Resource indices rather than handles, handle copies are not thread safe
+		std::array<uint32_t, MAX_LOD_COUNT> meshIndices {};
+		uint32_t materialIndex {};
+		uint32_t pipelineIndex {};
+
+		// Bit N is set if object is visible in view N
+		uint32_t viewMask {};
+
+		// Selected level of detail per view, kept between frames for hysteresis
+		std::array<uint8_t, MAX_VIEW_COUNT> lodIndices {};
+
+
+		inline uint32_t getMeshIndex(uint viewIndex) const {
+			return meshIndices[lodIndices[viewIndex]];
+		}
+	};
+
+
+private:
+	struct CullThreadInfo {
+		uint fragmentIndex;
+		uint fragmentCount;
+	};
+
+	// CPU side max depth pyramid built from a read back depth buffer
+	struct OcclusionBuffer {
+		// Level 0 is full resolution, each next level halves resolution
+		std::vector<std::vector<float>> levels {};
+		std::vector<glm::uvec2> levelSizes {};
+
+		// Camera view projection matrix depth buffer was rendered with
+		glm::mat4 viewProjectionMatrix {};
+
+		bool isValid {};
+	};
+
+
+	static std::vector<ViewInfo> viewInfos;
+
+	// Indexed by entity index, entities without a model have an empty view mask
+	static std::vector<ObjectInfo> objectInfos;
+
+	// Cascade views are only valid while there is a shadow casting directional light
+	static bool shadowCascadesEnabled;
+
+	static OcclusionBuffer occlusionBuffer;
+
+	static uint shadowMapSize;
+
+	static ThreadPool threadPool;
+	static std::vector<CullThreadInfo> cullThreadInfos;
+
+	struct Properties {
+		PROPERTY(uint, "Graphics", directionalLightCascadeCount, 3);
+
+		PROPERTY(float, "Graphics", directionalLightCascadeBase, 2.0f);
+		PROPERTY(float, "Graphics", directionalLightCascadeOffset, 0.75f);
+
+		PROPERTY(uint, "Graphics", occlusionCulling, 1);
+
+		// Projected size in pixels below which LOD 1 is used, each next LOD threshold is scaled by the factor
+		PROPERTY(float, "Graphics", lodPixelSize, 256.0f);
+		PROPERTY(float, "Graphics", lodPixelSizeFactor, 0.5f);
+
+		// Fraction of a threshold projected size has to cross before switching LOD back
+		PROPERTY(float, "Graphics", lodHysteresis, 0.1f);
+
+		// Objects smaller than that are not drawn at all
+		PROPERTY(float, "Graphics", lodMinPixelSize, 2.0f);
+
+		PROPERTY(uint, "Graphics", meshletCulling, 1);
+	};
+
+	static Properties properties;
+
+
+public:
+	static int init(uint threadCount, uint shadowMapSize);
+
+	// Recomputes views and visibility, has to be called once per frame before any pass consumes results
+	static void update();
+
+	// Replaces occlusion data with a read back of farthest depths rendered with given camera matrix
+	static void updateOcclusionBuffer(const float* pDepths, uint width, uint height,
+									  const glm::mat4& viewProjectionMatrix);
+
+
+	static inline uint getViewCount() {
+		return viewInfos.size();
+	}
+
+	static inline uint getShadowCascadeCount() {
+		return properties.directionalLightCascadeCount;
+	}
+
+	static inline bool isMeshletCullingEnabled() {
+		return properties.meshletCulling;
+	}
+
+	static inline bool areShadowCascadesEnabled() {
+		return shadowCascadesEnabled;
+	}
+
+	static inline const ViewInfo& getViewInfo(uint viewIndex) {
+		return viewInfos[viewIndex];
+	}
+
+	static inline const std::vector<ObjectInfo>& getObjectInfos() {
+		return objectInfos;
+	}
+
+
+	static void dispose();
+
+
+private:
+	VisibilityManager() {
+	}
+
+	static void updateViews();
+
+	static void cullThreadFunc(uint threadIndex, void* pData);
+
+	// Conservative test, returns false whenever occlusion can not be proven
+	static bool isOccluded(const BoundingBox& boundingBox);
+
+	static float getPixelSize(const ViewInfo& viewInfo, const BoundingSphere& boundingSphere);
+	static uint selectLod(float pixelSize, uint lodCount, uint previousLod);
+};
+} // namespace Engine
@@ -103,7 +103,7 @@ public:
 					   const vk::CommandBuffer* pSecondaryCommandBuffers, const vk::QueryPool& timestampQueryPool,
 					   double dt) = 0;
 
-	void dispose();
+	virtual void dispose();
 
 
 	inline uint getInputCount() const {
@@ -254,6 +254,11 @@ protected:
 		descriptorSetArrays[setId].updateBuffer(elementIndex, bindingId, pData, size);
 	}
 
+	inline void updateDescriptorSetImage(uint setId, uint bindingId, vk::Sampler sampler, vk::ImageView imageView) {
+		uint elementIndex = currentFrameInFlight * getLayerCount() + currentLayer;
+		descriptorSetArrays[setId].updateImage(elementIndex, bindingId, 0, sampler, imageView);
+	}
+
 
 	inline virtual std::vector<vk::SamplerCreateInfo> getInputVkSamplerCreateInfos() {
 		std::vector<vk::SamplerCreateInfo> samplerCreateInfos {};
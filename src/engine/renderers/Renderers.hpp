@@ -3,6 +3,7 @@
 #include "graphics/BoxBlurRenderer.hpp"
 #include "graphics/DepthNormalRenderer.hpp"
 #include "graphics/ForwardRenderer.hpp"
+#include "graphics/HiZRenderer.hpp"
 #include "graphics/ImGuiRenderer.hpp"
 #include "graphics/IrradianceMapRenderer.hpp"
 #include "graphics/PostFxRenderer.hpp"
@@ -12,4 +13,5 @@
 #include "graphics/SkymapRenderer.hpp"
 #include "graphics/VolumetricLightRenderer.hpp"
 
+#include "transfer/HiZReadbackRenderer.hpp"
 #include "transfer/MipMapRenderer.hpp"
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "DepthNormalRenderer.hpp"
 
-#include "engine/managers/EntityManager.hpp"
+#include "engine/managers/VisibilityManager.hpp"
 
 #include <glm/glm.hpp>
 
@@ -24,23 +24,12 @@ int DepthNormalRenderer::init() {
 
 void DepthNormalRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSecondaryCommandBuffers, double dt) {
 
-	glm::vec3 cameraPos;
-	CameraBlock cameraBlock;
-
-	EntityManager::forEach<TransformComponent, CameraComponent>([&](auto& transform, auto& camera) {
-		cameraPos = transform.position;
+	const auto& cameraView = VisibilityManager::getViewInfo(VisibilityManager::VIEW_CAMERA);
 
-		glm::vec4 viewVector = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
-		viewVector			 = glm::rotate(transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f)) * viewVector;
-		viewVector			 = glm::rotate(transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f)) * viewVector;
-		viewVector			 = glm::rotate(transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f)) * viewVector;
-
-		cameraBlock.viewMatrix =
-			glm::lookAtLH(transform.position, transform.position + glm::vec3(viewVector.x, viewVector.y, viewVector.z),
-						  glm::vec3(0.0f, 1.0f, 0.0f));
+	CameraBlock cameraBlock;
 
-		cameraBlock.projectionMatrix = camera.getProjectionMatrix();
-	});
+	cameraBlock.viewMatrix		 = cameraView.viewMatrix;
+	cameraBlock.projectionMatrix = cameraView.projectionMatrix;
 
 	cameraBlock.invViewMatrix		= glm::inverse(cameraBlock.viewMatrix);
 	cameraBlock.invProjectionMatrix = glm::inverse(cameraBlock.projectionMatrix);
@@ -53,22 +42,37 @@ void DepthNormalRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer*
 	uTerrainBlock.size		= terrainState.size;
 	uTerrainBlock.maxHeight = terrainState.maxHeight;
 
-	uTerrainBlock.textureHeight = terrainState.heightMapHandle.getIndex();
-	uTerrainBlock.textureNormal = terrainState.normalMapHandle.getIndex();
+	uTerrainBlock.clipmapLevels		= TerrainStreamingManager::getClipmapLevels();
+	uTerrainBlock.clipmapSize		= TerrainStreamingManager::getClipmapSize();
+	uTerrainBlock.clipmapLevelCount = TerrainStreamingManager::getClipmapLevelCount();
 
-	uTerrainBlock.texelSize		= 1.0f / terrainState.size;
 	uTerrainBlock.baseTessLevel = 16.0f;
 
+	uTerrainBlock.pixelScale	= cameraView.pixelScale;
+	uTerrainBlock.maxPixelError = TerrainRenderer::getMaxPixelError();
+	uTerrainBlock.isPerspective = cameraView.isPerspective;
+
 	updateDescriptorSet(1, 0, &uTerrainBlock);
 
+	if (TerrainStreamingManager::isLoaded()) {
+		updateDescriptorSetImage(1, 2, TextureManager::getVkSampler(),
+								 TextureManager::getTextureInfo(terrainState.heightClipmapHandle).imageView);
+		updateDescriptorSetImage(1, 3, TextureManager::getVkSampler(),
+								 TextureManager::getTextureInfo(terrainState.normalClipmapHandle).imageView);
+	}
+
 
 	const uint materialDescriptorSetId = descriptorSetArrays.size() + 1;
-	Frustum frustum { cameraBlock.projectionMatrix * cameraBlock.viewMatrix };
 
 	objectRenderer.drawObjects(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers, materialDescriptorSetId,
-							   &frustum, 1);
+							   VisibilityManager::VIEW_CAMERA);
+
+	auto& terrainPatches = terrainRenderer.updatePatches(cameraView.position, cameraView.frustum);
+	if (!terrainPatches.empty()) {
+		updateDescriptorSet(1, 1, terrainPatches.data(), terrainPatches.size() * sizeof(TerrainRenderer::Patch));
+	}
 
-	terrainRenderer.drawTerrain(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers, materialDescriptorSetId,
-								glm::vec2(cameraPos.x, cameraPos.z), frustum);
+	terrainRenderer.drawTerrain(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers,
+								materialDescriptorSetId);
 }
 } // namespace Engine
\ No newline at end of file
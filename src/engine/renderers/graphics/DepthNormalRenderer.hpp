@@ -5,6 +5,8 @@
 #include "ObjectRenderer.hpp"
 #include "TerrainRenderer.hpp"
 
+#include "engine/managers/TerrainStreamingManager.hpp"
+
 
 namespace Engine {
 class DepthNormalRenderer : public GraphicsRendererBase {
@@ -18,14 +20,19 @@ private:
 	};
 
 	struct TerrainBlock {
+		std::array<glm::vec4, TerrainStreamingManager::MAX_LEVEL_COUNT> clipmapLevels;
+
 		uint size;
 		uint maxHeight;
 
-		uint textureHeight;
-		uint textureNormal;
+		uint clipmapSize;
+		uint clipmapLevelCount;
 
-		float texelSize;
 		float baseTessLevel;
+
+		float pixelScale;
+		float maxPixelError;
+		uint isPerspective;
 	} uTerrainBlock;
 
 
@@ -97,6 +104,10 @@ public:
 		descriptorSetDescriptions.push_back({ 0, 0, vk::DescriptorType::eUniformBuffer, sizeof(CameraBlock) });
 
 		descriptorSetDescriptions.push_back({ 1, 0, vk::DescriptorType::eUniformBuffer, sizeof(TerrainBlock) });
+		descriptorSetDescriptions.push_back(
+			{ 1, 1, vk::DescriptorType::eStorageBuffer, TerrainRenderer::getPatchBufferSize() });
+		descriptorSetDescriptions.push_back({ 1, 2, vk::DescriptorType::eCombinedImageSampler, 0 });
+		descriptorSetDescriptions.push_back({ 1, 3, vk::DescriptorType::eCombinedImageSampler, 0 });
 
 		return descriptorSetDescriptions;
 	}
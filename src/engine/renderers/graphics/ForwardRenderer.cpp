@@ -1,6 +1,7 @@
 #include "ForwardRenderer.hpp"
 
 #include "engine/managers/EntityManager.hpp"
+#include "engine/managers/VisibilityManager.hpp"
 
 #include <glm/glm.hpp>
 
@@ -28,25 +29,10 @@ int ForwardRenderer::init() {
 
 void ForwardRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSecondaryCommandBuffers, double dt) {
 
-	glm::vec3 cameraPos;
-	glm::vec3 cameraViewDir;
+	const auto& cameraView = VisibilityManager::getViewInfo(VisibilityManager::VIEW_CAMERA);
 
-	EntityManager::forEach<TransformComponent, CameraComponent>([&](auto& transform, auto& camera) {
-		// TODO: Check if active camera
-		glm::vec4 viewVector = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
-		viewVector			 = glm::rotate(transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f)) * viewVector;
-		viewVector			 = glm::rotate(transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f)) * viewVector;
-		viewVector			 = glm::rotate(transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f)) * viewVector;
-
-		cameraPos	  = transform.position;
-		cameraViewDir = glm::vec3(viewVector);
-
-		uCameraBlock.viewMatrix =
-			glm::lookAtLH(transform.position, transform.position + glm::vec3(viewVector.x, viewVector.y, viewVector.z),
-						  glm::vec3(0.0f, 1.0f, 0.0f));
-
-		uCameraBlock.projectionMatrix = camera.getProjectionMatrix();
-	});
+	uCameraBlock.viewMatrix		  = cameraView.viewMatrix;
+	uCameraBlock.projectionMatrix = cameraView.projectionMatrix;
 
 	uCameraBlock.invViewMatrix		 = glm::inverse(uCameraBlock.viewMatrix);
 	uCameraBlock.invProjectionMatrix = glm::inverse(uCameraBlock.projectionMatrix);
@@ -70,18 +56,10 @@ void ForwardRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSe
 
 
 			for (uint cascadeIndex = 0; cascadeIndex < directionalLightCascadeCount; cascadeIndex++) {
-				float cascadeHalfSize = directionalLightCascadeBase * std::pow(2, cascadeIndex * 2 + 1);
-
-				glm::vec3 position = cameraPos + cascadeHalfSize * directionalLightCascadeOffset * cameraViewDir;
-
-				auto lightSpaceMatrix =
-					glm::lookAtLH(position, position + glm::vec3(lightDirection), glm::vec3(0.0f, 1.0f, 0.0f));
+				const auto& cascadeView =
+					VisibilityManager::getViewInfo(VisibilityManager::VIEW_SHADOW_CASCADE_0 + cascadeIndex);
 
-				lightSpaceMatrix = glm::orthoLH_ZO(-cascadeHalfSize, cascadeHalfSize, -cascadeHalfSize, cascadeHalfSize,
-												   -cascadeHalfSize * 4.0f, cascadeHalfSize) *
-								   lightSpaceMatrix;
-
-				uDirectionalLightMatrices[cascadeIndex] = lightSpaceMatrix;
+				uDirectionalLightMatrices[cascadeIndex] = cascadeView.projectionMatrix * cascadeView.viewMatrix;
 			}
 		}
 	});
@@ -95,22 +73,37 @@ void ForwardRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSe
 	uTerrainBlock.size		= terrainState.size;
 	uTerrainBlock.maxHeight = terrainState.maxHeight;
 
-	uTerrainBlock.textureHeight = terrainState.heightMapHandle.getIndex();
-	uTerrainBlock.textureNormal = terrainState.normalMapHandle.getIndex();
+	uTerrainBlock.clipmapLevels		= TerrainStreamingManager::getClipmapLevels();
+	uTerrainBlock.clipmapSize		= TerrainStreamingManager::getClipmapSize();
+	uTerrainBlock.clipmapLevelCount = TerrainStreamingManager::getClipmapLevelCount();
 
-	uTerrainBlock.texelSize		= 1.0f / terrainState.size;
 	uTerrainBlock.baseTessLevel = 16.0f;
 
+	uTerrainBlock.pixelScale	= cameraView.pixelScale;
+	uTerrainBlock.maxPixelError = TerrainRenderer::getMaxPixelError();
+	uTerrainBlock.isPerspective = cameraView.isPerspective;
+
 	updateDescriptorSet(2, 0, &uTerrainBlock);
 
+	if (TerrainStreamingManager::isLoaded()) {
+		updateDescriptorSetImage(2, 2, TextureManager::getVkSampler(),
+								 TextureManager::getTextureInfo(terrainState.heightClipmapHandle).imageView);
+		updateDescriptorSetImage(2, 3, TextureManager::getVkSampler(),
+								 TextureManager::getTextureInfo(terrainState.normalClipmapHandle).imageView);
+	}
+
 
 	const uint materialDescriptorSetId = descriptorSetArrays.size() + 1;
-	Frustum frustum { uCameraBlock.projectionMatrix * uCameraBlock.viewMatrix };
 
 	objectRenderer.drawObjects(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers, materialDescriptorSetId,
-							   &frustum, 1);
+							   VisibilityManager::VIEW_CAMERA);
+
+	auto& terrainPatches = terrainRenderer.updatePatches(cameraView.position, cameraView.frustum);
+	if (!terrainPatches.empty()) {
+		updateDescriptorSet(2, 1, terrainPatches.data(), terrainPatches.size() * sizeof(TerrainRenderer::Patch));
+	}
 
-	terrainRenderer.drawTerrain(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers, materialDescriptorSetId,
-								glm::vec2(cameraPos.x, cameraPos.z), frustum);
+	terrainRenderer.drawTerrain(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers,
+								materialDescriptorSetId);
 }
 } // namespace Engine
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "ObjectRenderer.hpp"
 #include "TerrainRenderer.hpp"
 
+#include "engine/managers/TerrainStreamingManager.hpp"
+
 
 namespace Engine {
 class ForwardRenderer : public GraphicsRendererBase {
@@ -43,14 +45,19 @@ private:
 	std::vector<glm::mat4> uDirectionalLightMatrices { directionalLightCascadeCount };
 
 	struct TerrainBlock {
+		std::array<glm::vec4, TerrainStreamingManager::MAX_LEVEL_COUNT> clipmapLevels;
+
 		uint size;
 		uint maxHeight;
 
-		uint textureHeight;
-		uint textureNormal;
+		uint clipmapSize;
+		uint clipmapLevelCount;
 
-		float texelSize;
 		float baseTessLevel;
+
+		float pixelScale;
+		float maxPixelError;
+		uint isPerspective;
 	} uTerrainBlock;
 
 
@@ -224,6 +231,10 @@ public:
 		descriptorSetDescriptions.push_back({ 1, 5, vk::DescriptorType::eStorageBuffer, spotLightsBlockSize });
 
 		descriptorSetDescriptions.push_back({ 2, 0, vk::DescriptorType::eUniformBuffer, sizeof(TerrainBlock) });
+		descriptorSetDescriptions.push_back(
+			{ 2, 1, vk::DescriptorType::eStorageBuffer, TerrainRenderer::getPatchBufferSize() });
+		descriptorSetDescriptions.push_back({ 2, 2, vk::DescriptorType::eCombinedImageSampler, 0 });
+		descriptorSetDescriptions.push_back({ 2, 3, vk::DescriptorType::eCombinedImageSampler, 0 });
 
 		return descriptorSetDescriptions;
 	}
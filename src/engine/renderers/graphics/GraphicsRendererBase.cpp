@@ -1,10 +1,14 @@
 #include "GraphicsRendererBase.hpp"
 
+#include "engine/graphics/PipelineCache.hpp"
+
 #include "engine/managers/GraphicsShaderManager.hpp"
 #include "engine/managers/MeshManager.hpp"
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 
 namespace Engine {
 int GraphicsRendererBase::init() {
@@ -33,6 +37,7 @@ int GraphicsRendererBase::render(const vk::CommandBuffer* pPrimaryCommandBuffers
 								 const vk::QueryPool& timestampQueryPool, double dt) {
 
 	currentFrameInFlight = (currentFrameInFlight + 1) % framesInFlightCount;
+	frameIndex++;
 
 	for (uint layerIndex = 0; layerIndex < getLayerCount(); layerIndex++) {
 		currentLayer = layerIndex;
@@ -88,7 +93,7 @@ int GraphicsRendererBase::render(const vk::CommandBuffer* pPrimaryCommandBuffers
 			bindDescriptorSets(secondaryCommandBuffer, vk::PipelineBindPoint::eGraphics,
 							   currentFrameInFlight * getLayerCount() + layerIndex);
 
-			const auto textureDescriptorSet		 = TextureManager::getVkDescriptorSet();
+			const auto textureDescriptorSet		 = TextureManager::getVkDescriptorSet(currentFrameInFlight);
 			const auto textureDescriptorSetIndex = descriptorSetArrays.size();
 
 			secondaryCommandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, vkPipelineLayout,
@@ -309,11 +314,26 @@ int GraphicsRendererBase::createFramebuffer() {
 }
 
 int GraphicsRendererBase::createGraphicsPipelines() {
-	constexpr auto shaderTypeCount = GraphicsShaderManager::getTypeCount();
-	constexpr auto meshTypeCount   = MeshManager::getTypeCount();
+	const auto shaderInfoCount = GraphicsShaderManager::getShaderInfoCount();
+
+	vkPipelines.resize(shaderInfoCount);
+	vkPipelineStates.resize(shaderInfoCount, PipelineState::NONE);
+
+	pipelineThreadPool.init(pipelineThreadFunc, 1);
 
+	return 0;
+}
+
+int GraphicsRendererBase::createGraphicsPipelines(const std::vector<uint32_t>& shaderInfoIndices,
+												  std::vector<vk::Pipeline>& pipelines) {
 	auto renderPassIndex = GraphicsShaderManager::getRenderPassIndex(getRenderPassName());
 
+	for (auto shaderInfoIndex : shaderInfoIndices) {
+		if (GraphicsShaderManager::createVariant(renderPassIndex, shaderInfoIndex)) {
+			return 1;
+		}
+	}
+
 	// const auto pipelineInputAssemblyStateCreateInfo = getVkPipelineInputAssemblyStateCreateInfo();
 	const auto viewport								= getVkViewport();
 	const auto scissor								= getVkScissor();
@@ -342,8 +362,6 @@ int GraphicsRendererBase::createGraphicsPipelines() {
 		vk::ShaderStageFlagBits::eCompute,
 	};
 
-	std::vector<vk::Pipeline> graphicsPipelines {};
-
 
 	const auto specConstDescriptions = getSpecializationConstantDescriptions();
 
@@ -374,96 +392,328 @@ int GraphicsRendererBase::createGraphicsPipelines() {
 	vk::PipelineTessellationStateCreateInfo pipelineTessellationStateCreateInfo {};
 	pipelineTessellationStateCreateInfo.patchControlPoints = 4;
 
-	for (uint shaderTypeIndex = 0; shaderTypeIndex < shaderTypeCount; shaderTypeIndex++) {
-		for (uint meshTypeIndex = 0; meshTypeIndex < meshTypeCount; meshTypeIndex++) {
 
-			vk::PipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo {};
+	// Per pipeline state referenced by create infos, sized once so that pointers stay valid
+	struct PipelineCreateState {
+		std::vector<vk::VertexInputAttributeDescription> vertexAttributeDescriptions;
+		std::vector<vk::VertexInputBindingDescription> vertexBindingDescriptions;
 
-			auto vertexAttributeDescriptions = MeshManager::getVertexInputAttributeDescriptions(meshTypeIndex);
-			pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = vertexAttributeDescriptions.size();
-			pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions	   = vertexAttributeDescriptions.data();
+		vk::PipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo;
+		vk::PipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo;
 
-			auto vertexBindingDescriptions = MeshManager::getVertexInputBindingDescriptions(meshTypeIndex);
-			pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = vertexBindingDescriptions.size();
-			pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions	 = vertexBindingDescriptions.data();
+		std::array<vk::PipelineShaderStageCreateInfo, 6> pipelineShaderStageCreateInfos;
 
-			auto signatureCount = GraphicsShaderManager::getShaderSignatureCount(shaderTypeIndex);
+		vk::PipelineCreationFeedbackEXT pipelineCreationFeedback;
+		std::array<vk::PipelineCreationFeedbackEXT, 6> stageCreationFeedbacks;
+		vk::PipelineCreationFeedbackCreateInfoEXT pipelineCreationFeedbackCreateInfo;
+	};
 
-			for (uint signature = 0; signature < signatureCount; signature++) {
-				uint32_t shaderStageCount = 0;
-				vk::PipelineShaderStageCreateInfo pipelineShaderStageCreateInfos[6];
+	const auto pipelineCount = shaderInfoIndices.size();
 
-				auto shaderInfo =
-					GraphicsShaderManager::getShaderInfo(renderPassIndex, shaderTypeIndex, meshTypeIndex, signature);
+	std::vector<PipelineCreateState> pipelineCreateStates(pipelineCount);
+	std::vector<vk::GraphicsPipelineCreateInfo> graphicsPipelineCreateInfos(pipelineCount);
 
-				bool useTessellation = false;
+	for (uint pipelineIndex = 0; pipelineIndex < pipelineCount; pipelineIndex++) {
+		const auto shaderInfoIndex = shaderInfoIndices[pipelineIndex];
 
-				for (uint shaderStageIndex = 0; shaderStageIndex < 6; shaderStageIndex++) {
-					auto& pipelineShaderStageCreateInfo = pipelineShaderStageCreateInfos[shaderStageCount];
+		auto& pipelineCreateState		 = pipelineCreateStates[pipelineIndex];
+		auto& graphicsPipelineCreateInfo = graphicsPipelineCreateInfos[pipelineIndex];
 
-					auto& shaderModule = shaderInfo.shaderModules[shaderStageIndex];
+		uint32_t shaderTypeIndex = 0;
+		uint32_t meshTypeIndex	 = 0;
+		uint32_t signature		 = 0;
+		GraphicsShaderManager::getVariant(shaderInfoIndex, shaderTypeIndex, meshTypeIndex, signature);
 
-					if (shaderModule != vk::ShaderModule()) {
-						if ((shaderStageIndex == 2) || (shaderStageIndex == 3)) {
-							useTessellation = true;
-						}
 
-						pipelineShaderStageCreateInfo.stage = shaderStages[shaderStageIndex];
+		auto& vertexAttributeDescriptions = pipelineCreateState.vertexAttributeDescriptions;
+		auto& vertexBindingDescriptions	  = pipelineCreateState.vertexBindingDescriptions;
 
-						pipelineShaderStageCreateInfo.pSpecializationInfo = &specializationInfo;
+		vertexAttributeDescriptions = MeshManager::getVertexInputAttributeDescriptions(meshTypeIndex);
+		vertexBindingDescriptions	= MeshManager::getVertexInputBindingDescriptions(meshTypeIndex);
 
-						pipelineShaderStageCreateInfo.module = shaderModule;
-						pipelineShaderStageCreateInfo.pName	 = "main";
+		// Position is the first attribute and the only one in the first stream
+		if (usesPositionOnlyVertexInput()) {
+			vertexAttributeDescriptions.resize(1);
+			vertexBindingDescriptions.resize(1);
+		}
 
-						shaderStageCount++;
-					}
-				}
+		auto& pipelineVertexInputStateCreateInfo = pipelineCreateState.pipelineVertexInputStateCreateInfo;
 
-				vk::PipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo {};
-				if (useTessellation) {
-					pipelineInputAssemblyStateCreateInfo.topology = vk::PrimitiveTopology::ePatchList;
-				} else {
-					pipelineInputAssemblyStateCreateInfo.topology = vk::PrimitiveTopology::eTriangleList;
-				}
+		pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = vertexAttributeDescriptions.size();
+		pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions	   = vertexAttributeDescriptions.data();
 
-				vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo {};
-				graphicsPipelineCreateInfo.stageCount = shaderStageCount;
-				graphicsPipelineCreateInfo.pStages	  = pipelineShaderStageCreateInfos;
-
-				graphicsPipelineCreateInfo.pVertexInputState   = &pipelineVertexInputStateCreateInfo;
-				graphicsPipelineCreateInfo.pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo;
-				graphicsPipelineCreateInfo.pViewportState	   = &pipelineViewportStateCreateInfo;
-				graphicsPipelineCreateInfo.pRasterizationState = &pipelineRasterizationStateCreateInfo;
-				graphicsPipelineCreateInfo.pMultisampleState   = &pipelineMultisampleStateCreateInfo;
-				graphicsPipelineCreateInfo.pDepthStencilState  = &pipelineDepthStencilStateCreateInfo;
-				graphicsPipelineCreateInfo.pColorBlendState	   = &pipelineColorBlendStateCreateInfo;
-				graphicsPipelineCreateInfo.pDynamicState	   = nullptr;
-
-				if (useTessellation) {
-					graphicsPipelineCreateInfo.pTessellationState = &pipelineTessellationStateCreateInfo;
+		pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = vertexBindingDescriptions.size();
+		pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions	 = vertexBindingDescriptions.data();
+
+
+		uint32_t shaderStageCount = 0;
+
+		const auto& shaderInfo = GraphicsShaderManager::getShaderInfo(renderPassIndex, shaderInfoIndex);
+
+		bool useTessellation = false;
+
+		for (uint shaderStageIndex = 0; shaderStageIndex < 6; shaderStageIndex++) {
+			auto& pipelineShaderStageCreateInfo = pipelineCreateState.pipelineShaderStageCreateInfos[shaderStageCount];
+
+			auto& shaderModule = shaderInfo.shaderModules[shaderStageIndex];
+
+			if (shaderModule != vk::ShaderModule()) {
+				if ((shaderStageIndex == 2) || (shaderStageIndex == 3)) {
+					useTessellation = true;
 				}
 
-				graphicsPipelineCreateInfo.layout = vkPipelineLayout;
+				pipelineShaderStageCreateInfo.stage = shaderStages[shaderStageIndex];
 
-				graphicsPipelineCreateInfo.renderPass = vkRenderPass;
-				graphicsPipelineCreateInfo.subpass	  = 0;
+				pipelineShaderStageCreateInfo.pSpecializationInfo = &specializationInfo;
 
-				vk::Pipeline pipeline;
-				auto result =
-					vkDevice.createGraphicsPipelines(nullptr, 1, &graphicsPipelineCreateInfo, nullptr, &pipeline);
+				pipelineShaderStageCreateInfo.module = shaderModule;
+				pipelineShaderStageCreateInfo.pName	 = "main";
 
-				if (result != vk::Result::eSuccess) {
-					spdlog::error("Failed to create graphics pipeline. Error code: {} ({})", result,
-								  vk::to_string(result));
-					return 1;
+				shaderStageCount++;
+			}
+		}
+
+		auto& pipelineInputAssemblyStateCreateInfo = pipelineCreateState.pipelineInputAssemblyStateCreateInfo;
+		if (useTessellation) {
+			pipelineInputAssemblyStateCreateInfo.topology = vk::PrimitiveTopology::ePatchList;
+		} else {
+			pipelineInputAssemblyStateCreateInfo.topology = vk::PrimitiveTopology::eTriangleList;
+		}
+
+		graphicsPipelineCreateInfo.stageCount = shaderStageCount;
+		graphicsPipelineCreateInfo.pStages	  = pipelineCreateState.pipelineShaderStageCreateInfos.data();
+
+		graphicsPipelineCreateInfo.pVertexInputState   = &pipelineVertexInputStateCreateInfo;
+		graphicsPipelineCreateInfo.pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo;
+		graphicsPipelineCreateInfo.pViewportState	   = &pipelineViewportStateCreateInfo;
+		graphicsPipelineCreateInfo.pRasterizationState = &pipelineRasterizationStateCreateInfo;
+		graphicsPipelineCreateInfo.pMultisampleState   = &pipelineMultisampleStateCreateInfo;
+		graphicsPipelineCreateInfo.pDepthStencilState  = &pipelineDepthStencilStateCreateInfo;
+		graphicsPipelineCreateInfo.pColorBlendState	   = &pipelineColorBlendStateCreateInfo;
+		graphicsPipelineCreateInfo.pDynamicState	   = nullptr;
+
+		if (useTessellation) {
+			graphicsPipelineCreateInfo.pTessellationState = &pipelineTessellationStateCreateInfo;
+		}
+
+		graphicsPipelineCreateInfo.layout = vkPipelineLayout;
+
+		graphicsPipelineCreateInfo.renderPass = vkRenderPass;
+		graphicsPipelineCreateInfo.subpass	  = 0;
+
+		if (PipelineCache::useCreationFeedback()) {
+			auto& feedbackCreateInfo = pipelineCreateState.pipelineCreationFeedbackCreateInfo;
+
+			feedbackCreateInfo.pPipelineCreationFeedback		  = &pipelineCreateState.pipelineCreationFeedback;
+			feedbackCreateInfo.pipelineStageCreationFeedbackCount = shaderStageCount;
+			feedbackCreateInfo.pPipelineStageCreationFeedbacks	  = pipelineCreateState.stageCreationFeedbacks.data();
+
+			graphicsPipelineCreateInfo.pNext = &feedbackCreateInfo;
+		}
+	}
+
+
+	// All pipelines of a batch are created by a single call, so that driver can compile them in parallel
+	pipelines.resize(pipelineCount);
+
+	auto result = vkDevice.createGraphicsPipelines(PipelineCache::getVkPipelineCache(), pipelineCount,
+												   graphicsPipelineCreateInfos.data(), nullptr, pipelines.data());
+
+	if (result != vk::Result::eSuccess) {
+		spdlog::error("[{}] Failed to create graphics pipelines. Error code: {} ({})", rendererName, result,
+					  vk::to_string(result));
+
+		// Pipelines that failed are set to null handles by implementation
+		for (auto& pipeline : pipelines) {
+			if (pipeline != vk::Pipeline()) {
+				vkDevice.destroyPipeline(pipeline);
+			}
+		}
+		pipelines.clear();
+
+		return 1;
+	}
+
+	for (const auto& pipelineCreateState : pipelineCreateStates) {
+		PipelineCache::recordPipelineCreation(pipelineCreateState.pipelineCreationFeedback);
+	}
+
+	return 0;
+}
+
+int GraphicsRendererBase::updateGraphicsPipelines() {
+	destroyRetiredPipelines(false);
+
+	// Pick up pipelines created in background. Jobs finish in order they were queued, so a rebuild never gets
+	// replaced by an older result.
+	while (!pipelineJobs.empty() && pipelineJobs.front()->isDone) {
+		auto& pipelineJob = *pipelineJobs.front();
+
+		for (uint i = 0; i < pipelineJob.shaderInfoIndices.size(); i++) {
+			const auto shaderInfoIndex = pipelineJob.shaderInfoIndices[i];
+
+			if (pipelineJob.result) {
+				// Fallback pipeline is kept in place of failed one, failed rebuilds keep the previous pipeline
+				if (vkPipelineStates[shaderInfoIndex] == PipelineState::PENDING) {
+					vkPipelineStates[shaderInfoIndex] = PipelineState::FAILED;
 				}
+			} else {
+				replaceGraphicsPipeline(shaderInfoIndex, pipelineJob.pipelines[i]);
+			}
+		}
+
+		pipelineJobs.erase(pipelineJobs.begin());
+	}
+
+
+	// Variants of reloaded shaders are rebuilt, the ones in use are kept meanwhile
+	std::vector<uint32_t> rebuildIndices {};
+
+	const auto invalidatedIndices = GraphicsShaderManager::getInvalidatedIndices(processedInvalidationCount);
+	processedInvalidationCount += invalidatedIndices.size();
+
+	for (auto shaderInfoIndex : invalidatedIndices) {
+		if (vkPipelineStates[shaderInfoIndex] != PipelineState::NONE &&
+			std::find(rebuildIndices.begin(), rebuildIndices.end(), shaderInfoIndex) == rebuildIndices.end()) {
+			rebuildIndices.push_back(shaderInfoIndex);
+		}
+	}
+
+	if (!rebuildIndices.empty()) {
+		auto pipelineJob			   = std::make_unique<PipelineJob>();
+		pipelineJob->pRenderer		   = this;
+		pipelineJob->shaderInfoIndices = std::move(rebuildIndices);
+
+		pipelineThreadPool.appendData(pipelineJob.get());
+		pipelineJobs.push_back(std::move(pipelineJob));
+	}
+
+
+	const auto requestedIndices = GraphicsShaderManager::getRequestedIndices(processedRequestCount);
+	processedRequestCount += requestedIndices.size();
+
+	if (requestedIndices.empty()) {
+		return 0;
+	}
+
+	// Fallbacks are needed right away and are created in one batch
+	std::vector<uint32_t> fallbackIndices {};
+
+	for (auto shaderInfoIndex : requestedIndices) {
+		const auto fallbackIndex = GraphicsShaderManager::getFallbackIndex(shaderInfoIndex);
 
-				graphicsPipelines.push_back(pipeline);
+		if (vkPipelineStates[fallbackIndex] == PipelineState::NONE) {
+			vkPipelineStates[fallbackIndex] = PipelineState::PENDING;
+			fallbackIndices.push_back(fallbackIndex);
+		}
+	}
+
+	if (!fallbackIndices.empty()) {
+		std::vector<vk::Pipeline> fallbackPipelines {};
+
+		if (createGraphicsPipelines(fallbackIndices, fallbackPipelines)) {
+			for (auto fallbackIndex : fallbackIndices) {
+				vkPipelineStates[fallbackIndex] = PipelineState::FAILED;
 			}
+			return 1;
+		}
+
+		for (uint i = 0; i < fallbackIndices.size(); i++) {
+			replaceGraphicsPipeline(fallbackIndices[i], fallbackPipelines[i]);
 		}
 	}
-	vkPipelines = graphicsPipelines;
+
+	// Remaining variants are created in background as a single batch
+	auto pipelineJob	   = std::make_unique<PipelineJob>();
+	pipelineJob->pRenderer = this;
+
+	for (auto shaderInfoIndex : requestedIndices) {
+		if (vkPipelineStates[shaderInfoIndex] != PipelineState::NONE) {
+			continue;
+		}
+
+		const auto fallbackIndex = GraphicsShaderManager::getFallbackIndex(shaderInfoIndex);
+
+		vkPipelines[shaderInfoIndex]	  = vkPipelines[fallbackIndex];
+		vkPipelineStates[shaderInfoIndex] = PipelineState::PENDING;
+
+		pipelineJob->shaderInfoIndices.push_back(shaderInfoIndex);
+	}
+
+	if (!pipelineJob->shaderInfoIndices.empty()) {
+		pipelineThreadPool.appendData(pipelineJob.get());
+		pipelineJobs.push_back(std::move(pipelineJob));
+	}
 
 	return 0;
 }
+
+
+void GraphicsRendererBase::dispose() {
+	// Waits for job in progress, queued ones are dropped
+	pipelineThreadPool.terminate();
+
+	for (const auto& pipelineJob : pipelineJobs) {
+		if (pipelineJob->isDone && !pipelineJob->result) {
+			for (auto pipeline : pipelineJob->pipelines) {
+				vkDevice.destroyPipeline(pipeline);
+			}
+		}
+	}
+	pipelineJobs.clear();
+
+	for (uint i = 0; i < vkPipelines.size(); i++) {
+		if (vkPipelineStates[i] == PipelineState::READY) {
+			vkDevice.destroyPipeline(vkPipelines[i]);
+		}
+	}
+	vkPipelines.clear();
+	vkPipelineStates.clear();
+
+	destroyRetiredPipelines(true);
+
+	RendererBase::dispose();
+}
+
+
+void GraphicsRendererBase::replaceGraphicsPipeline(uint32_t shaderInfoIndex, vk::Pipeline pipeline) {
+	if (vkPipelineStates[shaderInfoIndex] == PipelineState::READY) {
+		const auto previousPipeline = vkPipelines[shaderInfoIndex];
+
+		for (uint i = 0; i < vkPipelines.size(); i++) {
+			if (vkPipelines[i] == previousPipeline && vkPipelineStates[i] != PipelineState::READY) {
+				vkPipelines[i] = pipeline;
+			}
+		}
+
+		retiredPipelines.push_back({ previousPipeline, frameIndex });
+	}
+
+	vkPipelines[shaderInfoIndex]	  = pipeline;
+	vkPipelineStates[shaderInfoIndex] = PipelineState::READY;
+}
+
+void GraphicsRendererBase::destroyRetiredPipelines(bool all) {
+	for (uint i = 0; i < retiredPipelines.size();) {
+		// Stamped frame is the last one recorded with the pipeline, it is complete once as many frames as there are in
+		// flight have been recorded after it
+		if (all || frameIndex >= retiredPipelines[i].frameIndex + framesInFlightCount) {
+			vkDevice.destroyPipeline(retiredPipelines[i].pipeline);
+
+			retiredPipelines[i] = retiredPipelines.back();
+			retiredPipelines.pop_back();
+		} else {
+			i++;
+		}
+	}
+}
+
+
+void GraphicsRendererBase::pipelineThreadFunc(uint threadIndex, void* pData) {
+	auto& pipelineJob = *static_cast<PipelineJob*>(pData);
+
+	pipelineJob.result =
+		pipelineJob.pRenderer->createGraphicsPipelines(pipelineJob.shaderInfoIndices, pipelineJob.pipelines);
+	pipelineJob.isDone = true;
+}
 } // namespace Engine
\ No newline at end of file
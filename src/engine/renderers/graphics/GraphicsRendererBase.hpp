@@ -2,13 +2,58 @@
 
 #include "engine/renderers/RendererBase.hpp"
 
+#include "engine/utils/ThreadPool.hpp"
+
+#include <atomic>
+#include <memory>
+
 
 namespace Engine {
 class GraphicsRendererBase : public RendererBase {
 protected:
+	enum class PipelineState : uint8_t {
+		NONE,
+		PENDING,
+		READY,
+		FAILED,
+	};
+
+	// Batch of shader variant pipelines created on background thread
+	struct PipelineJob {
+		GraphicsRendererBase* pRenderer;
+		std::vector<uint32_t> shaderInfoIndices;
+
+		std::vector<vk::Pipeline> pipelines;
+		int result;
+
+		std::atomic<bool> isDone;
+	};
+
+	// Replaced pipeline, destroyed once frames that could use it are finished
+	struct RetiredPipeline {
+		vk::Pipeline pipeline;
+		uint64_t frameIndex;
+	};
+
+
 	vk::RenderPass vkRenderPass {};
 	std::vector<vk::Framebuffer> vkFramebuffers {};
 
+	// Pipelines are created for requested shader handles only. Until a pipeline is ready, its slot in pipeline
+	// array holds the pipeline of fallback variant.
+	std::vector<PipelineState> vkPipelineStates {};
+	std::vector<std::unique_ptr<PipelineJob>> pipelineJobs {};
+
+	std::vector<RetiredPipeline> retiredPipelines {};
+
+	// Number of shader handle requests and variant invalidations already processed
+	uint processedRequestCount {};
+	uint processedInvalidationCount {};
+
+	uint64_t frameIndex {};
+
+	ThreadPool pipelineThreadPool {};
+
 
 public:
 	GraphicsRendererBase(uint inputCount, uint outputCount) : RendererBase(inputCount, outputCount) {
@@ -27,6 +72,8 @@ public:
 					   const vk::CommandBuffer* pSecondaryCommandBuffers, const vk::QueryPool& timestampQueryPool,
 					   double dt) override;
 
+	void dispose() override;
+
 
 	uint getColorAttachmentCount() const;
 
@@ -35,8 +82,19 @@ public:
 
 	int createRenderPass();
 	int createFramebuffer();
+	// Prepares pipeline slots for all shader variants, pipelines themselves are created by updates
 	int createGraphicsPipelines();
 
+	// Creates variant shader modules if needed and pipelines for them with a single call. Thread safe as long as
+	// renderer is not modified meanwhile.
+	int createGraphicsPipelines(const std::vector<uint32_t>& shaderInfoIndices, std::vector<vk::Pipeline>& pipelines);
+
+	// Creates pipelines for newly requested shader handles and picks up ones created in background. Fallback
+	// pipelines are created immediately, since something has to be drawn in their place. Pipelines of reloaded
+	// variants are rebuilt in background and replace current ones when ready. Updates of different renderers may run
+	// concurrently. Called by RenderingSystem once per frame before rendering.
+	int updateGraphicsPipelines();
+
 
 	virtual std::vector<vk::ClearValue> getVkClearValues() const {
 		return std::vector<vk::ClearValue>();
@@ -118,5 +176,21 @@ public:
 
 		return pipelineColorBlendAttachmentStates;
 	}
+
+	// Pipelines of passes that only need positions are created with position vertex stream alone
+	virtual bool usesPositionOnlyVertexInput() const {
+		return false;
+	}
+
+
+private:
+	// Sets pipeline created for a slot. Pipeline being replaced is retired, slots using it in place of their own
+	// are switched to the new one.
+	void replaceGraphicsPipeline(uint32_t shaderInfoIndex, vk::Pipeline pipeline);
+
+	// Destroys retired pipelines no longer used by frames in flight, or all of them
+	void destroyRetiredPipelines(bool all);
+
+	static void pipelineThreadFunc(uint threadIndex, void* pData);
 };
 } // namespace Engine
\ No newline at end of file
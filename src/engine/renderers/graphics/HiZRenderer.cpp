@@ -0,0 +1,52 @@
+#include "HiZRenderer.hpp"
+
+#include "engine/utils/Generator.hpp"
+
+#include <glm/glm.hpp>
+
+
+namespace Engine {
+int HiZRenderer::init() {
+	spdlog::info("Initializing HiZRenderer...");
+
+	assert(vkDevice != vk::Device());
+	assert(outputSize != vk::Extent2D());
+
+
+	mesh = MeshManager::createObject<StaticMesh>("generated_screen_triangle");
+	Generator::screenTriangle(mesh);
+
+	shaderHandle = GraphicsShaderManager::getHandle<HiZShader>(mesh);
+
+
+	if (GraphicsRendererBase::init()) {
+		return 1;
+	}
+
+	return 0;
+}
+
+
+void HiZRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSecondaryCommandBuffers, double dt) {
+
+	const auto& commandBuffer = pSecondaryCommandBuffers[0];
+
+
+	glm::uvec2 size = { outputSize.width, outputSize.height };
+
+	commandBuffer.pushConstants(vkPipelineLayout, vk::ShaderStageFlagBits::eAll, 0, sizeof(size), &size);
+
+	const auto& meshInfo = MeshManager::getMeshInfo(mesh);
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, vkPipelines[shaderHandle.getIndex()]);
+
+
+	vk::DeviceSize offsets[] = { 0, 0 };
+	commandBuffer.bindVertexBuffers(0, meshInfo.vertexStreamCount, meshInfo.vkVertexBuffers.data(), offsets);
+
+	auto indexBuffer = meshInfo.vkIndexBuffer;
+	commandBuffer.bindIndexBuffer(indexBuffer, 0, meshInfo.indexType);
+
+	commandBuffer.drawIndexed(meshInfo.indexCount, 1, meshInfo.firstIndex, meshInfo.vertexOffset, 0);
+}
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "GraphicsRendererBase.hpp"
+
+
+namespace Engine {
+// Reduces depth buffer into a low resolution buffer of farthest depths used for occlusion culling
+class HiZRenderer : public GraphicsRendererBase {
+private:
+	MeshManager::Handle mesh {};
+	GraphicsShaderManager::Handle shaderHandle {};
+
+
+public:
+	HiZRenderer() : GraphicsRendererBase(1, 1) {
+	}
+
+
+	int init() override;
+
+	void recordSecondaryCommandBuffers(const vk::CommandBuffer* pSecondaryCommandBuffers, double dt) override;
+
+	const char* getRenderPassName() const override {
+		return "RENDER_PASS_HI_Z";
+	}
+
+
+	virtual std::vector<std::string> getInputNames() const {
+		return { "DepthBuffer" };
+	}
+
+	virtual std::vector<std::string> getOutputNames() const {
+		return { "HiZBuffer" };
+	}
+
+
+	std::vector<AttachmentDescription> getInputDescriptions() const {
+		std::vector<AttachmentDescription> descriptions {};
+		descriptions.resize(1);
+
+		descriptions[0].format = vk::Format::eD24UnormS8Uint;
+		descriptions[0].usage  = vk::ImageUsageFlagBits::eSampled;
+
+		return descriptions;
+	}
+
+	std::vector<AttachmentDescription> getOutputDescriptions() const {
+		std::vector<AttachmentDescription> outputDescriptions {};
+		outputDescriptions.resize(1);
+
+		outputDescriptions[0].format = vk::Format::eR32Sfloat;
+		outputDescriptions[0].usage	 = vk::ImageUsageFlagBits::eColorAttachment;
+
+		return outputDescriptions;
+	}
+
+
+	std::vector<vk::ImageLayout> getInputInitialLayouts() const {
+		std::vector<vk::ImageLayout> initialLayouts {};
+		initialLayouts.resize(1);
+
+		initialLayouts[0] = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+		return initialLayouts;
+	}
+
+	std::vector<vk::ImageLayout> getOutputInitialLayouts() const {
+		std::vector<vk::ImageLayout> outputInitialLayouts {};
+		outputInitialLayouts.resize(1);
+
+		outputInitialLayouts[0] = vk::ImageLayout::eColorAttachmentOptimal;
+
+		return outputInitialLayouts;
+	}
+
+
+	std::vector<vk::SamplerCreateInfo> getInputVkSamplerCreateInfos() override {
+		auto samplerCreateInfos = RendererBase::getInputVkSamplerCreateInfos();
+
+		for (auto& samplerCreateInfo : samplerCreateInfos) {
+			samplerCreateInfo.minFilter	 = vk::Filter::eNearest;
+			samplerCreateInfo.magFilter	 = vk::Filter::eNearest;
+			samplerCreateInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+		}
+
+		return samplerCreateInfos;
+	}
+
+	std::vector<vk::ImageViewCreateInfo> getInputVkImageViewCreateInfos() override {
+		auto imageViewCreateInfos = RendererBase::getInputVkImageViewCreateInfos();
+
+		{
+			auto& imageViewCreateInfo						= imageViewCreateInfos[getInputIndex("DepthBuffer")];
+			imageViewCreateInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eDepth;
+		}
+
+		return imageViewCreateInfos;
+	}
+
+
+	std::vector<DescriptorSetDescription> getDescriptorSetDescriptions() const {
+		std::vector<DescriptorSetDescription> descriptorSetDescriptions {};
+
+		return descriptorSetDescriptions;
+	}
+
+
+	inline std::vector<vk::AttachmentDescription> getVkAttachmentDescriptions() const override {
+		std::vector<vk::AttachmentDescription> attachmentDescriptions {};
+		attachmentDescriptions.resize(1);
+
+		auto outputDescriptions = getOutputDescriptions();
+
+		attachmentDescriptions[0].format		 = outputDescriptions[0].format;
+		attachmentDescriptions[0].samples		 = vk::SampleCountFlagBits::e1;
+		attachmentDescriptions[0].loadOp		 = vk::AttachmentLoadOp::eDontCare;
+		attachmentDescriptions[0].storeOp		 = vk::AttachmentStoreOp::eStore;
+		attachmentDescriptions[0].stencilLoadOp	 = vk::AttachmentLoadOp::eDontCare;
+		attachmentDescriptions[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+
+		return attachmentDescriptions;
+	}
+};
+} // namespace Engine
\ No newline at end of file
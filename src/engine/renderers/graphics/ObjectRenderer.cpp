@@ -1,8 +1,10 @@
 #include "ObjectRenderer.hpp"
 
-#include "engine/managers/EntityManager.hpp"
 #include "engine/managers/MaterialManager.hpp"
 #include "engine/managers/MeshManager.hpp"
+#include "engine/managers/VisibilityManager.hpp"
+
+#include <algorithm>
 
 
 namespace Engine {
@@ -11,6 +13,7 @@ int ObjectRenderer::init() {
 
 	renderInfoCachePerThread.resize(threadCount);
 	renderInfoIndicesPerThread.resize(threadCount);
+	drawRangesPerThread.resize(threadCount);
 
 	threadPool.init(drawObjectsThreadFunc, threadCount);
 
@@ -22,8 +25,7 @@ int ObjectRenderer::init() {
 
 void ObjectRenderer::drawObjects(const vk::PipelineLayout pipelineLayout, const vk::Pipeline* pPipelines,
 								 const vk::CommandBuffer* pSecondaryCommandBuffers, const uint materialDescriptorSetId,
-								 const Frustum* includeFrustums, uint includeFrustumCount,
-								 const Frustum* excludeFrustums, uint excludeFrustumCount) {
+								 uint viewIndex) {
 
 	for (uint i = 0; i < drawObjectsThreadInfos.size(); i++) {
 		drawObjectsThreadInfos[i].renderer = this;
@@ -32,10 +34,7 @@ void ObjectRenderer::drawObjects(const vk::PipelineLayout pipelineLayout, const
 		drawObjectsThreadInfos[i].pVkPipelines			   = pPipelines;
 		drawObjectsThreadInfos[i].pSecondaryCommandBuffers = pSecondaryCommandBuffers;
 
-		drawObjectsThreadInfos[i].includeFrustums	  = includeFrustums;
-		drawObjectsThreadInfos[i].includeFrustumCount = includeFrustumCount;
-		drawObjectsThreadInfos[i].excludeFrustums	  = excludeFrustums;
-		drawObjectsThreadInfos[i].excludeFrustumCount = excludeFrustumCount;
+		drawObjectsThreadInfos[i].viewIndex = viewIndex;
 
 		drawObjectsThreadInfos[i].fragmentIndex = i;
 		drawObjectsThreadInfos[i].fragmentCount = drawObjectsThreadInfos.size();
@@ -57,77 +56,111 @@ void ObjectRenderer::drawObjectsThreadFunc(uint threadIndex, void* pData) {
 
 	const auto& commandBuffer = drawObjectsThreadInfo.pSecondaryCommandBuffers[threadIndex];
 
-	const auto& includeFrustums		= drawObjectsThreadInfo.includeFrustums;
-	const auto& includeFrustumCount = drawObjectsThreadInfo.includeFrustumCount;
-	const auto& excludeFrustums		= drawObjectsThreadInfo.excludeFrustums;
-	const auto& excludeFrustumCount = drawObjectsThreadInfo.excludeFrustumCount;
+	const uint32_t viewBit = 1 << drawObjectsThreadInfo.viewIndex;
 
 	auto& renderInfoIndices = drawObjectsThreadInfo.renderer->renderInfoIndicesPerThread[threadIndex];
 	auto& renderInfoCache	= drawObjectsThreadInfo.renderer->renderInfoCachePerThread[threadIndex];
 
+	auto& drawRanges = drawObjectsThreadInfo.renderer->drawRangesPerThread[threadIndex];
+
 	renderInfoIndices.clear();
 	renderInfoCache.clear();
+	drawRanges.clear();
 
-	uint entityIndex = 0;
+	const auto& viewInfo = VisibilityManager::getViewInfo(drawObjectsThreadInfo.viewIndex);
 
-	EntityManager::forEach<TransformComponent, ModelComponent>(
-		[&](auto& transform, auto& model) {
-			const auto transformMatrix = transform.getTransformMatrix();
+	const bool cullMeshlets = VisibilityManager::isMeshletCullingEnabled();
 
-			const auto& meshHandle	   = model.meshHandles[0];
-			const auto& materialHandle = model.materialHandles[0];
-			const auto& shaderHandle   = model.shaderHandles[0];
 
-			const auto& meshInfo = MeshManager::getMeshInfo(meshHandle);
+	const auto& objectInfos = VisibilityManager::getObjectInfos();
 
-			auto boundingSphere = meshInfo.boundingSphere.transform(transformMatrix);
-			auto boundingBox	= meshInfo.boundingBox.transform(transformMatrix);
+	const uint fragmentSize = (objectInfos.size() + drawObjectsThreadInfo.fragmentCount - 1) /
+							  drawObjectsThreadInfo.fragmentCount;
 
-			bool shouldDraw = includeFrustumCount == 0;
+	const uint first = std::min<uint>(drawObjectsThreadInfo.fragmentIndex * fragmentSize, objectInfos.size());
+	const uint last	 = std::min<uint>(first + fragmentSize, objectInfos.size());
 
-			for (uint i = 0; i < includeFrustumCount; i++) {
-				const auto& includeFrustum = includeFrustums[i];
+	for (uint entityIndex = first; entityIndex < last; entityIndex++) {
+		const auto& objectInfo = objectInfos[entityIndex];
 
-				shouldDraw = shouldDraw || includeFrustum.intersects(boundingBox);
-			}
+		if ((objectInfo.viewMask & viewBit) == 0) {
+			continue;
+		}
 
-			for (uint i = 0; i < excludeFrustumCount; i++) {
-				const auto& excludeFrustum = excludeFrustums[i];
+		const uint32_t lodMeshIndex = objectInfo.getMeshIndex(drawObjectsThreadInfo.viewIndex);
 
-				shouldDraw = shouldDraw && !excludeFrustum.contains(boundingBox);
-			}
+		const auto& meshInfo = MeshManager::getMeshInfo(lodMeshIndex);
 
-			if (shouldDraw) {
-				const auto& materialInfo = MaterialManager::getMaterialInfo(materialHandle);
+		// Culling selects published levels only, an empty published mesh has nothing to draw
+		if (!MeshManager::isPublished(lodMeshIndex)) {
+			continue;
+		}
+
+		const uint firstDrawRange = drawRanges.size();
 
-				uint64_t pipelineIndex = shaderHandle.getIndex();
-				uint64_t materialIndex = materialHandle.getIndex();
-				uint64_t meshIndex	   = meshHandle.getIndex();
+		if (cullMeshlets && !meshInfo.meshlets.empty()) {
+			for (const auto& meshlet : meshInfo.meshlets) {
+				const auto transformed = meshlet.transform(objectInfo.transformMatrix);
 
-				renderInfoIndices[(pipelineIndex << 54) + (materialIndex << 44) + (meshIndex << 34) + entityIndex] =
-					renderInfoCache.size();
+				if (!viewInfo.frustum.intersects(transformed.boundingSphere)) {
+					continue;
+				}
 
-				renderInfoCache.push_back({
-					shaderHandle.getIndex(),
-					materialInfo.descriptorSet,
-					meshInfo.vertexBuffer.getVkBuffer(),
-					meshInfo.indexBuffer.getVkBuffer(),
-					meshInfo.indexCount,
-					transformMatrix,
-				});
+				if (viewInfo.isPerspective ? transformed.isBackFacing(viewInfo.position)
+										   : transformed.isBackFacingDirection(viewInfo.direction)) {
+					continue;
+				}
 
-				entityIndex++;
+				if (drawRanges.size() > firstDrawRange &&
+					drawRanges.back().firstIndex + drawRanges.back().indexCount == meshlet.firstIndex) {
+					drawRanges.back().indexCount += meshlet.indexCount;
+				} else {
+					drawRanges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+				}
 			}
-		},
-		drawObjectsThreadInfo.fragmentIndex, drawObjectsThreadInfo.fragmentCount);
+
+			if (drawRanges.size() == firstDrawRange) {
+				continue;
+			}
+		} else {
+			drawRanges.push_back({ 0, meshInfo.indexCount });
+		}
+
+		uint64_t pipelineIndex = objectInfo.pipelineIndex;
+		uint64_t materialIndex = objectInfo.materialIndex;
+		uint64_t meshIndex	   = lodMeshIndex;
+
+		renderInfoIndices[(pipelineIndex << 54) + (materialIndex << 44) + (meshIndex << 34) + entityIndex] =
+			renderInfoCache.size();
+
+		renderInfoCache.push_back({
+			objectInfo.pipelineIndex,
+			objectInfo.materialIndex,
+			meshInfo.vkVertexBuffers,
+			meshInfo.vertexStreamCount,
+			meshInfo.vkIndexBuffer,
+			meshInfo.indexType,
+			meshInfo.vertexOffset,
+			meshInfo.firstIndex,
+			firstDrawRange,
+			static_cast<uint>(drawRanges.size()) - firstDrawRange,
+			objectInfo.transformMatrix,
+			meshInfo.positionDequantization,
+		});
+	}
 
 
 	auto lastPipelineIndex = -1;
 	vk::Buffer lastVertexBuffer {};
-	vk::DescriptorSet lastMaterial {};
+	vk::IndexType lastIndexType {};
+
 
+	// Materials are indexed from a single buffer, no per draw descriptor set binds are needed
+	const auto materialDescriptorSet = MaterialManager::getVkDescriptorSet();
 
-	const auto& materialDescriptorSetIndex = drawObjectsThreadInfo.materialDescriptorSetIndex;
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, vkPipelineLayout,
+									 drawObjectsThreadInfo.materialDescriptorSetIndex, 1, &materialDescriptorSet, 0,
+									 nullptr);
 
 	for (const auto& [key, renderInfoIndex] : renderInfoIndices) {
 		const auto& renderInfo = renderInfoCache[renderInfoIndex];
@@ -139,26 +172,35 @@ void ObjectRenderer::drawObjectsThreadFunc(uint threadIndex, void* pData) {
 
 		commandBuffer.pushConstants(vkPipelineLayout, vk::ShaderStageFlagBits::eAll, 0, 64,
 									&renderInfo.transformMatrix);
+		commandBuffer.pushConstants(vkPipelineLayout, vk::ShaderStageFlagBits::eAll, 64, 4,
+									&renderInfo.materialIndex);
+		commandBuffer.pushConstants(vkPipelineLayout, vk::ShaderStageFlagBits::eAll, 80, 16,
+									&renderInfo.positionDequantization);
 
 
-		if (lastVertexBuffer != renderInfo.vertexBuffer) {
-			lastVertexBuffer = renderInfo.vertexBuffer;
-
-			vk::DeviceSize offsets[] = { 0 };
-			commandBuffer.bindVertexBuffers(0, 1, &renderInfo.vertexBuffer, offsets);
-			commandBuffer.bindIndexBuffer(renderInfo.indexBuffer, 0, vk::IndexType::eUint32);
-		}
+		// Position stream buffer identifies vertex layout arena
+		if (lastVertexBuffer != renderInfo.vertexBuffers[0]) {
+			lastVertexBuffer = renderInfo.vertexBuffers[0];
 
+			vk::DeviceSize offsets[] = { 0, 0 };
+			commandBuffer.bindVertexBuffers(0, renderInfo.vertexStreamCount, renderInfo.vertexBuffers.data(), offsets);
+			commandBuffer.bindIndexBuffer(renderInfo.indexBuffer, 0, renderInfo.indexType);
 
-		if (lastMaterial != renderInfo.material) {
-			lastMaterial = renderInfo.material;
+			lastIndexType = renderInfo.indexType;
+		} else if (lastIndexType != renderInfo.indexType) {
+			lastIndexType = renderInfo.indexType;
 
-			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, vkPipelineLayout,
-											 materialDescriptorSetIndex, 1, &renderInfo.material, 0, nullptr);
+			// Index arena is shared, only the way it is interpreted changes
+			commandBuffer.bindIndexBuffer(renderInfo.indexBuffer, 0, renderInfo.indexType);
 		}
 
 
-		commandBuffer.drawIndexed(renderInfo.indexCount, 1, 0, 0, 0);
+		for (uint i = 0; i < renderInfo.drawRangeCount; i++) {
+			const auto& drawRange = drawRanges[renderInfo.firstDrawRange + i];
+
+			commandBuffer.drawIndexed(drawRange.indexCount, 1, renderInfo.firstIndex + drawRange.firstIndex,
+									  renderInfo.vertexOffset, 0);
+		}
 	}
 }
 } // namespace Engine
\ No newline at end of file
@@ -1,12 +1,13 @@
 #pragma once
 
-#include "engine/graphics/Frustum.hpp"
+#include "engine/managers/MeshManager.hpp"
 
 #include "engine/utils/ThreadPool.hpp"
 
 #define VULKAN_HPP_NO_EXCEPTIONS 1
 #include <vulkan/vulkan.hpp>
 
+#include <array>
 #include <map>
 #include <vector>
 
@@ -16,14 +17,28 @@ class ObjectRenderer {
 private:
 	struct RenderInfo {
 		uint pipelineIndex;
+		uint materialIndex;
 
-		vk::DescriptorSet material;
-
-		vk::Buffer vertexBuffer;
+		// Shared arena buffers of mesh vertex layout
+		std::array<vk::Buffer, MeshManager::MAX_VERTEX_STREAM_COUNT> vertexBuffers;
+		uint vertexStreamCount;
 		vk::Buffer indexBuffer;
-		uint indexCount;
+		vk::IndexType indexType;
+
+		int32_t vertexOffset;
+		uint firstIndex;
+
+		// Range within per thread draw ranges
+		uint firstDrawRange;
+		uint drawRangeCount;
 
 		glm::mat4 transformMatrix;
+		glm::vec4 positionDequantization;
+	};
+
+	struct DrawRange {
+		uint firstIndex;
+		uint indexCount;
 	};
 
 	struct DrawObjectsThreadInfo {
@@ -35,11 +50,7 @@ private:
 
 		uint materialDescriptorSetId;
 
-		const Frustum* includeFrustums;
-		uint includeFrustumCount;
-
-		const Frustum* excludeFrustums;
-		uint excludeFrustumCount;
+		uint viewIndex;
 
 		uint fragmentIndex;
 		uint fragmentCount;
@@ -55,6 +66,9 @@ private:
 	std::vector<std::vector<RenderInfo>> renderInfoCachePerThread {};
 	std::vector<std::map<uint64_t, uint>> renderInfoIndicesPerThread {};
 
+	// Index ranges of meshlets surviving culling, contiguous meshlets are merged into a single range
+	std::vector<std::vector<DrawRange>> drawRangesPerThread {};
+
 	ThreadPool threadPool {};
 	std::vector<DrawObjectsThreadInfo> drawObjectsThreadInfos {};
 
@@ -68,10 +82,11 @@ public:
 	}
 
 
+	// Draws objects marked visible in given view by VisibilityManager, skipping meshlets outside of view frustum or
+	// facing away from it
 	void drawObjects(vk::PipelineLayout pipelineLayout, const vk::Pipeline* pPipelines,
 					 const vk::CommandBuffer* pSecondaryCommandBuffers, const uint materialDescriptorSetId,
-					 const Frustum* includeFrustums, uint includeFrustumCount, const Frustum* excludeFrustums = nullptr,
-					 uint excludeFrustumCount = 0);
+					 uint viewIndex);
 
 
 private:
@@ -1,6 +1,6 @@
 #include "ShadowMapRenderer.hpp"
 
-#include "engine/managers/EntityManager.hpp"
+#include "engine/managers/VisibilityManager.hpp"
 
 #include <glm/glm.hpp>
 
@@ -12,8 +12,6 @@ int ShadowMapRenderer::init() {
 	assert(vkDevice != vk::Device());
 	assert(outputSize != vk::Extent2D());
 
-	excludeFrustums.resize(getLayerCount() - 1);
-
 	objectRenderer.setThreadCount(threadCount);
 	objectRenderer.init();
 
@@ -25,62 +23,15 @@ int ShadowMapRenderer::init() {
 
 void ShadowMapRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSecondaryCommandBuffers, double dt) {
 
-	CameraBlock cameraBlock;
-
-	glm::vec3 cameraPos;
-	glm::vec3 cameraViewDir;
-
-	EntityManager::forEach<TransformComponent, CameraComponent>([&](const auto& transform, const auto& camera) {
-		// TODO: Check if active camera
-		auto viewVector = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
-		viewVector		= glm::rotate(transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f)) * viewVector;
-		viewVector		= glm::rotate(transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f)) * viewVector;
-		viewVector		= glm::rotate(transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f)) * viewVector;
-
-		cameraPos	  = transform.position;
-		cameraViewDir = glm::vec3(viewVector);
-	});
-
-
-	uint excludeFrustumCount = 0;
-
-	EntityManager::forEach<TransformComponent, LightComponent>([&](const auto& transform, auto& light) {
-		if (light.castsShadows) {
-			if (light.type == LightComponent::Type::DIRECTIONAL) {
-				auto lightDirection = glm::vec4(0.0f, -1.0f, 0.0f, 0.0f);
-				lightDirection		= glm::rotate(transform.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f)) * lightDirection;
-				lightDirection		= glm::rotate(transform.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f)) * lightDirection;
-				lightDirection		= glm::rotate(transform.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f)) * lightDirection;
-
-
-				excludeFrustumCount = 0;
+	const auto& cameraView = VisibilityManager::getViewInfo(VisibilityManager::VIEW_CAMERA);
 
-				for (uint cascade = 0; cascade < getLayerCount(); cascade++) {
-					float cascadeHalfSize = directionalLightCascadeBase * std::pow(2, cascade * 2 + 1);
+	const uint viewIndex	= VisibilityManager::VIEW_SHADOW_CASCADE_0 + currentLayer;
+	const auto& cascadeView = VisibilityManager::getViewInfo(viewIndex);
 
-					glm::vec3 position = cameraPos + cascadeHalfSize * directionalLightCascadeOffset * cameraViewDir;
-
-					auto viewMatrix =
-						glm::lookAtLH(position, position + glm::vec3(lightDirection), glm::vec3(0.0f, 1.0f, 0.0f));
-
-					auto projectionMatrix = glm::orthoLH_ZO(-cascadeHalfSize, cascadeHalfSize, -cascadeHalfSize,
-															cascadeHalfSize, -cascadeHalfSize * 4.0f, cascadeHalfSize);
-
-					if (cascade == currentLayer) {
-						cameraBlock.viewMatrix		 = viewMatrix;
-						cameraBlock.projectionMatrix = projectionMatrix;
-						break;
-
-					} else {
-						excludeFrustums[excludeFrustumCount] = projectionMatrix * viewMatrix;
-						excludeFrustumCount++;
-					}
-				}
+	CameraBlock cameraBlock;
 
-				light.shadowMapIndex = 0;
-			}
-		}
-	});
+	cameraBlock.viewMatrix		 = cascadeView.viewMatrix;
+	cameraBlock.projectionMatrix = cascadeView.projectionMatrix;
 
 	cameraBlock.invViewMatrix		= glm::inverse(cameraBlock.viewMatrix);
 	cameraBlock.invProjectionMatrix = glm::inverse(cameraBlock.projectionMatrix);
@@ -93,22 +44,41 @@ void ShadowMapRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* p
 	uTerrainBlock.size		= terrainState.size;
 	uTerrainBlock.maxHeight = terrainState.maxHeight;
 
-	uTerrainBlock.textureHeight = terrainState.heightMapHandle.getIndex();
-	uTerrainBlock.textureNormal = terrainState.normalMapHandle.getIndex();
+	uTerrainBlock.clipmapLevels		= TerrainStreamingManager::getClipmapLevels();
+	uTerrainBlock.clipmapSize		= TerrainStreamingManager::getClipmapSize();
+	uTerrainBlock.clipmapLevelCount = TerrainStreamingManager::getClipmapLevelCount();
 
-	uTerrainBlock.texelSize		= 1.0f / terrainState.size;
 	uTerrainBlock.baseTessLevel = 8.0f;
 
+	uTerrainBlock.pixelScale	= cascadeView.pixelScale;
+	uTerrainBlock.maxPixelError = TerrainRenderer::getMaxPixelError();
+	uTerrainBlock.isPerspective = cascadeView.isPerspective;
+
 	updateDescriptorSet(1, 0, &uTerrainBlock);
 
+	if (TerrainStreamingManager::isLoaded()) {
+		updateDescriptorSetImage(1, 2, TextureManager::getVkSampler(),
+								 TextureManager::getTextureInfo(terrainState.heightClipmapHandle).imageView);
+		updateDescriptorSetImage(1, 3, TextureManager::getVkSampler(),
+								 TextureManager::getTextureInfo(terrainState.normalClipmapHandle).imageView);
+	}
+
 
 	const uint materialDescriptorSetId = descriptorSetArrays.size() + 1;
-	Frustum frustum { cameraBlock.projectionMatrix * cameraBlock.viewMatrix };
+
+	if (!VisibilityManager::areShadowCascadesEnabled()) {
+		return;
+	}
 
 	objectRenderer.drawObjects(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers, materialDescriptorSetId,
-							   &frustum, 1, excludeFrustums.data(), excludeFrustumCount);
+							   viewIndex);
+
+	auto& terrainPatches = terrainRenderer.updatePatches(cameraView.position, cascadeView.frustum);
+	if (!terrainPatches.empty()) {
+		updateDescriptorSet(1, 1, terrainPatches.data(), terrainPatches.size() * sizeof(TerrainRenderer::Patch));
+	}
 
-	terrainRenderer.drawTerrain(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers, materialDescriptorSetId,
-								glm::vec2(cameraPos.x, cameraPos.z), frustum);
+	terrainRenderer.drawTerrain(vkPipelineLayout, vkPipelines.data(), pSecondaryCommandBuffers,
+								materialDescriptorSetId);
 }
 } // namespace Engine
\ No newline at end of file
@@ -4,16 +4,11 @@
 #include "ObjectRenderer.hpp"
 #include "TerrainRenderer.hpp"
 
-#include <map>
+#include "engine/managers/TerrainStreamingManager.hpp"
 
 
 namespace Engine {
 class ShadowMapRenderer : public GraphicsRendererBase {
-private:
-	PROPERTY(float, "Graphics", directionalLightCascadeBase, 2.0f);
-	PROPERTY(float, "Graphics", directionalLightCascadeOffset, 0.75f);
-
-
 private:
 	struct CameraBlock {
 		glm::mat4 viewMatrix;
@@ -24,14 +19,19 @@ private:
 	};
 
 	struct TerrainBlock {
+		std::array<glm::vec4, TerrainStreamingManager::MAX_LEVEL_COUNT> clipmapLevels;
+
 		uint size;
 		uint maxHeight;
 
-		uint textureHeight;
-		uint textureNormal;
+		uint clipmapSize;
+		uint clipmapLevelCount;
 
-		float texelSize;
 		float baseTessLevel;
+
+		float pixelScale;
+		float maxPixelError;
+		uint isPerspective;
 	} uTerrainBlock;
 
 
@@ -39,8 +39,6 @@ private:
 	ObjectRenderer objectRenderer {};
 	TerrainRenderer terrainRenderer {};
 
-	std::vector<Frustum> excludeFrustums {};
-
 
 public:
 	ShadowMapRenderer() : GraphicsRendererBase(0, 2) {
@@ -55,6 +53,10 @@ public:
 		return "RENDER_PASS_SHADOW_MAP";
 	}
 
+	bool usesPositionOnlyVertexInput() const override {
+		return true;
+	}
+
 
 	std::vector<std::string> getInputNames() const override {
 		return {};
@@ -105,6 +107,10 @@ public:
 		descriptorSetDescriptions.push_back({ 0, 0, vk::DescriptorType::eUniformBuffer, sizeof(CameraBlock) });
 
 		descriptorSetDescriptions.push_back({ 1, 0, vk::DescriptorType::eUniformBuffer, sizeof(TerrainBlock) });
+		descriptorSetDescriptions.push_back(
+			{ 1, 1, vk::DescriptorType::eStorageBuffer, TerrainRenderer::getPatchBufferSize() });
+		descriptorSetDescriptions.push_back({ 1, 2, vk::DescriptorType::eCombinedImageSampler, 0 });
+		descriptorSetDescriptions.push_back({ 1, 3, vk::DescriptorType::eCombinedImageSampler, 0 });
 
 		return descriptorSetDescriptions;
 	}
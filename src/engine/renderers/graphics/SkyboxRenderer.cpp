@@ -59,13 +59,12 @@ void SkyboxRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSec
 	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, vkPipelines[shaderHandle.getIndex()]);
 
 
-	auto vertexBuffer		 = meshInfo.vertexBuffer.getVkBuffer();
-	vk::DeviceSize offsets[] = { 0 };
-	commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer, offsets);
+	vk::DeviceSize offsets[] = { 0, 0 };
+	commandBuffer.bindVertexBuffers(0, meshInfo.vertexStreamCount, meshInfo.vkVertexBuffers.data(), offsets);
 
-	auto indexBuffer = meshInfo.indexBuffer.getVkBuffer();
-	commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+	auto indexBuffer = meshInfo.vkIndexBuffer;
+	commandBuffer.bindIndexBuffer(indexBuffer, 0, meshInfo.indexType);
 
-	commandBuffer.drawIndexed(meshInfo.indexCount, 1, 0, 0, 0);
+	commandBuffer.drawIndexed(meshInfo.indexCount, 1, meshInfo.firstIndex, meshInfo.vertexOffset, 0);
 }
 } // namespace Engine
\ No newline at end of file
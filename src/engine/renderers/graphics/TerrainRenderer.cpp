@@ -10,6 +10,15 @@
 
 
 namespace Engine {
+std::vector<TerrainRenderer::Patch> TerrainRenderer::selectedPatches {};
+
+glm::vec3 TerrainRenderer::selectionCameraPosition {};
+uint TerrainRenderer::selectionTerrainVersion {};
+bool TerrainRenderer::isSelectionValid {};
+
+TerrainRenderer::Properties TerrainRenderer::properties {};
+
+
 int TerrainRenderer::init() {
 	tileMeshHandle = MeshManager::createObject<TerrainMesh>("generated_terrain_tile");
 	Generator::quad(tileMeshHandle);
@@ -18,37 +27,61 @@ int TerrainRenderer::init() {
 }
 
 
-void TerrainRenderer::drawTerrain(vk::PipelineLayout pipelineLayout, const vk::Pipeline* pPipelines,
-								  const vk::CommandBuffer* pSecondaryCommandBuffers, const uint materialDescriptorSetId,
-								  glm::vec2 cameraCenter, const Frustum& frustum) {
+std::vector<TerrainRenderer::Patch>& TerrainRenderer::updatePatches(glm::vec3 cameraPosition, const Frustum& frustum) {
+	const auto& terrainState = GlobalStateManager::get<TerrainState>();
 
-	const auto& commandBuffer = pSecondaryCommandBuffers[0];
+	patches.clear();
 
+	if (terrainState.size <= 0) {
+		return patches;
+	}
 
-	const auto& terrainState = GlobalStateManager::get<TerrainState>();
+	updateSelection(cameraPosition);
 
-	const auto& meshInfo	 = MeshManager::getMeshInfo(tileMeshHandle);
-	const auto& materialInfo = MaterialManager::getMaterialInfo(terrainState.materialHandles[0]);
 
-	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pPipelines[terrainState.shaderHandles[0].getIndex()]);
+	for (const auto& patch : selectedPatches) {
+		const float offset = patch.size * 0.5f;
 
-	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, materialDescriptorSetId, 1,
-									 &materialInfo.descriptorSet, 0, nullptr);
+		BoundingBox boundingBox {};
+		for (uint i = 0; i < 8; i++) {
+			boundingBox.points[i] = glm::vec3(patch.position.x + ((i & 1) ? offset : -offset),
+											  (i & 4) ? patch.heightBounds.y : patch.heightBounds.x,
+											  patch.position.y + ((i & 2) ? offset : -offset));
+		}
+
+		if (frustum.intersects(boundingBox)) {
+			if (patches.size() == MAX_PATCH_COUNT) {
+				spdlog::warn("[TerrainRenderer] Patch count limit of {} reached", MAX_PATCH_COUNT);
+				return patches;
+			}
+
+			patches.push_back(patch);
+		}
+	}
 
-	BoundingBox boundingBox {};
-	boundingBox.points[0] = glm::vec3(-0.5f, 0.0f, -0.5f);
-	boundingBox.points[1] = glm::vec3(-0.5f, 0.0f, 0.5f);
-	boundingBox.points[2] = glm::vec3(0.5f, 0.0f, -0.5f);
-	boundingBox.points[3] = glm::vec3(0.5f, 0.0f, 0.5f);
-	boundingBox.points[4] = glm::vec3(-0.5f, terrainState.maxHeight, -0.5f);
-	boundingBox.points[5] = glm::vec3(-0.5f, terrainState.maxHeight, 0.5f);
-	boundingBox.points[6] = glm::vec3(0.5f, terrainState.maxHeight, -0.5f);
-	boundingBox.points[7] = glm::vec3(0.5f, terrainState.maxHeight, 0.5f);
+	return patches;
+}
 
-	auto transformMatrix = glm::mat4(1.0f);
+void TerrainRenderer::updateSelection(glm::vec3 cameraPosition) {
+	const auto& terrainState = GlobalStateManager::get<TerrainState>();
 
 	int maxLod = std::log2(terrainState.size) - 1;
 
+	// Smallest patch has LOD 0
+	float minPatchSize = static_cast<float>(terrainState.size) / (1 << maxLod);
+
+	// Reloaded terrain may keep its size but not its height pyramid
+	if (isSelectionValid && selectionTerrainVersion == terrainState.version &&
+		glm::distance(cameraPosition, selectionCameraPosition) < properties.terrainLodUpdateDistance * minPatchSize) {
+		return;
+	}
+
+	selectionCameraPosition = cameraPosition;
+	selectionTerrainVersion = terrainState.version;
+	isSelectionValid		= true;
+
+	selectedPatches.clear();
+
 
 	struct Node {
 		int lod;
@@ -59,105 +92,148 @@ void TerrainRenderer::drawTerrain(vk::PipelineLayout pipelineLayout, const vk::P
 	std::queue<Node> nodes {};
 	nodes.push({ maxLod, terrainState.size, glm::vec2(0.0f) });
 
-
-	vk::DeviceSize offsets[] = { 0 };
+	auto getLod = [](float distance) {
+		return std::max(0.0f, std::log2(0.25f * distance));
+	};
 
 	while (!nodes.empty()) {
 		auto node = nodes.front();
 		nodes.pop();
 
-		transformMatrix[3] = glm::vec4(node.pos.x, 0.0, node.pos.y, 1.0f);
+		glm::vec2 heightBounds = getHeightBounds(node.pos, node.size);
 
-		transformMatrix[0][0] = node.size;
-		transformMatrix[1][1] = node.size;
-		transformMatrix[2][2] = node.size;
+		int preferredLod = getLod(getDistance(cameraPosition, node.pos, node.size, heightBounds));
 
-		int offset = node.size / 2;
 
-		glm::vec2 localPos	   = cameraCenter - node.pos;
-		glm::vec2 closestPoint = localPos;
+		if (node.lod > preferredLod) {
+			int newSize	  = node.size / 2;
+			int newOffset = newSize / 2;
 
-		closestPoint = glm::max(closestPoint, glm::vec2(-offset));
-		closestPoint = glm::min(closestPoint, glm::vec2(offset));
+			int newLod = node.lod - 1;
 
-		auto getLod = [](float distance) {
-			return std::max(0.0f, std::log2(0.25f * distance));
-		};
+			nodes.push({ newLod, newSize, node.pos + glm::vec2(-newOffset, -newOffset) });
+			nodes.push({ newLod, newSize, node.pos + glm::vec2(-newOffset, +newOffset) });
+			nodes.push({ newLod, newSize, node.pos + glm::vec2(+newOffset, -newOffset) });
+			nodes.push({ newLod, newSize, node.pos + glm::vec2(+newOffset, +newOffset) });
 
-		int preferredLod = getLod(glm::distance(localPos, closestPoint));
+		} else {
+			glm::vec2 localPos = glm::vec2(cameraPosition.x, cameraPosition.z) - node.pos;
 
+			glm::vec4 factors = glm::vec4(1.0f);
 
-		if (frustum.intersects(boundingBox.transform(transformMatrix))) {
-			if (node.lod > preferredLod) {
-				int newSize	  = node.size / 2;
-				int newOffset = newSize / 2;
+			// Only neighbours facing camera can be finer
+			glm::vec2 neighbourPosX = node.pos;
 
-				int newLod = node.lod - 1;
+			if (std::abs(localPos.x - node.size) < std::abs(localPos.x + node.size)) {
+				neighbourPosX.x += node.size;
+				factors.x += 1.0f;
+			} else {
+				neighbourPosX.x -= node.size;
+				factors.z += 1.0f;
+			}
 
-				nodes.push({ newLod, newSize, node.pos + glm::vec2(-newOffset, -newOffset) });
-				nodes.push({ newLod, newSize, node.pos + glm::vec2(-newOffset, +newOffset) });
-				nodes.push({ newLod, newSize, node.pos + glm::vec2(+newOffset, -newOffset) });
-				nodes.push({ newLod, newSize, node.pos + glm::vec2(+newOffset, +newOffset) });
+			glm::vec2 neighbourPosY = node.pos;
 
+			if (std::abs(localPos.y - node.size) < std::abs(localPos.y + node.size)) {
+				neighbourPosY.y += node.size;
+				factors.w += 1.0f;
 			} else {
-				glm::vec2 localPosX = localPos;
+				neighbourPosY.y -= node.size;
+				factors.y += 1.0f;
+			}
+
 
-				glm::vec4 factors = glm::vec4(1.0f);
+			int lodX = getLod(getDistance(cameraPosition, neighbourPosX, node.size,
+										  getHeightBounds(neighbourPosX, node.size)));
+			int lodY = getLod(getDistance(cameraPosition, neighbourPosY, node.size,
+										  getHeightBounds(neighbourPosY, node.size)));
 
-				if (std::abs(localPos.x - node.size) < std::abs(localPos.x + node.size)) {
-					localPosX.x = localPos.x - node.size;
-					factors.x += 1.0f;
-				} else {
-					localPosX.x = localPos.x + node.size;
-					factors.z += 1.0f;
-				}
 
-				glm::vec2 localPosY = localPos;
+			if ((node.lod - 1) != lodX) {
+				factors.x = 1.0f;
+				factors.z = 1.0f;
+			}
+			if ((node.lod - 1) != lodY) {
+				factors.y = 1.0f;
+				factors.w = 1.0f;
+			}
 
-				if (std::abs(localPos.y - node.size) < std::abs(localPos.y + node.size)) {
-					localPosY.y = localPos.y - node.size;
-					factors.w += 1.0f;
-				} else {
-					localPosY.y = localPos.y + node.size;
-					factors.y += 1.0f;
-				}
+			Patch patch {};
+			patch.position	   = node.pos;
+			patch.size		   = node.size;
+			patch.lod		   = node.lod;
+			patch.tessFactors  = factors;
+			patch.heightBounds = heightBounds;
+			patch.curvature	   = getCurvature(node.pos, node.size);
 
+			selectedPatches.push_back(patch);
+		}
+	}
+}
 
-				glm::vec2 closestPointX = localPosX;
-				glm::vec2 closestPointY = localPosY;
 
-				closestPointX = glm::max(closestPointX, glm::vec2(-offset));
-				closestPointX = glm::min(closestPointX, glm::vec2(offset));
+glm::vec2 TerrainRenderer::getHeightBounds(glm::vec2 position, float size) {
+	const auto& terrainState = GlobalStateManager::get<TerrainState>();
 
-				closestPointY = glm::max(closestPointY, glm::vec2(-offset));
-				closestPointY = glm::min(closestPointY, glm::vec2(offset));
+	// Same mapping as in tessellation evaluation shader
+	glm::vec2 minTexCoord = (position - size * 0.5f) / static_cast<float>(terrainState.size) + 0.5f;
+	glm::vec2 maxTexCoord = (position + size * 0.5f) / static_cast<float>(terrainState.size) + 0.5f;
 
-				int lodX = getLod(glm::distance(localPosX, closestPointX));
-				int lodY = getLod(glm::distance(localPosY, closestPointY));
+	glm::vec2 heightRange = terrainState.heightPyramid.getHeightRange(minTexCoord, maxTexCoord);
 
+	return heightRange * static_cast<float>(terrainState.maxHeight);
+}
 
-				if ((node.lod - 1) != lodX) {
-					factors.x = 1.0f;
-					factors.z = 1.0f;
-				}
-				if ((node.lod - 1) != lodY) {
-					factors.y = 1.0f;
-					factors.w = 1.0f;
-				}
+float TerrainRenderer::getCurvature(glm::vec2 position, float size) {
+	const auto& terrainState = GlobalStateManager::get<TerrainState>();
 
-				commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eAll, 0, 64, &transformMatrix);
-				commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eAll, 64, 16, &factors);
-				commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eAll, 80, 4, &node.lod);
+	glm::vec2 minTexCoord = (position - size * 0.5f) / static_cast<float>(terrainState.size) + 0.5f;
+	glm::vec2 maxTexCoord = (position + size * 0.5f) / static_cast<float>(terrainState.size) + 0.5f;
 
-				auto vertexBuffer = meshInfo.vertexBuffer.getVkBuffer();
-				commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer, offsets);
+	float texelSize = static_cast<float>(terrainState.size) / std::max(terrainState.heightPyramid.getSize().x, 1u);
 
-				auto indexBuffer = meshInfo.indexBuffer.getVkBuffer();
-				commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+	float curvature = terrainState.heightPyramid.getCurvature(minTexCoord, maxTexCoord);
 
-				commandBuffer.drawIndexed(meshInfo.indexCount, 1, 0, 0, 0);
-			}
-		}
+	return curvature * terrainState.maxHeight / (texelSize * texelSize);
+}
+
+float TerrainRenderer::getDistance(glm::vec3 cameraPosition, glm::vec2 position, float size, glm::vec2 heightBounds) {
+	const float offset = size * 0.5f;
+
+	glm::vec3 minPoint = glm::vec3(position.x - offset, heightBounds.x, position.y - offset);
+	glm::vec3 maxPoint = glm::vec3(position.x + offset, heightBounds.y, position.y + offset);
+
+	return glm::distance(cameraPosition, glm::clamp(cameraPosition, minPoint, maxPoint));
+}
+
+void TerrainRenderer::drawTerrain(vk::PipelineLayout pipelineLayout, const vk::Pipeline* pPipelines,
+								  const vk::CommandBuffer* pSecondaryCommandBuffers,
+								  const uint materialDescriptorSetId) {
+	if (patches.empty()) {
+		return;
 	}
+
+	const auto& commandBuffer = pSecondaryCommandBuffers[0];
+
+
+	const auto& terrainState = GlobalStateManager::get<TerrainState>();
+
+	const auto& meshInfo = MeshManager::getMeshInfo(tileMeshHandle);
+
+	const auto materialDescriptorSet = MaterialManager::getVkDescriptorSet();
+	const uint32_t materialIndex	 = terrainState.materialHandles[0].getIndex();
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pPipelines[terrainState.shaderHandles[0].getIndex()]);
+
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, materialDescriptorSetId, 1,
+									 &materialDescriptorSet, 0, nullptr);
+	commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eAll, 64, 4, &materialIndex);
+
+	vk::DeviceSize offsets[] = { 0, 0 };
+	commandBuffer.bindVertexBuffers(0, meshInfo.vertexStreamCount, meshInfo.vkVertexBuffers.data(), offsets);
+	commandBuffer.bindIndexBuffer(meshInfo.vkIndexBuffer, 0, meshInfo.indexType);
+
+	// Every patch is an instance of the same tile mesh
+	commandBuffer.drawIndexed(meshInfo.indexCount, patches.size(), meshInfo.firstIndex, meshInfo.vertexOffset, 0);
 }
 } // namespace Engine
\ No newline at end of file
@@ -2,27 +2,95 @@
 
 #include "engine/graphics/Frustum.hpp"
 
+#include "engine/managers/ConfigManager.hpp"
 #include "engine/managers/MeshManager.hpp"
 
 #define VULKAN_HPP_NO_EXCEPTIONS 1
 #include <vulkan/vulkan.hpp>
 
+#include <glm/glm.hpp>
+
 #include <map>
 #include <vector>
 
 
 namespace Engine {
+// Selects quadtree leaf patches on the CPU and draws all of them with a single instanced call. Patches are read by
+// shaders from a storage buffer owned by the calling renderer. LOD selection does not depend on view, so it is shared
+// by all instances and only recomputed once camera moves far enough, each view just culls it.
 class TerrainRenderer {
+public:
+	static constexpr uint MAX_PATCH_COUNT = 4096;
+
+	// Matches TerrainPatch in shaders
+	struct Patch {
+		glm::vec2 position;
+		float size;
+		uint lod;
+
+		// Tessellation multipliers of right, bottom, left and top edges, matching coarser neighbours
+		glm::vec4 tessFactors;
+
+		// World space min and max heights from height pyramid
+		glm::vec2 heightBounds;
+
+		// Max second difference of world heights per squared world unit, drives inner tessellation level
+		float curvature;
+
+		float _padding;
+	};
+
+
 private:
 	MeshManager::Handle tileMeshHandle {};
 
+	// Selected patches culled against last view
+	std::vector<Patch> patches {};
+
+	// Leaf patches of whole terrain selected for camera position below
+	static std::vector<Patch> selectedPatches;
+
+	static glm::vec3 selectionCameraPosition;
+	static uint selectionTerrainVersion;
+	static bool isSelectionValid;
+
+	struct Properties {
+		// Camera displacement relative to smallest patch size after which LOD selection is recomputed
+		PROPERTY(float, "Graphics", terrainLodUpdateDistance, 0.25f);
+
+		// Screen space error in pixels tessellated terrain is allowed to have
+		PROPERTY(float, "Graphics", terrainMaxPixelError, 1.0f);
+	};
+
+	static Properties properties;
+
 
 public:
 	int init();
 
+	// Culls shared LOD selection against frustum, result has to be uploaded before drawing
+	std::vector<Patch>& updatePatches(glm::vec3 cameraPosition, const Frustum& frustum);
+
+	static inline float getMaxPixelError() {
+		return properties.terrainMaxPixelError;
+	}
 
 	void drawTerrain(vk::PipelineLayout pipelineLayout, const vk::Pipeline* pPipelines,
-					 const vk::CommandBuffer* pSecondaryCommandBuffers, const uint materialDescriptorSetId,
-					 glm::vec2 cameraCenter, const Frustum& frustum);
+					 const vk::CommandBuffer* pSecondaryCommandBuffers, const uint materialDescriptorSetId);
+
+
+	static constexpr uint64_t getPatchBufferSize() {
+		return MAX_PATCH_COUNT * sizeof(Patch);
+	}
+
+
+private:
+	static void updateSelection(glm::vec3 cameraPosition);
+
+	static glm::vec2 getHeightBounds(glm::vec2 position, float size);
+	static float getCurvature(glm::vec2 position, float size);
+
+	// Distance from camera to node bounding box
+	static float getDistance(glm::vec3 cameraPosition, glm::vec2 position, float size, glm::vec2 heightBounds);
 };
 } // namespace Engine
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "HiZReadbackRenderer.hpp"
+
+
+namespace Engine {
+int HiZReadbackRenderer::init() {
+	spdlog::info("Initializing HiZReadbackRenderer...");
+
+	assert(vmaAllocator != nullptr);
+	assert(outputSize != vk::Extent2D());
+
+	const uint texelCount = outputSize.width * outputSize.height;
+
+	depths.resize(texelCount);
+
+	readbackBuffers.resize(framesInFlightCount,
+						   Buffer(vk::BufferUsageFlagBits::eTransferDst, VMA_MEMORY_USAGE_GPU_TO_CPU));
+	viewProjectionMatrices.resize(framesInFlightCount);
+	readbackPending.resize(framesInFlightCount);
+
+	for (auto& buffer : readbackBuffers) {
+		auto result = buffer.allocate(vmaAllocator, texelCount * sizeof(float));
+		if (result != vk::Result::eSuccess) {
+			spdlog::error("[{}] Failed to allocate readback buffer. Error code: {} ({})", rendererName, result,
+						  vk::to_string(result));
+			return 1;
+		}
+	}
+
+	return TransferRendererBase::init();
+}
+
+
+void HiZReadbackRenderer::dispose() {
+	for (auto& buffer : readbackBuffers) {
+		buffer.destroy();
+	}
+	readbackBuffers.clear();
+
+	RendererBase::dispose();
+}
+
+
+void HiZReadbackRenderer::recordSecondaryCommandBuffers(const vk::CommandBuffer* pSecondaryCommandBuffers, double dt) {
+	const auto& commandBuffer = pSecondaryCommandBuffers[0];
+
+	auto& readbackBuffer = readbackBuffers[currentFrameInFlight];
+
+
+	// Fence of current frame in flight has been waited for, previous copy is complete
+
+	if (readbackPending[currentFrameInFlight]) {
+		auto result = readbackBuffer.read(depths.data());
+		if (result == vk::Result::eSuccess) {
+			VisibilityManager::updateOcclusionBuffer(depths.data(), outputSize.width, outputSize.height,
+													 viewProjectionMatrices[currentFrameInFlight]);
+		}
+	}
+
+
+	const auto& cameraView = VisibilityManager::getViewInfo(VisibilityManager::VIEW_CAMERA);
+
+	viewProjectionMatrices[currentFrameInFlight] = cameraView.projectionMatrix * cameraView.viewMatrix;
+	readbackPending[currentFrameInFlight]		 = true;
+
+	const auto textureInfo = TextureManager::getTextureInfo(inputs[0]);
+
+	vk::BufferImageCopy bufferImageCopy {};
+	bufferImageCopy.imageSubresource.aspectMask		= vk::ImageAspectFlagBits::eColor;
+	bufferImageCopy.imageSubresource.mipLevel		= 0;
+	bufferImageCopy.imageSubresource.baseArrayLayer = 0;
+	bufferImageCopy.imageSubresource.layerCount		= 1;
+	bufferImageCopy.imageExtent						= vk::Extent3D(outputSize.width, outputSize.height, 1);
+
+	commandBuffer.copyImageToBuffer(textureInfo.image, vk::ImageLayout::eTransferSrcOptimal,
+									readbackBuffer.getVkBuffer(), 1, &bufferImageCopy);
+}
+} // namespace Engine
\ No newline at end of file
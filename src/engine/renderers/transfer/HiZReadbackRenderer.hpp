@@ -0,0 +1,64 @@
+#pragma once
+
+#include "TransferRendererBase.hpp"
+
+#include "engine/graphics/Buffer.hpp"
+
+#include <glm/glm.hpp>
+
+
+namespace Engine {
+// Copies hierarchical depth buffer into host visible memory. Copy of a frame in flight is handed over to
+// VisibilityManager once its fence is signaled, so occlusion is tested against depth several frames old.
+class HiZReadbackRenderer : public TransferRendererBase {
+private:
+	std::vector<Buffer> readbackBuffers {};
+
+	// View projection matrix used to render depth of each readback
+	std::vector<glm::mat4> viewProjectionMatrices {};
+	std::vector<bool> readbackPending {};
+
+	std::vector<float> depths {};
+
+
+public:
+	HiZReadbackRenderer() : TransferRendererBase(1, 0) {
+	}
+
+
+	int init() override;
+
+	void dispose() override;
+
+	virtual void recordSecondaryCommandBuffers(const vk::CommandBuffer* pSecondaryCommandBuffers, double dt) override;
+
+
+	virtual std::vector<std::string> getInputNames() const {
+		return { "HiZBuffer" };
+	}
+
+	virtual std::vector<std::string> getOutputNames() const {
+		return {};
+	}
+
+
+	std::vector<AttachmentDescription> getInputDescriptions() const override {
+		std::vector<AttachmentDescription> descriptions {};
+		descriptions.resize(1);
+
+		descriptions[0].format = vk::Format::eR32Sfloat;
+		descriptions[0].usage  = vk::ImageUsageFlagBits::eTransferSrc;
+
+		return descriptions;
+	}
+
+	std::vector<vk::ImageLayout> getInputInitialLayouts() const override {
+		std::vector<vk::ImageLayout> initialLayouts {};
+		initialLayouts.resize(1);
+
+		initialLayouts[0] = vk::ImageLayout::eTransferSrcOptimal;
+
+		return initialLayouts;
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -10,6 +10,9 @@ namespace Engine {
 class DebugState {
 public:
 	float avgFrameTime {};
+
+	// Seconds from start of initialization until first frame was presented
+	float timeToFirstFrame {};
 	std::unordered_map<std::string, std::vector<float>> rendererExecutionTimes {};
 
 	struct ExecutionTime {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "engine/graphics/HeightPyramid.hpp"
+
 #include "engine/managers/GraphicsShaderManager.hpp"
 #include "engine/managers/MaterialManager.hpp"
 #include "engine/managers/TextureManager.hpp"
@@ -13,8 +15,14 @@ public:
 	int size {};
 	uint maxHeight {};
 
-	TextureManager::Handle heightMapHandle {};
-	TextureManager::Handle normalMapHandle {};
+	// Incremented every time a terrain is loaded, so state derived from terrain can tell it is outdated
+	uint version {};
+
+	// Texture arrays with a layer per streamed level, filled by TerrainStreamingManager
+	TextureManager::Handle heightClipmapHandle {};
+	TextureManager::Handle normalClipmapHandle {};
+
+	HeightPyramid heightPyramid {};
 
 	std::array<MaterialManager::Handle, 4> materialHandles {};
 	std::array<GraphicsShaderManager::Handle, 4> shaderHandles {};
@@ -89,6 +89,7 @@ void ImGuiSystem::showStatisticsWindow() {
 	if (ImGui::Begin("Statistics", nullptr)) {
 		ImGui::Text("Avg. Frame Time: %.3f ms (%.1f fps)", debugState.avgFrameTime * 1000.0f,
 					1.0f / debugState.avgFrameTime);
+		ImGui::Text("Time to First Frame: %.3f s", debugState.timeToFirstFrame);
 
 		if (ImGui::BeginTable("Table", 3, ImGuiTableFlags_PadOuterX | ImGuiTableFlags_SizingFixedFit)) {
 			ImGui::TableSetupColumn("System");
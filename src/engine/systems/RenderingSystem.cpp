@@ -6,6 +6,12 @@
 
 
 namespace Engine {
+struct PipelineUpdateInfo {
+	GraphicsRendererBase* pRenderer;
+	int result;
+};
+
+
 void RenderingSystem::RenderGraph::addInputConnection(std::string srcName, std::string srcOutputName,
 													  std::string dstName, std::string dstInputName, bool nextFrame) {
 	nodes[srcName].inputReferenceSets[srcOutputName].insert({ dstName, dstInputName, nextFrame });
@@ -84,6 +90,10 @@ int RenderingSystem::init() {
 		return 1;
 	}
 
+	if (PipelineCache::init(getActivePhysicalDevice(), vkDevice, pipelineCreationFeedbackSupported)) {
+		return 1;
+	}
+
 	if (initVulkanMemoryAllocator()) {
 		return 1;
 	}
@@ -139,10 +149,29 @@ int RenderingSystem::init() {
 		return 1;
 	}
 
+	if (GraphicsShaderManager::importShaderSources<HiZShader>(
+			std::array<std::string, 6> { "assets/shaders/hi_z.vsh", "", "", "", "assets/shaders/hi_z.fsh", "" })) {
+		return 1;
+	}
+
+
+	auto queueFamilies = getQueueFamilies(getActivePhysicalDevice());
+
+	UploadManager::setVkDevice(vkDevice);
+	UploadManager::setVulkanMemoryAllocator(vmaAllocator);
+	UploadManager::setVkGraphicsQueue(vkGraphicsQueue, queueFamilies.graphicsFamily);
+	if (queueFamilies.transferFamily != -1) {
+		UploadManager::setVkTransferQueue(vkTransferQueue, queueFamilies.transferFamily);
+	} else {
+		UploadManager::setVkTransferQueue(vkGraphicsQueue, queueFamilies.graphicsFamily);
+	}
+	if (UploadManager::init()) {
+		return 1;
+	}
+
 
 	TextureManager::setVkDevice(vkDevice);
-	TextureManager::setVkCommandPool(vkCommandPools[0]);
-	TextureManager::setVkTransferQueue(vkGraphicsQueue);
+	TextureManager::setFramesInFlightCount(framesInFlightCount);
 	TextureManager::setVulkanMemoryAllocator(vmaAllocator);
 	TextureManager::init();
 
@@ -157,15 +186,28 @@ int RenderingSystem::init() {
 
 
 	MeshManager::setVkDevice(vkDevice);
-	MeshManager::setVkCommandPool(vkCommandPools[0]);
-	MeshManager::setVkTransferQueue(vkGraphicsQueue);
+	MeshManager::setFramesInFlightCount(framesInFlightCount);
 	MeshManager::setVulkanMemoryAllocator(vmaAllocator);
 	MeshManager::init();
 
 
 	MaterialManager::setVkDevice(vkDevice);
 	MaterialManager::setVulkanMemoryAllocator(vmaAllocator);
-	MaterialManager::init();
+	if (MaterialManager::init()) {
+		return 1;
+	}
+
+	if (VisibilityManager::init(threadCount, shadowMapSize)) {
+		return 1;
+	}
+
+	if (TerrainStreamingManager::init()) {
+		return 1;
+	}
+
+	if (TextureStreamingManager::init()) {
+		return 1;
+	}
 
 	// auto materialHandle = MaterialManager::createObject(0);
 	// materialHandle.apply([](auto& material) {
@@ -245,6 +287,13 @@ int RenderingSystem::init() {
 	volumetricLightBlurYRenderer->setOutputFormat(vk::Format::eR16G16B16A16Sfloat);
 
 
+	auto hiZRenderer = std::make_shared<HiZRenderer>();
+	hiZRenderer->setOutputSize({ occlusionBufferWidth, occlusionBufferHeight });
+
+	auto hiZReadbackRenderer = std::make_shared<HiZReadbackRenderer>();
+	hiZReadbackRenderer->setOutputSize({ occlusionBufferWidth, occlusionBufferHeight });
+
+
 	renderers["DepthNormalRenderer"]		  = depthNormalRenderer;
 	renderers["ForwardRenderer"]			  = forwardRenderer;
 	renderers["ShadowMapRenderer"]			  = shadowMapRenderer;
@@ -261,6 +310,8 @@ int RenderingSystem::init() {
 	renderers["VolumetricLightRenderer"]	  = volumetricLightRenderer;
 	renderers["VolumetricLightBlurXRenderer"] = volumetricLightBlurXRenderer;
 	renderers["VolumetricLightBlurYRenderer"] = volumetricLightBlurYRenderer;
+	renderers["HiZRenderer"]				  = hiZRenderer;
+	renderers["HiZReadbackRenderer"]		  = hiZReadbackRenderer;
 
 
 	renderGraph.addOutputConnection("SkymapRenderer", "SkyMap", "SkyMipMapRenderer", "Buffer");
@@ -278,6 +329,9 @@ int RenderingSystem::init() {
 	renderGraph.addInputConnection("SkyMipMapRenderer", "Buffer", "ReflectionRenderer", "EnvironmentMap");
 
 	renderGraph.addInputConnection("DepthNormalRenderer", "DepthBuffer", "VolumetricLightRenderer", "DepthBuffer");
+
+	renderGraph.addInputConnection("DepthNormalRenderer", "DepthBuffer", "HiZRenderer", "DepthBuffer");
+	renderGraph.addInputConnection("HiZRenderer", "HiZBuffer", "HiZReadbackRenderer", "HiZBuffer");
 	renderGraph.addInputConnection("ShadowMipMapRenderer", "Buffer", "VolumetricLightRenderer", "ShadowMap");
 
 	renderGraph.addInputConnection("VolumetricLightRenderer", "VolumetricLightBuffer", "VolumetricLightBlurXRenderer",
@@ -864,6 +918,18 @@ int RenderingSystem::init() {
 		renderer->init();
 	}
 
+	pipelineThreadPool.init(
+		[](uint threadIndex, void* pData) {
+			auto& updateInfo = *static_cast<PipelineUpdateInfo*>(pData);
+
+			updateInfo.result = updateInfo.pRenderer->updateGraphicsPipelines();
+		},
+		std::max<uint>(std::thread::hardware_concurrency(), 1));
+
+	if (updateGraphicsPipelines()) {
+		return 1;
+	}
+
 	finalTextureHandle = renderers[finalRendererName]->getOutput(finalSlotIndex);
 
 	// for (auto& renderer : renderers) {
@@ -1151,6 +1217,10 @@ int RenderingSystem::run(double dt) {
 	executionTimes[executionTimeIndex].cpuTime = cpuTimings["SwapchainPresent"];
 
 
+	// Ranges of replaced meshes are not read by frames in flight anymore
+	MeshManager::update();
+
+
 	// Reset command buffers
 
 	auto commandPoolIndex = getCommandPoolIndex(currentFrameInFlight, 0);
@@ -1160,6 +1230,36 @@ int RenderingSystem::run(double dt) {
 	}
 
 
+	// Cull all views at once, passes consume cached results
+
+	VisibilityManager::update();
+
+	// Streamed terrain follows camera, committed tiles are visible to this frame
+	if (TerrainStreamingManager::update(VisibilityManager::getViewInfo(VisibilityManager::VIEW_CAMERA).position)) {
+		return 1;
+	}
+
+	// Loaded textures are uploaded along with the rest of this frame's uploads
+	TextureStreamingManager::update();
+
+	PipelineCache::update();
+
+	// Reloaded variants are swapped in by pipeline updates once rebuilt
+	GraphicsShaderManager::reloadChangedSources();
+
+	if (updateGraphicsPipelines()) {
+		return 1;
+	}
+
+	// Uploads recorded so far are submitted ahead of rendering commands
+	if (UploadManager::update()) {
+		return 1;
+	}
+
+	// Texture descriptors changed by now are written into this frame's set, which is no longer in use
+	TextureManager::updateDescriptorSet(currentFrameInFlight);
+
+
 	for (const auto& rendererName : rendererExecutionOrder) {
 		CPUTimer cpuTimer {};
 		cpuTimer.start();
@@ -1178,7 +1278,10 @@ int RenderingSystem::run(double dt) {
 		const auto& timestampQueryPool = getTimestampQueryPool(currentFrameInFlight, rendererIndex);
 
 
-		renderer->render(pPrimaryCommandBuffers, pSecondaryCommandBuffers, timestampQueryPool, dt);
+		if (renderer->render(pPrimaryCommandBuffers, pSecondaryCommandBuffers, timestampQueryPool, dt)) {
+			spdlog::error("Failed to render '{}'", rendererName);
+			return 1;
+		}
 
 
 		const auto& rendererWaitSemaphoresViews = getRendererWaitSemaphoresView(currentFrameInFlight, rendererIndex);
@@ -1416,6 +1519,46 @@ int RenderingSystem::enumeratePhysicalDevices() {
 	return 0;
 }
 
+int RenderingSystem::updateGraphicsPipelines() {
+	std::vector<PipelineUpdateInfo> updateInfos {};
+	for (auto& [rendererName, renderer] : renderers) {
+		if (auto pGraphicsRenderer = dynamic_cast<GraphicsRendererBase*>(renderer.get())) {
+			updateInfos.push_back({ pGraphicsRenderer, 0 });
+		}
+	}
+
+	// Without new requests or invalidations updates only pick up background pipelines and destroy retired ones, which
+	// is not worth distributing between threads
+	const auto requestCount		 = GraphicsShaderManager::getRequestedCount();
+	const auto invalidationCount = GraphicsShaderManager::getInvalidatedCount();
+	if (requestCount == processedShaderRequestCount && invalidationCount == processedShaderInvalidationCount) {
+		for (auto& updateInfo : updateInfos) {
+			if (updateInfo.pRenderer->updateGraphicsPipelines()) {
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+	processedShaderRequestCount		 = requestCount;
+	processedShaderInvalidationCount = invalidationCount;
+
+	for (auto& updateInfo : updateInfos) {
+		pipelineThreadPool.appendData(&updateInfo);
+	}
+
+	pipelineThreadPool.waitForAll();
+
+	for (const auto& updateInfo : updateInfos) {
+		if (updateInfo.result) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
 int RenderingSystem::createLogicalDevice() {
 	auto queueFamilies = getQueueFamilies(getActivePhysicalDevice());
 
@@ -1426,13 +1569,18 @@ int RenderingSystem::createLogicalDevice() {
 		queueFamilyIndices = { queueFamilies.graphicsFamily, queueFamilies.presentFamily };
 	}
 
+	// Uploads run on dedicated transfer queue alongside rendering if there is one
+	if (queueFamilies.transferFamily != -1) {
+		queueFamilyIndices.push_back(queueFamilies.transferFamily);
+	}
+
+	float queuePriority = 1.0f;
+
 	std::vector<vk::DeviceQueueCreateInfo> deviceQueueCreateInfos(queueFamilyIndices.size());
 	for (uint i = 0; i < queueFamilyIndices.size(); i++) {
 		auto& deviceQueueCreateInfo			   = deviceQueueCreateInfos[i];
 		deviceQueueCreateInfo.queueCount	   = 1;
 		deviceQueueCreateInfo.queueFamilyIndex = queueFamilyIndices[i];
-
-		float queuePriority					   = 1.0f;
 		deviceQueueCreateInfo.pQueuePriorities = &queuePriority;
 	}
 
@@ -1446,8 +1594,28 @@ int RenderingSystem::createLogicalDevice() {
 
 	deviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
 
-	deviceCreateInfo.enabledExtensionCount	 = requiredDeviceExtensionNames.size();
-	deviceCreateInfo.ppEnabledExtensionNames = requiredDeviceExtensionNames.data();
+	auto deviceExtensionNames = requiredDeviceExtensionNames;
+
+	uint32_t extensionCount = 0;
+	RETURN_IF_VK_ERROR(getActivePhysicalDevice().enumerateDeviceExtensionProperties(nullptr, &extensionCount, nullptr),
+					   "Failed to enumerate device extension properties");
+
+	std::vector<vk::ExtensionProperties> availableExtensions(extensionCount);
+	RETURN_IF_VK_ERROR(getActivePhysicalDevice().enumerateDeviceExtensionProperties(nullptr, &extensionCount,
+																					  availableExtensions.data()),
+					   "Failed to enumerate device extension properties");
+
+	pipelineCreationFeedbackSupported = false;
+	for (const auto& extension : availableExtensions) {
+		if (!strcmp(extension.extensionName, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME)) {
+			pipelineCreationFeedbackSupported = true;
+			deviceExtensionNames.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+			break;
+		}
+	}
+
+	deviceCreateInfo.enabledExtensionCount	 = deviceExtensionNames.size();
+	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensionNames.data();
 
 	RETURN_IF_VK_ERROR(getActivePhysicalDevice().createDevice(&deviceCreateInfo, nullptr, &vkDevice),
 					   "Failed to create Vulkan device");
@@ -1455,6 +1623,10 @@ int RenderingSystem::createLogicalDevice() {
 	vkDevice.getQueue(queueFamilies.graphicsFamily, 0, &vkGraphicsQueue);
 	vkDevice.getQueue(queueFamilies.presentFamily, 0, &vkPresentQueue);
 
+	if (queueFamilies.transferFamily != -1) {
+		vkDevice.getQueue(queueFamilies.transferFamily, 0, &vkTransferQueue);
+	}
+
 	return 0;
 }
 
@@ -1588,6 +1760,14 @@ RenderingSystem::QueueFamilyIndices RenderingSystem::getQueueFamilies(vk::Physic
 		if (presentSupport) {
 			queueFamilyIndices.presentFamily = i;
 		}
+
+		// Transfer only families are backed by copy engines. Texture regions are copied at texel granularity.
+		const auto& granularity = queueFamilies[i].minImageTransferGranularity;
+		if ((queueFamilies[i].queueFlags & vk::QueueFlagBits::eTransfer) &&
+			!(queueFamilies[i].queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) &&
+			granularity.width == 1 && granularity.height == 1 && granularity.depth == 1) {
+			queueFamilyIndices.transferFamily = i;
+		}
 	}
 
 	return queueFamilyIndices;
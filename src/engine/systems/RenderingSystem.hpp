@@ -4,12 +4,14 @@
 
 // FIXME: test
 #include "engine/graphics/Buffer.hpp"
+#include "engine/graphics/PipelineCache.hpp"
 #include "engine/graphics/meshes/StaticMesh.hpp"
 
 #include "engine/renderers/RendererBase.hpp"
 
 
 #include "engine/utils/IO.hpp"
+#include "engine/utils/ThreadPool.hpp"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -43,6 +45,9 @@ private:
 		uint32_t graphicsFamily = -1;
 		uint32_t presentFamily	= -1;
 
+		// Optional family dedicated to transfers
+		uint32_t transferFamily = -1;
+
 		bool isComplete() {
 			return (graphicsFamily != -1) && (presentFamily != -1);
 		}
@@ -119,6 +124,9 @@ private:
 
 	PROPERTY(float, "Graphics", volumetricLightResolutionScale, 0.5);
 
+	PROPERTY(uint, "Graphics", occlusionBufferWidth, 256);
+	PROPERTY(uint, "Graphics", occlusionBufferHeight, 128);
+
 	PROPERTY(uint, "Debug", enableValidationLayers, 0);
 
 
@@ -132,6 +140,7 @@ private:
 
 	vk::Queue vkGraphicsQueue;
 	vk::Queue vkPresentQueue;
+	vk::Queue vkTransferQueue;
 
 	struct SwapchainInfo {
 		vk::SwapchainKHR swapchain;
@@ -184,6 +193,9 @@ private:
 
 	std::vector<const char*> validationLayers = {};
 
+	// Optional extension, enabled when available to track pipeline cache hits
+	bool pipelineCreationFeedbackSupported {};
+
 	std::vector<vk::PhysicalDevice> vkSupportedPhysicalDevices;
 	uint32_t activePhysicalDeviceIndex = 0;
 
@@ -204,6 +216,12 @@ private:
 
 	std::map<std::string, float> cpuTimings {};
 
+	// Builds pipelines of all graphics renderers concurrently when new shader handles are requested or variants are
+	// invalidated by shader reloads
+	ThreadPool pipelineThreadPool {};
+	uint processedShaderRequestCount {};
+	uint processedShaderInvalidationCount {};
+
 
 public:
 	~RenderingSystem() {
@@ -213,6 +231,16 @@ public:
 			renderer->dispose();
 		}
 
+		GraphicsShaderManager::dispose();
+		PipelineCache::dispose();
+
+		TextureStreamingManager::dispose();
+
+		// Completes pending uploads, so that resources are not referenced by batches when destroyed
+		UploadManager::dispose();
+
+		VisibilityManager::dispose();
+		TerrainStreamingManager::dispose();
 		MeshManager::destroy();
 		MaterialManager::dispose();
 		TextureManager::dispose();
@@ -234,6 +262,10 @@ private:
 
 	int createSwapchain();
 
+	// Creates pipelines for newly requested shader handles and rebuilds reloaded ones, renderers are updated in
+	// parallel. Has to be called once per frame, it is the only place graphics renderer pipelines are updated from.
+	int updateGraphicsPipelines();
+
 	int present();
 
 
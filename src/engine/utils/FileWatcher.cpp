@@ -0,0 +1,90 @@
+#include "FileWatcher.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+
+namespace Engine {
+int FileWatcher::init() {
+	close();
+
+	fileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fileDescriptor < 0) {
+		spdlog::error("[FileWatcher] Failed to initialize inotify");
+		return 1;
+	}
+
+	return 0;
+}
+
+void FileWatcher::close() {
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+	}
+
+	fileDescriptor = -1;
+	watches.clear();
+}
+
+
+int FileWatcher::addDirectory(std::string directory) {
+	assert(isOpen());
+
+	for (const auto& watch : watches) {
+		if (watch.directory == directory) {
+			return 0;
+		}
+	}
+
+	int descriptor = inotify_add_watch(fileDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (descriptor < 0) {
+		spdlog::error("[FileWatcher] Failed to watch directory '{}'", directory);
+		return 1;
+	}
+
+	watches.push_back({ descriptor, directory });
+
+	return 0;
+}
+
+
+void FileWatcher::poll(std::vector<std::string>& changedFilenames) {
+	if (!isOpen()) {
+		return;
+	}
+
+	alignas(inotify_event) std::array<char, 4096> buffer;
+
+	while (true) {
+		auto size = read(fileDescriptor, buffer.data(), buffer.size());
+		if (size <= 0) {
+			break;
+		}
+
+		for (ssize_t offset = 0; offset < size;) {
+			const auto* pEvent = reinterpret_cast<const inotify_event*>(&buffer[offset]);
+
+			auto iter = std::find_if(watches.begin(), watches.end(), [pEvent](const Watch& watch) {
+				return watch.descriptor == pEvent->wd;
+			});
+
+			if (iter != watches.end() && pEvent->len > 0) {
+				auto filename = iter->directory + "/" + pEvent->name;
+
+				// Editors often produce several events for a single save
+				if (std::find(changedFilenames.begin(), changedFilenames.end(), filename) == changedFilenames.end()) {
+					changedFilenames.push_back(filename);
+				}
+			}
+
+			offset += sizeof(inotify_event) + pEvent->len;
+		}
+	}
+}
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+namespace Engine {
+// Watches directories for modified files with inotify. Changes are polled without blocking, files replaced by a
+// rename (as most editors save) are reported as well.
+class FileWatcher {
+private:
+	struct Watch {
+		int descriptor;
+		std::string directory;
+	};
+
+	std::vector<Watch> watches {};
+
+	int fileDescriptor = -1;
+
+
+public:
+	FileWatcher() = default;
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	~FileWatcher() {
+		close();
+	}
+
+
+	int init();
+	void close();
+
+	// Adding the same directory again has no effect
+	int addDirectory(std::string directory);
+
+	// Appends paths of files modified since last poll, each path is directory as added joined with file name
+	void poll(std::vector<std::string>& changedFilenames);
+
+
+	inline bool isOpen() const {
+		return fileDescriptor >= 0;
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "FreeListAllocator.hpp"
+
+#include <cassert>
+#include <iterator>
+
+
+namespace Engine {
+void FreeListAllocator::init(uint64_t size) {
+	freeBlocks.clear();
+
+	capacity = size;
+	freeSize = size;
+
+	if (size > 0) {
+		freeBlocks[0] = size;
+	}
+}
+
+
+int FreeListAllocator::allocate(uint64_t size, uint64_t& offset) {
+	if (size == 0) {
+		offset = 0;
+		return 0;
+	}
+
+	auto bestBlock = freeBlocks.end();
+
+	for (auto block = freeBlocks.begin(); block != freeBlocks.end(); block++) {
+		if (block->second >= size && (bestBlock == freeBlocks.end() || block->second < bestBlock->second)) {
+			bestBlock = block;
+
+			if (block->second == size) {
+				break;
+			}
+		}
+	}
+
+	if (bestBlock == freeBlocks.end()) {
+		return 1;
+	}
+
+	offset = bestBlock->first;
+
+	const uint64_t remainingSize = bestBlock->second - size;
+
+	freeBlocks.erase(bestBlock);
+
+	if (remainingSize > 0) {
+		freeBlocks[offset + size] = remainingSize;
+	}
+
+	freeSize -= size;
+
+	return 0;
+}
+
+void FreeListAllocator::free(uint64_t offset, uint64_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	assert(offset + size <= capacity);
+
+	auto [block, isInserted] = freeBlocks.emplace(offset, size);
+	assert(isInserted);
+
+	// Merge with following block
+	auto nextBlock = std::next(block);
+	if (nextBlock != freeBlocks.end() && block->first + block->second == nextBlock->first) {
+		block->second += nextBlock->second;
+		freeBlocks.erase(nextBlock);
+	}
+
+	// Merge with preceding block
+	if (block != freeBlocks.begin()) {
+		auto prevBlock = std::prev(block);
+
+		if (prevBlock->first + prevBlock->second == block->first) {
+			prevBlock->second += block->second;
+			freeBlocks.erase(block);
+		}
+	}
+
+	freeSize += size;
+}
+} // namespace Engine
\ No newline at end of file
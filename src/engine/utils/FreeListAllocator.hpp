@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+
+namespace Engine {
+// Sub-allocates ranges of an externally owned resource, units are defined by the user (bytes, vertices, indices)
+class FreeListAllocator {
+private:
+	// Free block offset to size, ordered by offset so neighbouring blocks can be merged
+	std::map<uint64_t, uint64_t> freeBlocks {};
+
+	uint64_t capacity {};
+	uint64_t freeSize {};
+
+
+public:
+	void init(uint64_t size);
+
+	// Best fit allocation, returns 1 if there is no free block large enough
+	[[nodiscard]] int allocate(uint64_t size, uint64_t& offset);
+	void free(uint64_t offset, uint64_t size);
+
+
+	inline uint64_t getCapacity() const {
+		return capacity;
+	}
+
+	inline uint64_t getFreeSize() const {
+		return freeSize;
+	}
+
+	inline uint64_t getFreeBlockCount() const {
+		return freeBlocks.size();
+	}
+};
+} // namespace Engine
\ No newline at end of file
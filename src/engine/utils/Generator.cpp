@@ -1,7 +1,16 @@
 #include "Generator.hpp"
 
+#include "engine/utils/ThreadPool.hpp"
+
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 
 namespace Engine {
 void Generator::skyBoxMesh(MeshManager::Handle& meshHandle) {
@@ -245,32 +254,137 @@ void Generator::normalMapFromHeight(TextureManager::Handle& heightTextureHandle,
 		auto& data = texture.getPixelData();
 		data.resize(width * height * 4);
 
-		for (int y = 0; y < height; y++) {
-			for (int x = 0; x < width; x++) {
-				// glm::ivec2 offsetX = { std::max(0, x - 1), std::min(width - 1, x + 1) };
-				// glm::ivec2 offsetY = { std::max(0, y - 1), std::min(height - 1, y + 1) };
+		normalsFromHeights(pHeightData, width, height, maxHeight, data.data(), std::thread::hardware_concurrency());
+	});
+	normalTextureHandle.update();
+}
 
-				glm::ivec2 offsetX = glm::clamp(glm::ivec2(x - 1, x + 1), 0, width - 1);
-				glm::ivec2 offsetY = glm::clamp(glm::ivec2(y - 1, y + 1), 0, height - 1);
+void Generator::normalsFromHeights(const uint16_t* pHeights, uint width, uint height, float heightScale,
+								   uint8_t* pNormals, uint threadCount) {
+	// Not worth waking threads up for small heightmaps
+	uint fragmentCount = std::clamp(height / 64, 1u, std::max(threadCount, 1u));
+	uint rowsPerThread = (height + fragmentCount - 1) / fragmentCount;
+
+	std::vector<NormalsThreadInfo> threadInfos(fragmentCount);
+
+	for (uint i = 0; i < fragmentCount; i++) {
+		threadInfos[i].pHeights	   = pHeights;
+		threadInfos[i].width	   = width;
+		threadInfos[i].height	   = height;
+		threadInfos[i].heightScale = heightScale;
+		threadInfos[i].pNormals	   = pNormals;
+		threadInfos[i].firstRow	   = std::min(i * rowsPerThread, height);
+		threadInfos[i].rowCount	   = std::min(rowsPerThread, height - threadInfos[i].firstRow);
+	}
 
-				float s01 = (pHeightData[y * width + offsetX.x] / 65535.0f) * maxHeight;
-				float s21 = (pHeightData[y * width + offsetX.y] / 65535.0f) * maxHeight;
-				float s10 = (pHeightData[offsetY.x * width + x] / 65535.0f) * maxHeight;
-				float s12 = (pHeightData[offsetY.y * width + x] / 65535.0f) * maxHeight;
+	if (fragmentCount == 1) {
+		normalsFromHeightsRows(threadInfos[0]);
+		return;
+	}
 
-				glm::vec3 tangent	= glm::normalize(glm::vec3(2.0, s21 - s01, 0.0));
-				glm::vec3 bitangent = glm::normalize(glm::vec3(0.0, s12 - s10, 2.0));
-				glm::vec3 normal	= glm::cross(bitangent, tangent);
+	ThreadPool threadPool {};
+	threadPool.init(
+		[](uint, void* pData) {
+			normalsFromHeightsRows(*static_cast<NormalsThreadInfo*>(pData));
+		},
+		fragmentCount);
 
-				uint index = (y * width + x) * 4;
+	for (auto& threadInfo : threadInfos) {
+		threadPool.appendData(&threadInfo);
+	}
 
-				data[index + 0] = std::clamp(static_cast<int>(255 * (normal.x * 0.5f + 0.5f)), 0, 255);
-				data[index + 1] = std::clamp(static_cast<int>(255 * (normal.y * 0.5f + 0.5f)), 0, 255);
-				data[index + 2] = std::clamp(static_cast<int>(255 * (normal.z * 0.5f + 0.5f)), 0, 255);
-				data[index + 3] = 255;
-			}
+	threadPool.waitForAll();
+}
+
+
+void Generator::normalsFromHeightsRows(const NormalsThreadInfo& threadInfo) {
+	const uint width  = threadInfo.width;
+	const uint height = threadInfo.height;
+
+	const float scale = threadInfo.heightScale / 65535.0f;
+
+	auto* pDstNormals = reinterpret_cast<uint32_t*>(threadInfo.pNormals);
+
+	for (uint y = threadInfo.firstRow; y < threadInfo.firstRow + threadInfo.rowCount; y++) {
+		// Border rows repeat themselves
+		const uint16_t* pRow	 = &threadInfo.pHeights[y * width];
+		const uint16_t* pRowUp	 = &threadInfo.pHeights[(y > 0 ? y - 1 : y) * width];
+		const uint16_t* pRowDown = &threadInfo.pHeights[std::min(y + 1, height - 1) * width];
+
+		uint32_t* pDstRow = &pDstNormals[y * width];
+
+		auto encodeScalar = [&](uint x) {
+			uint left  = x > 0 ? x - 1 : x;
+			uint right = std::min(x + 1, width - 1);
+
+			pDstRow[x] = encodeNormal((static_cast<float>(pRow[right]) - pRow[left]) * scale,
+									  (static_cast<float>(pRowDown[x]) - pRowUp[x]) * scale);
+		};
+
+		uint x = 0;
+
+		if (width > 1) {
+			encodeScalar(x++);
 		}
-	});
-	normalTextureHandle.update();
+
+#ifdef __SSE2__
+		// Interior texels 4 at a time, last column is left to scalar code as it has no right neighbour
+		const __m128 scaleVector = _mm_set1_ps(scale);
+		const __m128 half		 = _mm_set1_ps(0.5f);
+		const __m128 minusTwo	 = _mm_set1_ps(-2.0f);
+		const __m128 four		 = _mm_set1_ps(4.0f);
+		const __m128 byteScale	 = _mm_set1_ps(255.0f);
+		const __m128i alpha		 = _mm_set1_epi32(255);
+		const __m128i zero		 = _mm_setzero_si128();
+
+		auto load = [&zero](const uint16_t* pSrc) {
+			__m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc));
+			return _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, zero));
+		};
+
+		auto toByte = [&](__m128 value) {
+			return _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(value, half), half), byteScale));
+		};
+
+		for (; x + 4 < width; x += 4) {
+			__m128 differenceX = _mm_mul_ps(_mm_sub_ps(load(&pRow[x + 1]), load(&pRow[x - 1])), scaleVector);
+			__m128 differenceY = _mm_mul_ps(_mm_sub_ps(load(&pRowDown[x]), load(&pRowUp[x])), scaleVector);
+
+			// Cross product of normalized (2, dx, 0) and (0, dy, 2) is (-2 dx, 4, -2 dy) over product of their lengths
+			__m128 lengthX = _mm_add_ps(four, _mm_mul_ps(differenceX, differenceX));
+			__m128 lengthY = _mm_add_ps(four, _mm_mul_ps(differenceY, differenceY));
+			__m128 invNorm = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_mul_ps(lengthX, lengthY)));
+
+			__m128i normalX = toByte(_mm_mul_ps(_mm_mul_ps(differenceX, invNorm), minusTwo));
+			__m128i normalY = toByte(_mm_mul_ps(four, invNorm));
+			__m128i normalZ = toByte(_mm_mul_ps(_mm_mul_ps(differenceY, invNorm), minusTwo));
+
+			// Saturate into bytes ordered xxxx yyyy zzzz aaaa, then interleave into RGBA texels
+			__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(normalX, normalY), _mm_packs_epi32(normalZ, alpha));
+
+			__m128i xy = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 4));
+			__m128i zw = _mm_unpacklo_epi8(_mm_srli_si128(bytes, 8), _mm_srli_si128(bytes, 12));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&pDstRow[x]), _mm_unpacklo_epi16(xy, zw));
+		}
+#endif
+
+		for (; x < width; x++) {
+			encodeScalar(x);
+		}
+	}
+}
+
+uint32_t Generator::encodeNormal(float differenceX, float differenceY) {
+	// Cross product of normalized (2, dx, 0) and (0, dy, 2) is (-2 dx, 4, -2 dy) over product of their lengths
+	float invNorm = 1.0f / std::sqrt((4.0f + differenceX * differenceX) * (4.0f + differenceY * differenceY));
+
+	glm::vec3 normal = glm::vec3(-2.0f * differenceX, 4.0f, -2.0f * differenceY) * invNorm;
+
+	auto toByte = [](float value) {
+		return static_cast<uint32_t>(std::clamp(static_cast<int>(255 * (value * 0.5f + 0.5f)), 0, 255));
+	};
+
+	return toByte(normal.x) | (toByte(normal.y) << 8) | (toByte(normal.z) << 16) | (255u << 24);
 }
 } // namespace Engine
\ No newline at end of file
@@ -24,5 +24,28 @@ public:
 
 	static void normalMapFromHeight(TextureManager::Handle& textureHandle, TextureManager::Handle& normalTextureHandle,
 									uint maxHeight);
+
+	// Writes RGBA8 normals of 16 bit heightmap, height scale is world height of max value per texel size. Rows are
+	// distributed between threads.
+	static void normalsFromHeights(const uint16_t* pHeights, uint width, uint height, float heightScale,
+								   uint8_t* pNormals, uint threadCount = 1);
+
+private:
+	struct NormalsThreadInfo {
+		const uint16_t* pHeights;
+		uint width;
+		uint height;
+		float heightScale;
+
+		uint8_t* pNormals;
+
+		uint firstRow;
+		uint rowCount;
+	};
+
+	static void normalsFromHeightsRows(const NormalsThreadInfo& threadInfo);
+
+	// Height differences are in normalized units multiplied by height scale
+	static uint32_t encodeNormal(float differenceX, float differenceY);
 };
 }; // namespace Engine
\ No newline at end of file
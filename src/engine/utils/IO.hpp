@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -37,4 +38,20 @@ inline int readFile(std::string filename, std::vector<uint8_t>& buffer) {
 
 	return 0;
 }
+
+inline int writeFile(std::string filename, const void* pData, uint64_t size) {
+	std::ofstream file(filename, std::ios::trunc | std::ios::binary);
+
+	if (!file) {
+		return 1;
+	}
+
+	file.write(static_cast<const char*>(pData), size);
+
+	if (!file) {
+		return 1;
+	}
+
+	return 0;
+}
 } // namespace Engine
\ No newline at end of file
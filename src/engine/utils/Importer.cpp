@@ -1,20 +1,78 @@
 #include "Importer.hpp"
 
+#include "engine/graphics/CookedMeshFile.hpp"
+#include "engine/graphics/CookedTextureFile.hpp"
+#include "engine/graphics/HeightPyramid.hpp"
+#include "engine/graphics/TerrainTileFile.hpp"
+
+#include "engine/utils/Generator.hpp"
+#include "engine/utils/MappedFile.hpp"
+
 #include <spdlog/spdlog.h>
 
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
 #include "stb_image.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
 
 namespace Engine {
-Assimp::Importer Importer::assimpImporter {};
+int Importer::importMesh(std::string filename, std::vector<MeshManager::Handle>& meshHandles) {
+	std::vector<StaticMesh> meshes {};
+	std::vector<std::string> meshNames {};
 
+	if (loadMesh(filename, meshes, meshNames)) {
+		return 1;
+	}
 
-int Importer::importMesh(std::string filename, std::vector<MeshManager::Handle>& meshHandles) {
+	createMeshes(meshes, meshNames, meshHandles);
+
+	return 0;
+}
+
+void Importer::createMeshes(std::vector<StaticMesh>& meshes, const std::vector<std::string>& meshNames,
+							std::vector<MeshManager::Handle>& meshHandles, bool upload) {
+	meshHandles.resize(meshes.size());
+
+	for (uint i = 0; i < meshHandles.size(); i++) {
+		auto& meshHandle = meshHandles[i];
+		meshHandle		 = MeshManager::createObject(0, meshNames[i]);
+
+		meshHandle.apply<StaticMesh>([&](auto& mesh) {
+			mesh = std::move(meshes[i]);
+		});
+
+		if (upload) {
+			meshHandle.update();
+		}
+	}
+}
+
+int Importer::loadMesh(std::string filename, std::vector<StaticMesh>& meshes, std::vector<std::string>& meshNames) {
 	spdlog::info("Importing mesh '{}'...", filename);
 
+	// Importer owns the scene it reads, so each call uses its own one
+	Assimp::Importer assimpImporter {};
+
 	const aiScene* scene =
 		assimpImporter.ReadFile(filename, aiProcess_Triangulate | aiProcess_CalcTangentSpace |
 											  aiProcess_GenBoundingBoxes | aiProcess_MakeLeftHanded |
@@ -25,110 +83,1825 @@ int Importer::importMesh(std::string filename, std::vector<MeshManager::Handle>&
 		return 1;
 	}
 
-	meshHandles.resize(scene->mNumMeshes);
+	meshes.resize(scene->mNumMeshes);
+	meshNames.resize(scene->mNumMeshes);
 
-	for (uint i = 0; i < meshHandles.size(); i++) {
+	for (uint i = 0; i < meshes.size(); i++) {
 		auto assimpMesh = scene->mMeshes[i];
 
-		auto& meshHandle = meshHandles[i];
-		meshHandle		 = MeshManager::createObject(0, assimpMesh->mName.C_Str());
+		auto& mesh	 = meshes[i];
+		meshNames[i] = assimpMesh->mName.C_Str();
+
+		for (int i = 0; i < 8; i++) {
+			mesh.boundingBox.points[i].x = i & 1 ? assimpMesh->mAABB.mMax.x : assimpMesh->mAABB.mMin.x;
+			mesh.boundingBox.points[i].y = i & 2 ? assimpMesh->mAABB.mMax.y : assimpMesh->mAABB.mMin.y;
+			mesh.boundingBox.points[i].z = i & 4 ? assimpMesh->mAABB.mMax.z : assimpMesh->mAABB.mMin.z;
+		}
+		mesh.boundingSphere = { mesh.boundingBox };
+
+
+		auto& vertexBuffer = mesh.getVertexBuffer();
+		vertexBuffer.resize(assimpMesh->mNumVertices);
+
+		for (int vIndex = 0; vIndex < assimpMesh->mNumVertices; vIndex++) {
+			std::get<0>(vertexBuffer[vIndex]).x = assimpMesh->mVertices[vIndex].x;
+			std::get<0>(vertexBuffer[vIndex]).y = assimpMesh->mVertices[vIndex].y;
+			std::get<0>(vertexBuffer[vIndex]).z = assimpMesh->mVertices[vIndex].z;
+
+			if (assimpMesh->mTextureCoords[0] != nullptr) {
+				std::get<1>(vertexBuffer[vIndex]).x = assimpMesh->mTextureCoords[0][vIndex].x;
+				std::get<1>(vertexBuffer[vIndex]).y = assimpMesh->mTextureCoords[0][vIndex].y;
+			} else {
+				std::get<1>(vertexBuffer[vIndex]).x = 0.0f;
+				std::get<1>(vertexBuffer[vIndex]).y = 0.0f;
+			}
+
+			std::get<2>(vertexBuffer[vIndex]).x = assimpMesh->mNormals[vIndex].x;
+			std::get<2>(vertexBuffer[vIndex]).y = assimpMesh->mNormals[vIndex].y;
+			std::get<2>(vertexBuffer[vIndex]).z = assimpMesh->mNormals[vIndex].z;
+
+			std::get<3>(vertexBuffer[vIndex]).x = assimpMesh->mTangents[vIndex].x;
+			std::get<3>(vertexBuffer[vIndex]).y = assimpMesh->mTangents[vIndex].y;
+			std::get<3>(vertexBuffer[vIndex]).z = assimpMesh->mTangents[vIndex].z;
+
+			std::get<4>(vertexBuffer[vIndex]).x = -assimpMesh->mBitangents[vIndex].x;
+			std::get<4>(vertexBuffer[vIndex]).y = -assimpMesh->mBitangents[vIndex].y;
+			std::get<4>(vertexBuffer[vIndex]).z = -assimpMesh->mBitangents[vIndex].z;
+		}
+
+		auto& indexBuffer = mesh.getIndexBuffer();
+		indexBuffer.resize(assimpMesh->mNumFaces * 3);
+
+		for (int fIndex = 0; fIndex < assimpMesh->mNumFaces; fIndex++) {
+			indexBuffer[fIndex * 3 + 0] = assimpMesh->mFaces[fIndex].mIndices[0];
+			indexBuffer[fIndex * 3 + 1] = assimpMesh->mFaces[fIndex].mIndices[1];
+			indexBuffer[fIndex * 3 + 2] = assimpMesh->mFaces[fIndex].mIndices[2];
+		}
+
+		// Measured in imported order, meshlets reorder indices already
+		const auto statistics = analyzeVertexCache(indexBuffer, vertexBuffer.size());
+
+		buildMeshlets(mesh);
+		optimizeMesh(mesh, assimpMesh->mName.C_Str(), statistics);
+	}
+	return 0;
+}
+
+int Importer::generateMeshLods(const MeshManager::Handle& meshHandle, std::string name, uint lodCount,
+							   std::vector<MeshManager::Handle>& lodHandles, bool upload, float triangleRatio) {
+	assert(lodCount > 0);
+	assert(triangleRatio > 0.0f && triangleRatio < 1.0f);
+
+	if (MeshManager::getTypeIndex(meshHandle) != MeshManager::getTypeIndex<StaticMesh>()) {
+		spdlog::error("Failed to generate LODs for '{}': only static meshes are supported", name);
+		return 1;
+	}
+
+	// Copy source data, creating new meshes may reallocate mesh storage
+	StaticMesh srcMesh {};
+	MeshManager::apply<StaticMesh>(meshHandle, [&srcMesh](auto& mesh) {
+		srcMesh = mesh;
+	});
+
+	lodHandles.clear();
+	lodHandles.push_back(meshHandle);
+
+	for (uint lod = 1; lod < lodCount; lod++) {
+		const uint srcIndexCount	= srcMesh.getIndexBuffer().size();
+		const uint targetIndexCount = static_cast<uint>(srcIndexCount / 3 * triangleRatio) * 3;
+
+		StaticMesh dstMesh {};
+		simplifyMesh(srcMesh, dstMesh, targetIndexCount);
+
+		const auto statistics = analyzeVertexCache(dstMesh.getIndexBuffer(), dstMesh.getVertexBuffer().size());
+
+		buildMeshlets(dstMesh);
+
+		const uint dstIndexCount = dstMesh.getIndexBuffer().size();
+
+		if (dstIndexCount == 0 || dstIndexCount == srcIndexCount) {
+			spdlog::warn("Mesh '{}' can not be simplified beyond LOD {}", name, lod - 1);
+			break;
+		}
+
+		// Collapses run out when most of the mesh lies on seams, borders or would flip triangles
+		if (dstIndexCount > targetIndexCount) {
+			spdlog::warn("LOD {} of '{}' could not reach requested ratio: {} triangles ({} requested)", lod, name,
+						 dstIndexCount / 3, targetIndexCount / 3);
+		} else {
+			spdlog::info("Generated LOD {} of '{}' with {} triangles ({} requested)", lod, name, dstIndexCount / 3,
+						 targetIndexCount / 3);
+		}
+
+		const std::string lodName = name + "_lod_" + std::to_string(lod);
+
+		optimizeMesh(dstMesh, lodName, statistics);
+
+		// Simplified mesh uses a subset of source vertices, source bounds remain valid
+		dstMesh.boundingBox	   = srcMesh.boundingBox;
+		dstMesh.boundingSphere = srcMesh.boundingSphere;
+
+		auto lodHandle = MeshManager::createObject<StaticMesh>(lodName);
+		lodHandle.apply<StaticMesh>([&dstMesh](auto& mesh) {
+			mesh = dstMesh;
+		});
+		if (upload) {
+			lodHandle.update();
+		}
+
+		lodHandles.push_back(lodHandle);
+
+		srcMesh = std::move(dstMesh);
+	}
+
+	return 0;
+}
+
+int Importer::compressMesh(const MeshManager::Handle& meshHandle, std::string name,
+						   MeshManager::Handle& compressedMeshHandle) {
+	if (MeshManager::getTypeIndex(meshHandle) != MeshManager::getTypeIndex<StaticMesh>()) {
+		spdlog::error("Failed to compress '{}': only static meshes are supported", name);
+		return 1;
+	}
+
+	CompressedStaticMesh dstMesh {};
+
+	MeshManager::apply<StaticMesh>(meshHandle, [&dstMesh](auto& srcMesh) {
+		const auto& srcVertexBuffer = srcMesh.getVertexBuffer();
+
+		glm::vec3 minPosition { FLT_MAX };
+		glm::vec3 maxPosition { -FLT_MAX };
+
+		for (const auto& vertex : srcVertexBuffer) {
+			minPosition = glm::min(minPosition, std::get<0>(vertex));
+			maxPosition = glm::max(maxPosition, std::get<0>(vertex));
+		}
+
+		// Uniform scale keeps quantization error isotropic and dequantization to a single vec4
+		const glm::vec3 extent = maxPosition - minPosition;
+		float scale			   = std::max(std::max(extent.x, extent.y), extent.z);
+		if (scale <= 0.0f) {
+			scale = 1.0f;
+		}
+
+		auto& dstVertexBuffer = dstMesh.getVertexBuffer();
+		dstVertexBuffer.resize(srcVertexBuffer.size());
+
+		for (uint vIndex = 0; vIndex < srcVertexBuffer.size(); vIndex++) {
+			const auto& [position, texCoord, normal, tangent, bitangent] = srcVertexBuffer[vIndex];
+
+			const glm::vec3 normalizedPosition = glm::clamp((position - minPosition) / scale, 0.0f, 1.0f);
+			const bool isRightHanded		   = glm::dot(glm::cross(normal, tangent), bitangent) >= 0.0f;
+
+			std::get<0>(dstVertexBuffer[vIndex]) =
+				glm::u16vec4(glm::round(normalizedPosition * 65535.0f), isRightHanded ? 65535 : 0);
+
+			std::get<1>(dstVertexBuffer[vIndex]) =
+				glm::u16vec2(glm::packHalf1x16(texCoord.x), glm::packHalf1x16(texCoord.y));
+
+			std::get<2>(dstVertexBuffer[vIndex]) = encodeOctahedral(normal);
+			std::get<3>(dstVertexBuffer[vIndex]) = encodeOctahedral(tangent);
+		}
+
+		dstMesh.getIndexBuffer() = srcMesh.getIndexBuffer();
+
+		dstMesh.boundingBox	   = srcMesh.boundingBox;
+		dstMesh.boundingSphere = srcMesh.boundingSphere;
+		dstMesh.meshlets	   = srcMesh.meshlets;
+
+		dstMesh.positionDequantization = glm::vec4(minPosition, scale);
+	});
+
+	spdlog::info("Compressed '{}' vertex data from {} to {} bytes", name,
+				 StaticMesh::getVertexSize() * dstMesh.getVertexBuffer().size(), dstMesh.getVertexBufferSize());
+
+	compressedMeshHandle = MeshManager::createObject<CompressedStaticMesh>(name);
+	compressedMeshHandle.apply<CompressedStaticMesh>([&dstMesh](auto& mesh) {
+		mesh = std::move(dstMesh);
+	});
+	compressedMeshHandle.update();
+
+	return 0;
+}
+
+glm::i16vec2 Importer::encodeOctahedral(glm::vec3 direction) {
+	const float norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+	if (norm == 0.0f) {
+		return {};
+	}
+
+	direction /= norm;
+
+	glm::vec2 encoded = glm::vec2(direction);
+	if (direction.z < 0.0f) {
+		encoded.x = (1.0f - std::abs(direction.y)) * (direction.x >= 0.0f ? 1.0f : -1.0f);
+		encoded.y = (1.0f - std::abs(direction.x)) * (direction.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return glm::i16vec2(glm::round(glm::clamp(encoded, -1.0f, 1.0f) * 32767.0f));
+}
+
+void Importer::simplifyMesh(const StaticMesh& srcMesh, StaticMesh& dstMesh, uint targetIndexCount) {
+	// Quadric is stored as upper triangle of a symmetric 4x4 matrix
+	using Quadric = std::array<double, 10>;
+
+	struct Collapse {
+		double error;
+
+		uint32_t srcPosition;
+		uint32_t dstPosition;
+
+		// Source quadric version collapse was evaluated with
+		uint32_t version;
+	};
+
+	const auto& srcVertices = srcMesh.vertexBuffer;
+	const auto& srcIndices	= srcMesh.indexBuffer;
+
+	const uint triangleCount = srcIndices.size() / 3;
+
+
+	// Vertices split on attribute seams share a position, topology is tracked on positions
+	std::vector<uint32_t> vertexPositions(srcVertices.size());
+	std::vector<glm::vec3> positions {};
+	std::vector<std::vector<uint32_t>> positionVertices {};
+
+	std::map<std::array<float, 3>, uint32_t> positionMap {};
+
+	for (uint vertex = 0; vertex < srcVertices.size(); vertex++) {
+		const auto& position = std::get<0>(srcVertices[vertex]);
+
+		auto [iter, isInserted] = positionMap.try_emplace({ position.x, position.y, position.z }, positions.size());
+
+		if (isInserted) {
+			positions.push_back(position);
+			positionVertices.push_back({});
+		}
+
+		vertexPositions[vertex] = iter->second;
+		positionVertices[iter->second].push_back(vertex);
+	}
+
+	const uint positionCount = positions.size();
+
+
+	std::vector<std::array<uint32_t, 3>> triangles(triangleCount);
+	std::vector<bool> triangleAlive(triangleCount, true);
+
+	std::vector<std::vector<uint32_t>> positionTriangles(positionCount);
+
+	std::vector<Quadric> quadrics(positionCount);
+
+	auto addPlaneQuadric = [&](uint32_t position, const glm::vec3& normal, const glm::vec3& point, double weight) {
+		const double a = normal.x;
+		const double b = normal.y;
+		const double c = normal.z;
+		const double d = -glm::dot(normal, point);
+
+		const Quadric planeQuadric = { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+
+		for (uint i = 0; i < 10; i++) {
+			quadrics[position][i] += planeQuadric[i] * weight;
+		}
+	};
+
+	auto getTriangleNormal = [&](uint32_t triangle) {
+		const auto& p0 = positions[vertexPositions[triangles[triangle][0]]];
+		const auto& p1 = positions[vertexPositions[triangles[triangle][1]]];
+		const auto& p2 = positions[vertexPositions[triangles[triangle][2]]];
+
+		return glm::cross(p1 - p0, p2 - p0);
+	};
+
+	struct EdgeInfo {
+		// Edges used once are mesh borders
+		uint32_t triangleCount;
+
+		// First triangle using the edge and its vertices at lower and higher edge position
+		uint32_t triangle;
+		uint32_t firstVertex;
+		uint32_t secondVertex;
+
+		// Vertex attributes differ between triangles sharing the edge
+		bool isSeam;
+	};
+
+	std::map<std::pair<uint32_t, uint32_t>, EdgeInfo> edgeInfos {};
+
+	for (uint triangle = 0; triangle < triangleCount; triangle++) {
+		std::array<uint32_t, 3> trianglePositions {};
+
+		for (uint corner = 0; corner < 3; corner++) {
+			triangles[triangle][corner] = srcIndices[triangle * 3 + corner];
+			trianglePositions[corner]	= vertexPositions[triangles[triangle][corner]];
+
+			positionTriangles[trianglePositions[corner]].push_back(triangle);
+		}
+
+		for (uint corner = 0; corner < 3; corner++) {
+			uint32_t firstVertex  = triangles[triangle][corner];
+			uint32_t secondVertex = triangles[triangle][(corner + 1) % 3];
 
-		meshHandle.apply<StaticMesh>([&assimpMesh](auto& mesh) {
-			for (int i = 0; i < 8; i++) {
-				mesh.boundingBox.points[i].x = i & 1 ? assimpMesh->mAABB.mMax.x : assimpMesh->mAABB.mMin.x;
-				mesh.boundingBox.points[i].y = i & 2 ? assimpMesh->mAABB.mMax.y : assimpMesh->mAABB.mMin.y;
-				mesh.boundingBox.points[i].z = i & 4 ? assimpMesh->mAABB.mMax.z : assimpMesh->mAABB.mMin.z;
+			if (vertexPositions[firstVertex] == vertexPositions[secondVertex]) {
+				continue;
 			}
-			mesh.boundingSphere = { mesh.boundingBox };
+			if (vertexPositions[firstVertex] > vertexPositions[secondVertex]) {
+				std::swap(firstVertex, secondVertex);
+			}
+
+			auto [iter, isInserted] =
+				edgeInfos.try_emplace({ vertexPositions[firstVertex], vertexPositions[secondVertex] },
+									  EdgeInfo { 0, triangle, firstVertex, secondVertex, false });
+
+			auto& edgeInfo = iter->second;
+			edgeInfo.triangleCount++;
+			edgeInfo.isSeam |= srcVertices[firstVertex] != srcVertices[edgeInfo.firstVertex] ||
+							   srcVertices[secondVertex] != srcVertices[edgeInfo.secondVertex];
+		}
+
+		auto normal		  = getTriangleNormal(triangle);
+		const float area2 = glm::length(normal);
+
+		if (area2 == 0.0f) {
+			continue;
+		}
+
+		// Plane quadric weighted by triangle area
+		for (auto position : trianglePositions) {
+			addPlaneQuadric(position, normal / area2, positions[trianglePositions[0]], area2 * 0.5);
+		}
+	}
+
+	// Seam and border edges form chains, a position on them may only slide along its chain. Positions where chains
+	// end or meet never move. Chain edges add quadrics of planes perpendicular to their triangle, so sliding along a
+	// curved chain is penalized and UV seams, hard edges and open borders keep their shape.
+	constexpr double featureEdgeWeight = 10.0;
+
+	std::vector<std::vector<uint32_t>> featureNeighbours(positionCount);
+
+	for (const auto& [edge, edgeInfo] : edgeInfos) {
+		if (edgeInfo.triangleCount == 2 && !edgeInfo.isSeam) {
+			continue;
+		}
+
+		featureNeighbours[edge.first].push_back(edge.second);
+		featureNeighbours[edge.second].push_back(edge.first);
+
+		const auto edgeVector = positions[edge.second] - positions[edge.first];
+		const auto normal	  = glm::cross(edgeVector, getTriangleNormal(edgeInfo.triangle));
+		const float length	  = glm::length(normal);
+
+		if (length == 0.0f) {
+			continue;
+		}
+
+		const double weight = glm::dot(edgeVector, edgeVector) * featureEdgeWeight;
+
+		addPlaneQuadric(edge.first, normal / length, positions[edge.first], weight);
+		addPlaneQuadric(edge.second, normal / length, positions[edge.first], weight);
+	}
+
+	auto canCollapse = [&](uint32_t srcPosition, uint32_t dstPosition) {
+		const auto& neighbours = featureNeighbours[srcPosition];
+
+		return neighbours.empty() ||
+			   (neighbours.size() == 2 && (neighbours[0] == dstPosition || neighbours[1] == dstPosition));
+	};
+
+
+	auto evaluateQuadric = [](const Quadric& q, const glm::vec3& p) {
+		const double x = p.x;
+		const double y = p.y;
+		const double z = p.z;
+
+		return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x + q[4] * y * y +
+			   2.0 * q[5] * y * z + 2.0 * q[6] * y + q[7] * z * z + 2.0 * q[8] * z + q[9];
+	};
+
+	auto compareCollapses = [](const Collapse& a, const Collapse& b) {
+		return a.error > b.error;
+	};
+
+	std::priority_queue<Collapse, std::vector<Collapse>, decltype(compareCollapses)> collapses(compareCollapses);
+
+	std::vector<bool> positionCollapsed(positionCount);
+	std::vector<uint32_t> positionVersions(positionCount);
+
+	auto pushCollapse = [&](uint32_t srcPosition, uint32_t dstPosition) {
+		if (srcPosition == dstPosition || !canCollapse(srcPosition, dstPosition)) {
+			return;
+		}
+
+		const double error = evaluateQuadric(quadrics[srcPosition], positions[dstPosition]);
+		collapses.push({ error, srcPosition, dstPosition, positionVersions[srcPosition] });
+	};
+
+	for (const auto& [edge, edgeInfo] : edgeInfos) {
+		pushCollapse(edge.first, edge.second);
+		pushCollapse(edge.second, edge.first);
+	}
+
+
+	auto getTrianglePosition = [&](uint32_t triangle, uint corner) {
+		return vertexPositions[triangles[triangle][corner]];
+	};
+
+	uint indexCount = triangleCount * 3;
+
+	while (indexCount > targetIndexCount && !collapses.empty()) {
+		const auto collapse = collapses.top();
+		collapses.pop();
+
+		const uint32_t srcPosition = collapse.srcPosition;
+		const uint32_t dstPosition = collapse.dstPosition;
+
+		if (positionCollapsed[srcPosition] || positionCollapsed[dstPosition] ||
+			positionVersions[srcPosition] != collapse.version || !canCollapse(srcPosition, dstPosition)) {
+			continue;
+		}
+
+		// Reject collapses along edges that no longer exist or that would flip a remaining triangle
+		bool isEdge		= false;
+		bool isFlipping = false;
+
+		for (auto triangle : positionTriangles[srcPosition]) {
+			if (!triangleAlive[triangle]) {
+				continue;
+			}
+
+			std::array<glm::vec3, 3> before {};
+			std::array<glm::vec3, 3> after {};
+
+			bool hasDst = false;
+
+			for (uint corner = 0; corner < 3; corner++) {
+				const uint32_t position = getTrianglePosition(triangle, corner);
+
+				hasDst |= position == dstPosition;
+
+				before[corner] = positions[position];
+				after[corner]  = positions[position == srcPosition ? dstPosition : position];
+			}
+
+			if (hasDst) {
+				isEdge = true;
+				continue;
+			}
+
+			const auto normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			const auto normalAfter	= glm::cross(after[1] - after[0], after[2] - after[0]);
+
+			if (glm::dot(normalBefore, normalAfter) <= 0.0f) {
+				isFlipping = true;
+				break;
+			}
+		}
+
+		if (!isEdge || isFlipping) {
+			continue;
+		}
+
+
+		// Source on a chain keeps attributes of each side of it, its vertices are replaced by the ones collapsed edge
+		// has at destination on the same side
+		const bool isFeature = !featureNeighbours[srcPosition].empty();
+
+		std::vector<std::pair<uint32_t, uint32_t>> vertexRemaps {};
+
+		// Split vertices with equal attributes are on the same side
+		auto findRemap = [&](uint32_t vertex) {
+			return std::find_if(vertexRemaps.begin(), vertexRemaps.end(), [&](const auto& remap) {
+				return srcVertices[remap.first] == srcVertices[vertex];
+			});
+		};
+
+		if (isFeature) {
+			for (auto triangle : positionTriangles[srcPosition]) {
+				if (!triangleAlive[triangle]) {
+					continue;
+				}
+
+				uint32_t srcVertex = UINT32_MAX;
+				uint32_t dstVertex = UINT32_MAX;
+
+				for (auto vertex : triangles[triangle]) {
+					if (vertexPositions[vertex] == srcPosition) {
+						srcVertex = vertex;
+					} else if (vertexPositions[vertex] == dstPosition) {
+						dstVertex = vertex;
+					}
+				}
+
+				if (dstVertex != UINT32_MAX && findRemap(srcVertex) == vertexRemaps.end()) {
+					vertexRemaps.push_back({ srcVertex, dstVertex });
+				}
+			}
+
+			// Side of the chain without a triangle on collapsed edge can not be remapped
+			bool isRemapped = true;
+
+			for (auto triangle : positionTriangles[srcPosition]) {
+				for (auto vertex : triangles[triangle]) {
+					if (triangleAlive[triangle] && vertexPositions[vertex] == srcPosition) {
+						isRemapped &= findRemap(vertex) != vertexRemaps.end();
+					}
+				}
+			}
+
+			if (!isRemapped) {
+				continue;
+			}
+		}
 
+		// Source off chains has a single set of attributes, destination vertex with the closest texture coordinates
+		// replaces it
+		uint32_t dstVertex = positionVertices[dstPosition][0];
 
-			auto& vertexBuffer = mesh.getVertexBuffer();
-			vertexBuffer.resize(assimpMesh->mNumVertices);
+		if (!isFeature) {
+			const auto& srcUv = std::get<1>(srcVertices[positionVertices[srcPosition][0]]);
+			float minDistance = FLT_MAX;
 
-			for (int vIndex = 0; vIndex < assimpMesh->mNumVertices; vIndex++) {
-				std::get<0>(vertexBuffer[vIndex]).x = assimpMesh->mVertices[vIndex].x;
-				std::get<0>(vertexBuffer[vIndex]).y = assimpMesh->mVertices[vIndex].y;
-				std::get<0>(vertexBuffer[vIndex]).z = assimpMesh->mVertices[vIndex].z;
+			for (auto vertex : positionVertices[dstPosition]) {
+				const auto uvDelta	 = std::get<1>(srcVertices[vertex]) - srcUv;
+				const float distance = glm::dot(uvDelta, uvDelta);
 
-				if (assimpMesh->mTextureCoords[0] != nullptr) {
-					std::get<1>(vertexBuffer[vIndex]).x = assimpMesh->mTextureCoords[0][vIndex].x;
-					std::get<1>(vertexBuffer[vIndex]).y = assimpMesh->mTextureCoords[0][vIndex].y;
-				} else {
-					std::get<1>(vertexBuffer[vIndex]).x = 0.0f;
-					std::get<1>(vertexBuffer[vIndex]).y = 0.0f;
+				if (distance < minDistance) {
+					minDistance = distance;
+					dstVertex	= vertex;
 				}
+			}
+		}
 
-				std::get<2>(vertexBuffer[vIndex]).x = assimpMesh->mNormals[vIndex].x;
-				std::get<2>(vertexBuffer[vIndex]).y = assimpMesh->mNormals[vIndex].y;
-				std::get<2>(vertexBuffer[vIndex]).z = assimpMesh->mNormals[vIndex].z;
+		for (auto triangle : positionTriangles[srcPosition]) {
+			if (!triangleAlive[triangle]) {
+				continue;
+			}
+
+			bool hasDst = false;
+
+			for (uint corner = 0; corner < 3; corner++) {
+				hasDst |= getTrianglePosition(triangle, corner) == dstPosition;
+			}
 
-				std::get<3>(vertexBuffer[vIndex]).x = assimpMesh->mTangents[vIndex].x;
-				std::get<3>(vertexBuffer[vIndex]).y = assimpMesh->mTangents[vIndex].y;
-				std::get<3>(vertexBuffer[vIndex]).z = assimpMesh->mTangents[vIndex].z;
+			if (hasDst) {
+				triangleAlive[triangle] = false;
+				indexCount -= 3;
+				continue;
+			}
 
-				std::get<4>(vertexBuffer[vIndex]).x = -assimpMesh->mBitangents[vIndex].x;
-				std::get<4>(vertexBuffer[vIndex]).y = -assimpMesh->mBitangents[vIndex].y;
-				std::get<4>(vertexBuffer[vIndex]).z = -assimpMesh->mBitangents[vIndex].z;
+			for (auto& vertex : triangles[triangle]) {
+				if (vertexPositions[vertex] == srcPosition) {
+					vertex = isFeature ? findRemap(vertex)->second : dstVertex;
+				}
 			}
 
-			auto& indexBuffer = mesh.getIndexBuffer();
-			indexBuffer.resize(assimpMesh->mNumFaces * 3);
+			positionTriangles[dstPosition].push_back(triangle);
+		}
+
+		positionTriangles[srcPosition].clear();
+		positionCollapsed[srcPosition] = true;
+
+		// Chain continues from destination to the other neighbour of source
+		if (isFeature) {
+			auto& srcNeighbours = featureNeighbours[srcPosition];
+			auto& dstNeighbours = featureNeighbours[dstPosition];
 
-			for (int fIndex = 0; fIndex < assimpMesh->mNumFaces; fIndex++) {
-				indexBuffer[fIndex * 3 + 0] = assimpMesh->mFaces[fIndex].mIndices[0];
-				indexBuffer[fIndex * 3 + 1] = assimpMesh->mFaces[fIndex].mIndices[1];
-				indexBuffer[fIndex * 3 + 2] = assimpMesh->mFaces[fIndex].mIndices[2];
+			const uint32_t otherPosition = srcNeighbours[0] == dstPosition ? srcNeighbours[1] : srcNeighbours[0];
+			auto& otherNeighbours		 = featureNeighbours[otherPosition];
+
+			std::erase(dstNeighbours, srcPosition);
+			std::erase(otherNeighbours, srcPosition);
+
+			if (std::find(dstNeighbours.begin(), dstNeighbours.end(), otherPosition) == dstNeighbours.end()) {
+				dstNeighbours.push_back(otherPosition);
+				otherNeighbours.push_back(dstPosition);
 			}
+
+			srcNeighbours.clear();
+		}
+
+		for (uint i = 0; i < 10; i++) {
+			quadrics[dstPosition][i] += quadrics[srcPosition][i];
+		}
+		positionVersions[dstPosition]++;
+
+		// Errors of all edges around destination changed
+		std::erase_if(positionTriangles[dstPosition], [&](auto triangle) {
+			return !triangleAlive[triangle];
 		});
 
-		meshHandle.update();
+		for (auto triangle : positionTriangles[dstPosition]) {
+			for (uint corner = 0; corner < 3; corner++) {
+				const uint32_t position = getTrianglePosition(triangle, corner);
+
+				pushCollapse(dstPosition, position);
+				pushCollapse(position, dstPosition);
+			}
+		}
 	}
-	return 0;
-}
 
-int Importer::importTexture(std::string filename, TextureManager::Handle& textureHandle, uint channels,
-							uint channelWidth, vk::Format format) {
-	spdlog::info("Importing texture '{}'...", filename);
-	int readWidth;
-	int readHeight;
-	int readChannels;
 
-	void* image;
+	// Compact remaining triangles and vertices they reference
+	std::vector<uint32_t> vertexRemap(srcVertices.size(), UINT32_MAX);
 
-	switch (channelWidth) {
-	case 8:
-		image = stbi_load(filename.c_str(), &readWidth, &readHeight, &readChannels, channels);
-		break;
+	auto& dstVertices = dstMesh.vertexBuffer;
+	auto& dstIndices  = dstMesh.indexBuffer;
 
-	case 16:
-		image = stbi_load_16(filename.c_str(), &readWidth, &readHeight, &readChannels, channels);
-		break;
+	dstVertices.clear();
+	dstIndices.clear();
+	dstIndices.reserve(indexCount);
 
-	default:
-		spdlog::error("{} bit channel width is not supported", channelWidth);
-		return 1;
-		break;
+	for (uint triangle = 0; triangle < triangleCount; triangle++) {
+		if (!triangleAlive[triangle]) {
+			continue;
+		}
+
+		for (auto vertex : triangles[triangle]) {
+			if (vertexRemap[vertex] == UINT32_MAX) {
+				vertexRemap[vertex] = dstVertices.size();
+				dstVertices.push_back(srcVertices[vertex]);
+			}
+
+			dstIndices.push_back(vertexRemap[vertex]);
+		}
 	}
+}
 
-	if (image == nullptr) {
-		spdlog::error("Failed to import '{}'", filename);
-		return 1;
+void Importer::buildMeshlets(StaticMesh& mesh) {
+	const auto& vertices = mesh.vertexBuffer;
+	auto& indices		 = mesh.indexBuffer;
+
+	const uint triangleCount = indices.size() / 3;
+
+	// Triangles using each vertex, meshlets are grown over connected surface
+	std::vector<std::vector<uint32_t>> vertexTriangles(vertices.size());
+
+	for (uint triangle = 0; triangle < triangleCount; triangle++) {
+		for (uint corner = 0; corner < 3; corner++) {
+			vertexTriangles[indices[triangle * 3 + corner]].push_back(triangle);
+		}
 	}
 
-	textureHandle.apply([&](auto& texture) {
-		texture.size = vk::Extent3D(readWidth, readHeight, 1);
+	std::vector<bool> triangleUsed(triangleCount);
 
-		texture.setPixelData(image, readWidth * readHeight * channels * (channelWidth / 8));
+	// Last meshlet vertex was added to
+	std::vector<uint32_t> vertexMeshlets(vertices.size(), UINT32_MAX);
 
-		texture.format		= format;
-		texture.usage		= vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
-		texture.imageAspect = vk::ImageAspectFlagBits::eColor;
+	std::vector<uint32_t> meshletIndices {};
+	meshletIndices.reserve(indices.size());
 
-		texture.useMipMapping = true;
-	});
-	textureHandle.update();
+	std::vector<uint32_t> meshletVertices {};
+	std::vector<uint32_t> meshletTriangles {};
 
-	stbi_image_free(image);
+	mesh.meshlets.clear();
+
+	uint seedTriangle = 0;
+
+	while (true) {
+		while (seedTriangle < triangleCount && triangleUsed[seedTriangle]) {
+			seedTriangle++;
+		}
+
+		if (seedTriangle == triangleCount) {
+			break;
+		}
+
+		const uint32_t meshletIndex = mesh.meshlets.size();
+
+		meshletVertices.clear();
+		meshletTriangles.clear();
+
+		uint32_t triangle = seedTriangle;
+
+		while (triangle != UINT32_MAX) {
+			triangleUsed[triangle] = true;
+			meshletTriangles.push_back(triangle);
+
+			for (uint corner = 0; corner < 3; corner++) {
+				const uint32_t vertex = indices[triangle * 3 + corner];
+
+				if (vertexMeshlets[vertex] != meshletIndex) {
+					vertexMeshlets[vertex] = meshletIndex;
+					meshletVertices.push_back(vertex);
+				}
+			}
+
+			if (meshletTriangles.size() == MAX_MESHLET_TRIANGLE_COUNT) {
+				break;
+			}
+
+			// Continue with an adjacent triangle adding the fewest new vertices
+			triangle = UINT32_MAX;
+
+			uint minNewVertexCount = 3;
+
+			for (auto vertex : meshletVertices) {
+				for (auto candidate : vertexTriangles[vertex]) {
+					if (triangleUsed[candidate]) {
+						continue;
+					}
+
+					uint newVertexCount = 0;
+					for (uint corner = 0; corner < 3; corner++) {
+						newVertexCount += vertexMeshlets[indices[candidate * 3 + corner]] != meshletIndex;
+					}
+
+					if (newVertexCount < minNewVertexCount &&
+						meshletVertices.size() + newVertexCount <= MAX_MESHLET_VERTEX_COUNT) {
+						minNewVertexCount = newVertexCount;
+						triangle		  = candidate;
+					}
+				}
+			}
+		}
+
+
+		Meshlet meshlet {};
+		meshlet.firstIndex = meshletIndices.size();
+		meshlet.indexCount = meshletTriangles.size() * 3;
+
+		glm::vec3 minPosition { FLT_MAX };
+		glm::vec3 maxPosition { -FLT_MAX };
+
+		for (auto vertex : meshletVertices) {
+			minPosition = glm::min(minPosition, std::get<0>(vertices[vertex]));
+			maxPosition = glm::max(maxPosition, std::get<0>(vertices[vertex]));
+		}
+
+		BoundingBox boundingBox {};
+		for (int i = 0; i < 8; i++) {
+			boundingBox.points[i].x = i & 1 ? maxPosition.x : minPosition.x;
+			boundingBox.points[i].y = i & 2 ? maxPosition.y : minPosition.y;
+			boundingBox.points[i].z = i & 4 ? maxPosition.z : minPosition.z;
+		}
+		meshlet.boundingSphere = { boundingBox };
+
+
+		// Normal cone axis is an area weighted average normal, cutoff is sine of cone half angle
+		std::vector<glm::vec3> normals(meshletTriangles.size());
+		glm::vec3 normalSum {};
+
+		for (uint i = 0; i < meshletTriangles.size(); i++) {
+			const uint32_t firstIndex = meshletTriangles[i] * 3;
+
+			const auto& p0 = std::get<0>(vertices[indices[firstIndex + 0]]);
+			const auto& p1 = std::get<0>(vertices[indices[firstIndex + 1]]);
+			const auto& p2 = std::get<0>(vertices[indices[firstIndex + 2]]);
+
+			// Face normals follow vertex normals, independent of winding order convention
+			const auto vertexNormalSum = std::get<2>(vertices[indices[firstIndex + 0]]) +
+										 std::get<2>(vertices[indices[firstIndex + 1]]) +
+										 std::get<2>(vertices[indices[firstIndex + 2]]);
+
+			normals[i] = glm::cross(p1 - p0, p2 - p0);
+			if (glm::dot(normals[i], vertexNormalSum) < 0.0f) {
+				normals[i] = -normals[i];
+			}
+			normalSum += normals[i];
+
+			meshletIndices.push_back(indices[firstIndex + 0]);
+			meshletIndices.push_back(indices[firstIndex + 1]);
+			meshletIndices.push_back(indices[firstIndex + 2]);
+		}
+
+		if (glm::length(normalSum) > 0.0f) {
+			meshlet.coneAxis = glm::normalize(normalSum);
+
+			float minDot = 1.0f;
+
+			for (const auto& normal : normals) {
+				const float length = glm::length(normal);
+
+				if (length > 0.0f) {
+					minDot = std::min(minDot, glm::dot(meshlet.coneAxis, normal / length));
+				}
+			}
+
+			if (minDot > 0.0f) {
+				meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+			}
+		}
+
+		mesh.meshlets.push_back(meshlet);
+	}
+
+	indices = std::move(meshletIndices);
+}
+
+void Importer::optimizeMesh(StaticMesh& mesh, const std::string& name,
+							const VertexCacheStatistics& statisticsBefore) {
+	if (mesh.meshlets.empty()) {
+		optimizeVertexCache(mesh.indexBuffer, 0, mesh.indexBuffer.size());
+	} else {
+		for (const auto& meshlet : mesh.meshlets) {
+			optimizeVertexCache(mesh.indexBuffer, meshlet.firstIndex, meshlet.indexCount);
+		}
+
+		optimizeOverdraw(mesh);
+	}
+
+	optimizeVertexFetch(mesh);
+
+	const auto statisticsAfter = analyzeVertexCache(mesh.indexBuffer, mesh.vertexBuffer.size());
+
+	spdlog::info("Optimized '{}' for vertex cache: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", name,
+				 statisticsBefore.averageCacheMissRatio, statisticsAfter.averageCacheMissRatio,
+				 statisticsBefore.averageTransformToVertexRatio, statisticsAfter.averageTransformToVertexRatio);
+}
+
+void Importer::optimizeVertexCache(std::vector<uint32_t>& indices, uint firstIndex, uint indexCount) {
+	const uint triangleCount = indexCount / 3;
+
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Range local vertex numbering keeps state proportional to range size
+	std::unordered_map<uint32_t, uint32_t> localVertices {};
+	std::vector<uint32_t> globalVertices {};
+	std::vector<uint32_t> localIndices(triangleCount * 3);
+
+	for (uint i = 0; i < localIndices.size(); i++) {
+		const auto [iter, isInserted] = localVertices.try_emplace(indices[firstIndex + i], globalVertices.size());
+		if (isInserted) {
+			globalVertices.push_back(indices[firstIndex + i]);
+		}
+
+		localIndices[i] = iter->second;
+	}
+
+	const uint vertexCount = globalVertices.size();
+
+
+	// Triangles using each vertex, adjacency lists are stored contiguously
+	std::vector<uint32_t> liveTriangleCounts(vertexCount);
+	for (auto vertex : localIndices) {
+		liveTriangleCounts[vertex]++;
+	}
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	for (uint vertex = 0; vertex < vertexCount; vertex++) {
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangleCounts[vertex];
+	}
+
+	std::vector<uint32_t> adjacency(localIndices.size());
+	std::vector<uint32_t> adjacencyCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+	for (uint i = 0; i < localIndices.size(); i++) {
+		adjacency[adjacencyCursors[localIndices[i]]++] = i / 3;
+	}
+
+
+	// Vertex is in cache if it was last transformed less than cache size transforms ago
+	std::vector<uint32_t> cacheTimestamps(vertexCount);
+	uint32_t timestamp = VERTEX_CACHE_SIZE + 1;
+
+	std::vector<bool> isTriangleEmitted(triangleCount);
+
+	std::vector<uint32_t> deadEndStack {};
+	std::vector<uint32_t> candidates {};
+
+	std::vector<uint32_t> optimizedIndices {};
+	optimizedIndices.reserve(localIndices.size());
+
+	uint32_t fanningVertex = 0;
+	uint scanCursor		   = 0;
+
+	while (fanningVertex != UINT32_MAX) {
+		candidates.clear();
+
+		// Emit all remaining triangles around fanning vertex
+		for (uint i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1]; i++) {
+			const uint32_t triangle = adjacency[i];
+
+			if (isTriangleEmitted[triangle]) {
+				continue;
+			}
+			isTriangleEmitted[triangle] = true;
+
+			for (uint corner = 0; corner < 3; corner++) {
+				const uint32_t vertex = localIndices[triangle * 3 + corner];
+
+				optimizedIndices.push_back(vertex);
+				deadEndStack.push_back(vertex);
+				candidates.push_back(vertex);
+
+				liveTriangleCounts[vertex]--;
+
+				if (timestamp - cacheTimestamps[vertex] > VERTEX_CACHE_SIZE) {
+					cacheTimestamps[vertex] = timestamp++;
+				}
+			}
+		}
+
+		// Next fanning vertex is the oldest candidate that stays in cache while its triangles are emitted
+		fanningVertex = UINT32_MAX;
+
+		int maxPriority = -1;
+
+		for (auto vertex : candidates) {
+			if (liveTriangleCounts[vertex] == 0) {
+				continue;
+			}
+
+			int priority = 0;
+			if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangleCounts[vertex] <= VERTEX_CACHE_SIZE) {
+				priority = timestamp - cacheTimestamps[vertex];
+			}
+
+			if (priority > maxPriority) {
+				maxPriority	  = priority;
+				fanningVertex = vertex;
+			}
+		}
+
+		// Dead end, continue from most recently used vertex or any vertex with triangles left
+		while (fanningVertex == UINT32_MAX && !deadEndStack.empty()) {
+			const uint32_t vertex = deadEndStack.back();
+			deadEndStack.pop_back();
+
+			if (liveTriangleCounts[vertex] > 0) {
+				fanningVertex = vertex;
+			}
+		}
+
+		while (fanningVertex == UINT32_MAX && scanCursor < vertexCount) {
+			if (liveTriangleCounts[scanCursor] > 0) {
+				fanningVertex = scanCursor;
+			}
+			scanCursor++;
+		}
+	}
+
+	for (uint i = 0; i < optimizedIndices.size(); i++) {
+		indices[firstIndex + i] = globalVertices[optimizedIndices[i]];
+	}
+}
+
+void Importer::optimizeOverdraw(StaticMesh& mesh) {
+	if (mesh.meshlets.size() < 2) {
+		return;
+	}
+
+	glm::vec3 meshCenter {};
+	float indexCountSum {};
+
+	for (const auto& meshlet : mesh.meshlets) {
+		meshCenter += meshlet.boundingSphere.center * static_cast<float>(meshlet.indexCount);
+		indexCountSum += meshlet.indexCount;
+	}
+	meshCenter /= indexCountSum;
+
+	std::vector<float> occlusionPotentials(mesh.meshlets.size());
+	std::vector<uint32_t> meshletOrder(mesh.meshlets.size());
+
+	for (uint i = 0; i < mesh.meshlets.size(); i++) {
+		const auto& meshlet = mesh.meshlets[i];
+
+		occlusionPotentials[i] = glm::dot(meshlet.boundingSphere.center - meshCenter, meshlet.coneAxis);
+		meshletOrder[i]		   = i;
+	}
+
+	std::stable_sort(meshletOrder.begin(), meshletOrder.end(), [&occlusionPotentials](uint32_t a, uint32_t b) {
+		return occlusionPotentials[a] > occlusionPotentials[b];
+	});
+
+
+	std::vector<uint32_t> indices {};
+	indices.reserve(mesh.indexBuffer.size());
+
+	std::vector<Meshlet> meshlets {};
+	meshlets.reserve(mesh.meshlets.size());
+
+	for (auto meshletIndex : meshletOrder) {
+		auto meshlet = mesh.meshlets[meshletIndex];
+
+		indices.insert(indices.end(), mesh.indexBuffer.begin() + meshlet.firstIndex,
+					   mesh.indexBuffer.begin() + meshlet.firstIndex + meshlet.indexCount);
+
+		meshlet.firstIndex = indices.size() - meshlet.indexCount;
+		meshlets.push_back(meshlet);
+	}
+
+	mesh.indexBuffer = std::move(indices);
+	mesh.meshlets	 = std::move(meshlets);
+}
+
+void Importer::optimizeVertexFetch(StaticMesh& mesh) {
+	// Vertices are stored in order of first use, unreferenced ones are dropped
+	std::vector<uint32_t> vertexRemap(mesh.vertexBuffer.size(), UINT32_MAX);
+
+	std::vector<StaticMesh::Vertex> vertices {};
+	vertices.reserve(mesh.vertexBuffer.size());
+
+	for (auto& index : mesh.indexBuffer) {
+		if (vertexRemap[index] == UINT32_MAX) {
+			vertexRemap[index] = vertices.size();
+			vertices.push_back(mesh.vertexBuffer[index]);
+		}
+
+		index = vertexRemap[index];
+	}
+
+	mesh.vertexBuffer = std::move(vertices);
+}
+
+Importer::VertexCacheStatistics Importer::analyzeVertexCache(const std::vector<uint32_t>& indices, uint vertexCount) {
+	std::vector<uint32_t> cacheTimestamps(vertexCount);
+	uint32_t timestamp = VERTEX_CACHE_SIZE + 1;
+
+	std::vector<bool> isVertexReferenced(vertexCount);
+
+	uint transformCount		   = 0;
+	uint referencedVertexCount = 0;
+
+	for (auto index : indices) {
+		if (timestamp - cacheTimestamps[index] > VERTEX_CACHE_SIZE) {
+			cacheTimestamps[index] = timestamp++;
+			transformCount++;
+		}
+
+		if (!isVertexReferenced[index]) {
+			isVertexReferenced[index] = true;
+			referencedVertexCount++;
+		}
+	}
+
+	VertexCacheStatistics statistics {};
+
+	if (!indices.empty()) {
+		statistics.averageCacheMissRatio		 = static_cast<float>(transformCount) / (indices.size() / 3);
+		statistics.averageTransformToVertexRatio = static_cast<float>(transformCount) / referencedVertexCount;
+	}
+
+	return statistics;
+}
+
+int Importer::importTexture(std::string filename, TextureManager::Handle& textureHandle, uint channels,
+							uint channelWidth, vk::Format format) {
+	Texture2D loadedTexture {};
+	if (loadTexture(filename, loadedTexture, channels, channelWidth, format)) {
+		return 1;
+	}
+
+	textureHandle.apply<Texture2D>([&](auto& texture) {
+		texture = std::move(loadedTexture);
+	});
+	textureHandle.update();
+
+	return 0;
+}
+
+int Importer::loadTexture(std::string filename, Texture2D& texture, uint channels, uint channelWidth,
+						  vk::Format format) {
+	spdlog::info("Importing texture '{}'...", filename);
+	int readWidth;
+	int readHeight;
+	int readChannels;
+
+	void* image;
+
+	switch (channelWidth) {
+	case 8:
+		image = stbi_load(filename.c_str(), &readWidth, &readHeight, &readChannels, channels);
+		break;
+
+	case 16:
+		image = stbi_load_16(filename.c_str(), &readWidth, &readHeight, &readChannels, channels);
+		break;
+
+	default:
+		spdlog::error("{} bit channel width is not supported", channelWidth);
+		return 1;
+		break;
+	}
+
+	if (image == nullptr) {
+		spdlog::error("Failed to import '{}'", filename);
+		return 1;
+	}
+
+	texture.size = vk::Extent3D(readWidth, readHeight, 1);
+
+	texture.setPixelData(image, readWidth * readHeight * channels * (channelWidth / 8));
+
+	texture.format		= format;
+	texture.usage		= vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+	texture.imageAspect = vk::ImageAspectFlagBits::eColor;
+
+	texture.useMipMapping = true;
+
+	stbi_image_free(image);
+
+	return 0;
+}
+
+
+int Importer::cookTerrain(std::string heightMapFilename, std::string terrainFilename, float texelSize,
+						  float maxHeight) {
+	spdlog::info("Cooking terrain '{}' into '{}'...", heightMapFilename, terrainFilename);
+
+	int readWidth;
+	int readHeight;
+	int readChannels;
+
+	uint16_t* pImage = stbi_load_16(heightMapFilename.c_str(), &readWidth, &readHeight, &readChannels, 1);
+	if (pImage == nullptr) {
+		spdlog::error("Failed to import '{}'", heightMapFilename);
+		return 1;
+	}
+
+	constexpr uint tileSize = TerrainTileFile::TILE_SIZE;
+
+
+	// Level 0 is source heightmap, each next level averages 2x2 texels of previous one
+
+	std::vector<std::vector<uint16_t>> levelHeights {};
+	std::vector<glm::uvec2> levelSizes {};
+
+	levelHeights.emplace_back(pImage, pImage + readWidth * readHeight);
+	levelSizes.push_back(glm::uvec2(readWidth, readHeight));
+
+	stbi_image_free(pImage);
+
+	while (std::max(levelSizes.back().x, levelSizes.back().y) > tileSize &&
+		   levelSizes.size() < TerrainTileFile::MAX_LEVEL_COUNT) {
+		const auto& srcHeights	 = levelHeights.back();
+		const glm::uvec2 srcSize = levelSizes.back();
+		const glm::uvec2 dstSize = (srcSize + 1u) / 2u;
+
+		std::vector<uint16_t> dstHeights(dstSize.x * dstSize.y);
+
+		for (uint y = 0; y < dstSize.y; y++) {
+			uint y0 = 2 * y;
+			uint y1 = std::min(2 * y + 1, srcSize.y - 1);
+
+			for (uint x = 0; x < dstSize.x; x++) {
+				uint x0 = 2 * x;
+				uint x1 = std::min(2 * x + 1, srcSize.x - 1);
+
+				uint sum = srcHeights[y0 * srcSize.x + x0] + srcHeights[y0 * srcSize.x + x1] +
+						   srcHeights[y1 * srcSize.x + x0] + srcHeights[y1 * srcSize.x + x1];
+
+				dstHeights[y * dstSize.x + x] = (sum + 2) / 4;
+			}
+		}
+
+		levelHeights.push_back(std::move(dstHeights));
+		levelSizes.push_back(dstSize);
+	}
+
+	const uint levelCount = levelSizes.size();
+
+
+	// Layout
+
+	TerrainTileFile::Header header {};
+	header.magic	  = TerrainTileFile::MAGIC;
+	header.version	  = TerrainTileFile::VERSION;
+	header.width	  = readWidth;
+	header.height	  = readHeight;
+	header.tileSize	  = tileSize;
+	header.levelCount = levelCount;
+	header.texelSize  = texelSize;
+	header.maxHeight  = maxHeight;
+
+	std::vector<TerrainTileFile::LevelHeader> levelHeaders(levelCount);
+
+	uint64_t offset = sizeof(TerrainTileFile::Header) + levelCount * sizeof(TerrainTileFile::LevelHeader);
+
+	for (uint level = 0; level < levelCount; level++) {
+		auto& levelHeader = levelHeaders[level];
+
+		levelHeader.width	   = levelSizes[level].x;
+		levelHeader.height	   = levelSizes[level].y;
+		levelHeader.tileCountX = (levelHeader.width + tileSize - 1) / tileSize;
+		levelHeader.tileCountY = (levelHeader.height + tileSize - 1) / tileSize;
+		levelHeader.offset	   = offset;
+
+		offset += levelHeader.tileCountX * levelHeader.tileCountY * TerrainTileFile::getTileSize();
+	}
+
+
+	HeightPyramid heightPyramid {};
+	if (heightPyramid.build(levelHeights[0].data(), readWidth, readHeight, std::thread::hardware_concurrency())) {
+		return 1;
+	}
+	heightPyramid.dropFinestLevels(MAX_TERRAIN_PYRAMID_SIZE);
+
+	std::vector<uint8_t> pyramidData {};
+	heightPyramid.serialize(pyramidData);
+
+	header.pyramidOffset = offset;
+	header.pyramidSize	 = pyramidData.size();
+
+
+	// Write
+
+	// Written next to cooked file first, so an interrupted cook never leaves a partial file behind
+	const std::string temporaryFilename = terrainFilename + ".tmp";
+
+	std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		spdlog::error("Failed to open '{}' for writing", temporaryFilename);
+		return 1;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(levelHeaders.data()),
+			   levelCount * sizeof(TerrainTileFile::LevelHeader));
+
+	std::vector<uint8_t> tileData(TerrainTileFile::getTileSize());
+
+	for (uint level = 0; level < levelCount; level++) {
+		const auto& heights		= levelHeights[level];
+		const auto& levelHeader = levelHeaders[level];
+
+		std::vector<uint8_t> normals(levelHeader.width * levelHeader.height * 4);
+		Generator::normalsFromHeights(heights.data(), levelHeader.width, levelHeader.height,
+									  maxHeight / (texelSize * (1u << level)), normals.data(),
+									  std::thread::hardware_concurrency());
+
+		auto* pTileHeights = reinterpret_cast<uint16_t*>(tileData.data());
+		auto* pTileNormals = reinterpret_cast<uint32_t*>(tileData.data() + TerrainTileFile::getTileHeightsSize());
+		auto* pNormals	   = reinterpret_cast<const uint32_t*>(normals.data());
+
+		for (uint tileY = 0; tileY < levelHeader.tileCountY; tileY++) {
+			for (uint tileX = 0; tileX < levelHeader.tileCountX; tileX++) {
+
+				// Edge texels are repeated past level border
+				for (uint y = 0; y < tileSize; y++) {
+					uint srcY = std::min(tileY * tileSize + y, levelHeader.height - 1);
+
+					for (uint x = 0; x < tileSize; x++) {
+						uint srcX = std::min(tileX * tileSize + x, levelHeader.width - 1);
+
+						pTileHeights[y * tileSize + x] = heights[srcY * levelHeader.width + srcX];
+						pTileNormals[y * tileSize + x] = pNormals[srcY * levelHeader.width + srcX];
+					}
+				}
+
+				file.write(reinterpret_cast<const char*>(tileData.data()), tileData.size());
+			}
+		}
+	}
+
+	file.write(reinterpret_cast<const char*>(pyramidData.data()), pyramidData.size());
+
+	return replaceCookedFile(file, temporaryFilename, terrainFilename);
+}
+
+
+bool Importer::isCookedFileUpToDate(std::string sourceFilename, std::string cookedFilename, uint32_t magic,
+									uint32_t version) {
+	std::error_code errorCode;
+
+	if (!std::filesystem::exists(cookedFilename, errorCode)) {
+		return false;
+	}
+
+	// Files of an older format or cut short before their header are cooked again
+	std::ifstream file(cookedFilename, std::ios::binary);
+
+	std::array<uint32_t, 2> fileHeader {};
+	file.read(reinterpret_cast<char*>(fileHeader.data()), sizeof(fileHeader));
+
+	if (!file.good() || fileHeader[0] != magic || fileHeader[1] != version) {
+		spdlog::warn("'{}' is stale", cookedFilename);
+		return false;
+	}
+
+	// Cooked files may be shipped without their sources
+	if (!std::filesystem::exists(sourceFilename, errorCode)) {
+		return true;
+	}
+
+	const auto sourceTime = std::filesystem::last_write_time(sourceFilename, errorCode);
+	const auto cookedTime = std::filesystem::last_write_time(cookedFilename, errorCode);
+
+	return !errorCode && cookedTime >= sourceTime;
+}
+
+int Importer::replaceCookedFile(std::ofstream& file, std::string temporaryFilename, std::string filename) {
+	file.close();
+
+	std::error_code errorCode;
+
+	if (file.fail()) {
+		spdlog::error("Failed to write '{}'", temporaryFilename);
+		std::filesystem::remove(temporaryFilename, errorCode);
+		return 1;
+	}
+
+	std::filesystem::rename(temporaryFilename, filename, errorCode);
+	if (errorCode) {
+		spdlog::error("Failed to move '{}' to '{}': {}", temporaryFilename, filename, errorCode.message());
+		std::filesystem::remove(temporaryFilename, errorCode);
+		return 1;
+	}
+
+	return 0;
+}
+
+
+int Importer::cookMeshes(const std::vector<MeshManager::Handle>& meshHandles, const std::vector<std::string>& meshNames,
+						 std::string filename) {
+	static_assert(std::is_trivially_copyable_v<Meshlet>);
+
+	assert(meshHandles.size() == meshNames.size());
+
+	spdlog::info("Cooking {} mesh(es) into '{}'...", meshHandles.size(), filename);
+
+	const uint meshCount = meshHandles.size();
+
+	std::vector<MeshManager::MeshData> meshDatas(meshCount);
+	std::vector<std::vector<std::vector<uint8_t>>> vertexStreamArrays(meshCount);
+	std::vector<std::vector<uint16_t>> shortIndexBuffers(meshCount);
+
+	std::vector<CookedMeshFile::MeshHeader> meshHeaders(meshCount);
+
+	uint64_t offset = sizeof(CookedMeshFile::Header) + meshCount * sizeof(CookedMeshFile::MeshHeader);
+
+	for (uint meshIndex = 0; meshIndex < meshCount; meshIndex++) {
+		const auto& meshHandle = meshHandles[meshIndex];
+
+		auto& meshData	 = meshDatas[meshIndex];
+		auto& meshHeader = meshHeaders[meshIndex];
+
+		MeshManager::getMeshData(meshHandle, meshData, vertexStreamArrays[meshIndex], shortIndexBuffers[meshIndex]);
+
+		const uint32_t typeIndex = MeshManager::getTypeIndex(meshHandle);
+
+		if (meshNames[meshIndex].size() >= CookedMeshFile::MAX_NAME_LENGTH) {
+			spdlog::error("Failed to cook mesh '{}': name is too long", meshNames[meshIndex]);
+			return 1;
+		}
+		strncpy(meshHeader.name, meshNames[meshIndex].c_str(), CookedMeshFile::MAX_NAME_LENGTH);
+
+		meshHeader.typeIndex		 = typeIndex;
+		meshHeader.vertexCount		 = meshData.vertexCount;
+		meshHeader.vertexStreamCount = MeshManager::getVertexStreamCount(typeIndex);
+		meshHeader.indexCount		 = meshData.indexCount;
+		meshHeader.indexSize		 = meshData.indexType == vk::IndexType::eUint16 ? 2 : 4;
+		meshHeader.meshletCount		 = meshData.meshletCount;
+
+		for (uint i = 0; i < 8; i++) {
+			for (uint j = 0; j < 3; j++) {
+				meshHeader.boundingBox[i][j] = meshData.boundingBox.points[i][j];
+			}
+		}
+		for (uint j = 0; j < 3; j++) {
+			meshHeader.boundingSphere[j] = meshData.boundingSphere.center[j];
+		}
+		meshHeader.boundingSphere[3] = meshData.boundingSphere.radius;
+
+		for (uint j = 0; j < 4; j++) {
+			meshHeader.positionDequantization[j] = meshData.positionDequantization[j];
+		}
+
+		offset					 = CookedMeshFile::alignOffset(offset);
+		meshHeader.meshletOffset = offset;
+		offset += meshHeader.meshletCount * sizeof(Meshlet);
+
+		for (uint streamIndex = 0; streamIndex < meshHeader.vertexStreamCount; streamIndex++) {
+			offset										= CookedMeshFile::alignOffset(offset);
+			meshHeader.vertexStreamOffsets[streamIndex] = offset;
+			offset += uint64_t(meshHeader.vertexCount) * MeshManager::getVertexStreamStride(typeIndex, streamIndex);
+		}
+
+		offset				   = CookedMeshFile::alignOffset(offset);
+		meshHeader.indexOffset = offset;
+		offset += uint64_t(meshHeader.indexCount) * meshHeader.indexSize;
+	}
+
+
+	// Write
+
+	const std::string temporaryFilename = filename + ".tmp";
+
+	std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		spdlog::error("Failed to open '{}' for writing", temporaryFilename);
+		return 1;
+	}
+
+	CookedMeshFile::Header header {};
+	header.magic	 = CookedMeshFile::MAGIC;
+	header.version	 = CookedMeshFile::VERSION;
+	header.meshCount = meshCount;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(meshHeaders.data()), meshCount * sizeof(CookedMeshFile::MeshHeader));
+
+	const auto writeBlock = [&file](uint64_t offset, const void* pData, uint64_t size) {
+		const std::array<char, CookedMeshFile::DATA_ALIGNMENT> padding {};
+		file.write(padding.data(), offset - static_cast<uint64_t>(file.tellp()));
+
+		file.write(static_cast<const char*>(pData), size);
+	};
+
+	for (uint meshIndex = 0; meshIndex < meshCount; meshIndex++) {
+		const auto& meshData   = meshDatas[meshIndex];
+		const auto& meshHeader = meshHeaders[meshIndex];
+
+		writeBlock(meshHeader.meshletOffset, meshData.pMeshlets, meshHeader.meshletCount * sizeof(Meshlet));
+
+		for (uint streamIndex = 0; streamIndex < meshHeader.vertexStreamCount; streamIndex++) {
+			writeBlock(meshHeader.vertexStreamOffsets[streamIndex], meshData.pVertexStreams[streamIndex],
+					   vertexStreamArrays[meshIndex][streamIndex].size());
+		}
+
+		writeBlock(meshHeader.indexOffset, meshData.pIndices, uint64_t(meshHeader.indexCount) * meshHeader.indexSize);
+	}
+
+	return replaceCookedFile(file, temporaryFilename, filename);
+}
+
+int Importer::loadCookedMeshes(std::string filename, std::vector<MeshManager::Handle>& meshHandles) {
+	spdlog::info("Loading cooked mesh(es) '{}'...", filename);
+
+	MappedFile file {};
+	if (file.open(filename)) {
+		return 1;
+	}
+
+	const uint8_t* pData = file.getData();
+	const uint64_t size	 = file.getSize();
+
+	CookedMeshFile::Header header {};
+	if (size >= sizeof(header)) {
+		memcpy(&header, pData, sizeof(header));
+	}
+
+	if (header.magic != CookedMeshFile::MAGIC || header.version != CookedMeshFile::VERSION) {
+		spdlog::error("'{}' is not a supported cooked mesh file", filename);
+		return 1;
+	}
+
+	const uint64_t meshHeadersOffset = sizeof(CookedMeshFile::Header);
+
+	if (meshHeadersOffset + header.meshCount * sizeof(CookedMeshFile::MeshHeader) > size) {
+		spdlog::error("'{}' is truncated", filename);
+		return 1;
+	}
+
+	// Every mesh is validated before any of them is created, so a broken file does not leave meshes behind
+	std::vector<CookedMeshFile::MeshHeader> meshHeaders(header.meshCount);
+
+	for (uint meshIndex = 0; meshIndex < header.meshCount; meshIndex++) {
+		auto& meshHeader = meshHeaders[meshIndex];
+		memcpy(&meshHeader, &pData[meshHeadersOffset + meshIndex * sizeof(CookedMeshFile::MeshHeader)],
+			   sizeof(meshHeader));
+
+		meshHeader.name[CookedMeshFile::MAX_NAME_LENGTH - 1] = '\0';
+
+		if (meshHeader.typeIndex >= MeshManager::getTypeCount() ||
+			meshHeader.vertexStreamCount != MeshManager::getVertexStreamCount(meshHeader.typeIndex) ||
+			(meshHeader.indexSize != 2 && meshHeader.indexSize != 4)) {
+			spdlog::error("Mesh '{}' of '{}' does not match mesh types of engine", meshHeader.name, filename);
+			return 1;
+		}
+
+		// Every block is checked to be within file before any data is read from it
+		bool isTruncated = meshHeader.meshletOffset + meshHeader.meshletCount * sizeof(Meshlet) > size ||
+						   meshHeader.indexOffset + uint64_t(meshHeader.indexCount) * meshHeader.indexSize > size;
+
+		for (uint streamIndex = 0; streamIndex < meshHeader.vertexStreamCount; streamIndex++) {
+			const uint64_t streamSize = uint64_t(meshHeader.vertexCount) *
+										MeshManager::getVertexStreamStride(meshHeader.typeIndex, streamIndex);
+			isTruncated |= meshHeader.vertexStreamOffsets[streamIndex] + streamSize > size;
+		}
+
+		if (isTruncated) {
+			spdlog::error("Mesh '{}' of '{}' is truncated", meshHeader.name, filename);
+			return 1;
+		}
+	}
+
+	meshHandles.resize(header.meshCount);
+
+	for (uint meshIndex = 0; meshIndex < header.meshCount; meshIndex++) {
+		const auto& meshHeader = meshHeaders[meshIndex];
+
+		// Vertex and index data is copied from mapping into staging memory by the upload itself
+		MeshManager::MeshData meshData {};
+
+		for (uint i = 0; i < 8; i++) {
+			meshData.boundingBox.points[i] =
+				glm::vec3(meshHeader.boundingBox[i][0], meshHeader.boundingBox[i][1], meshHeader.boundingBox[i][2]);
+		}
+		meshData.boundingSphere.center =
+			glm::vec3(meshHeader.boundingSphere[0], meshHeader.boundingSphere[1], meshHeader.boundingSphere[2]);
+		meshData.boundingSphere.radius = meshHeader.boundingSphere[3];
+
+		meshData.positionDequantization =
+			glm::vec4(meshHeader.positionDequantization[0], meshHeader.positionDequantization[1],
+					  meshHeader.positionDequantization[2], meshHeader.positionDequantization[3]);
+
+		meshData.pMeshlets	  = reinterpret_cast<const Meshlet*>(&pData[meshHeader.meshletOffset]);
+		meshData.meshletCount = meshHeader.meshletCount;
+
+		meshData.vertexCount = meshHeader.vertexCount;
+		for (uint streamIndex = 0; streamIndex < meshHeader.vertexStreamCount; streamIndex++) {
+			meshData.pVertexStreams[streamIndex] = &pData[meshHeader.vertexStreamOffsets[streamIndex]];
+		}
+
+		meshData.indexCount = meshHeader.indexCount;
+		meshData.indexType	= meshHeader.indexSize == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+		meshData.pIndices	= &pData[meshHeader.indexOffset];
+
+		auto& meshHandle = meshHandles[meshIndex];
+		meshHandle		 = MeshManager::createObject(meshHeader.typeIndex, meshHeader.name);
+
+		MeshManager::update(meshHandle, meshData);
+	}
+
+	return 0;
+}
+
+
+int Importer::loadTextureMipLevels(std::string filename, vk::Format format,
+								   std::vector<std::vector<uint8_t>>& levelPixels,
+								   std::vector<vk::Extent2D>& levelExtents) {
+	const bool isSrgb = format == vk::Format::eR8G8B8A8Srgb;
+	if (!isSrgb && format != vk::Format::eR8G8B8A8Unorm) {
+		spdlog::error("Failed to load '{}': format {} is not supported", filename, vk::to_string(format));
+		return 1;
+	}
+
+	constexpr uint texelSize = 4;
+
+	int readWidth;
+	int readHeight;
+	int readChannels;
+
+	uint8_t* pImage = stbi_load(filename.c_str(), &readWidth, &readHeight, &readChannels, texelSize);
+	if (pImage == nullptr) {
+		spdlog::error("Failed to import '{}'", filename);
+		return 1;
+	}
+
+	// Same mip chain as the one TextureManager generates for textures with mip mapping
+	const uint mipLevelCount = static_cast<uint>(std::floor(std::log2(std::max(readWidth, readHeight)))) + 1;
+
+	levelPixels.resize(mipLevelCount);
+	levelPixels[0].assign(pImage, pImage + uint64_t(readWidth) * readHeight * texelSize);
+
+	stbi_image_free(pImage);
+
+
+	// Each level averages 2x2 texels of previous one. Color of sRGB textures is averaged in linear space, as blits
+	// used for mip generation at runtime do.
+	std::array<float, 256> srgbToLinear {};
+	for (uint i = 0; i < 256; i++) {
+		const float value = i / 255.0f;
+		srgbToLinear[i]	  = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	const auto linearToSrgb = [](float value) {
+		value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+	};
+
+	levelExtents.resize(mipLevelCount);
+	levelExtents[0] = vk::Extent2D(readWidth, readHeight);
+
+	for (uint level = 1; level < mipLevelCount; level++) {
+		const auto& srcExtent = levelExtents[level - 1];
+		const auto& srcPixels = levelPixels[level - 1];
+
+		auto& dstExtent	 = levelExtents[level];
+		dstExtent.width	 = std::max(srcExtent.width / 2, 1u);
+		dstExtent.height = std::max(srcExtent.height / 2, 1u);
+
+		auto& dstPixels = levelPixels[level];
+		dstPixels.resize(uint64_t(dstExtent.width) * dstExtent.height * texelSize);
+
+		for (uint y = 0; y < dstExtent.height; y++) {
+			const uint srcY0 = std::min(y * 2, srcExtent.height - 1);
+			const uint srcY1 = std::min(y * 2 + 1, srcExtent.height - 1);
+
+			for (uint x = 0; x < dstExtent.width; x++) {
+				const uint srcX0 = std::min(x * 2, srcExtent.width - 1);
+				const uint srcX1 = std::min(x * 2 + 1, srcExtent.width - 1);
+
+				const std::array srcOffsets = {
+					(srcY0 * srcExtent.width + srcX0) * texelSize,
+					(srcY0 * srcExtent.width + srcX1) * texelSize,
+					(srcY1 * srcExtent.width + srcX0) * texelSize,
+					(srcY1 * srcExtent.width + srcX1) * texelSize,
+				};
+
+				const uint dstOffset = (y * dstExtent.width + x) * texelSize;
+
+				for (uint channel = 0; channel < texelSize; channel++) {
+					// Alpha is always linear
+					if (isSrgb && channel < 3) {
+						float sum = 0.0f;
+						for (auto srcOffset : srcOffsets) {
+							sum += srgbToLinear[srcPixels[srcOffset + channel]];
+						}
+						dstPixels[dstOffset + channel] = linearToSrgb(sum * 0.25f);
+					} else {
+						uint sum = 0;
+						for (auto srcOffset : srcOffsets) {
+							sum += srcPixels[srcOffset + channel];
+						}
+						dstPixels[dstOffset + channel] = (sum + 2) / 4;
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+int Importer::cookTexture(std::string filename, std::string cookedFilename, vk::Format format) {
+	spdlog::info("Cooking texture '{}' into '{}'...", filename, cookedFilename);
+
+	std::vector<std::vector<uint8_t>> levelPixels {};
+	std::vector<vk::Extent2D> levelExtents {};
+	if (loadTextureMipLevels(filename, format, levelPixels, levelExtents)) {
+		return 1;
+	}
+
+	return writeCookedTexture(cookedFilename, format, levelPixels, levelExtents);
+}
+
+int Importer::writeCookedTexture(std::string cookedFilename, vk::Format format,
+								 const std::vector<std::vector<uint8_t>>& levelPixels,
+								 const std::vector<vk::Extent2D>& levelExtents) {
+	const uint mipLevelCount = levelPixels.size();
+
+	if (mipLevelCount > CookedTextureFile::MAX_MIP_LEVEL_COUNT) {
+		spdlog::error("Failed to cook '{}': texture is too large", cookedFilename);
+		return 1;
+	}
+
+	std::vector<CookedTextureFile::MipLevelHeader> levelHeaders(mipLevelCount);
+
+	uint64_t offset = sizeof(CookedTextureFile::Header) + mipLevelCount * sizeof(CookedTextureFile::MipLevelHeader);
+
+	for (uint level = 0; level < mipLevelCount; level++) {
+		offset = CookedTextureFile::alignOffset(offset);
+
+		levelHeaders[level].width  = levelExtents[level].width;
+		levelHeaders[level].height = levelExtents[level].height;
+		levelHeaders[level].offset = offset;
+		levelHeaders[level].size   = levelPixels[level].size();
+
+		offset += levelPixels[level].size();
+	}
+
+
+	// Write
+
+	const std::string temporaryFilename = cookedFilename + ".tmp";
+
+	std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		spdlog::error("Failed to open '{}' for writing", temporaryFilename);
+		return 1;
+	}
+
+	CookedTextureFile::Header header {};
+	header.magic		 = CookedTextureFile::MAGIC;
+	header.version		 = CookedTextureFile::VERSION;
+	header.width		 = levelExtents[0].width;
+	header.height		 = levelExtents[0].height;
+	header.format		 = static_cast<uint32_t>(format);
+	header.mipLevelCount = mipLevelCount;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(levelHeaders.data()),
+			   mipLevelCount * sizeof(CookedTextureFile::MipLevelHeader));
+
+	const std::array<char, CookedTextureFile::DATA_ALIGNMENT> padding {};
+
+	for (uint level = 0; level < mipLevelCount; level++) {
+		file.write(padding.data(), levelHeaders[level].offset - static_cast<uint64_t>(file.tellp()));
+		file.write(reinterpret_cast<const char*>(levelPixels[level].data()), levelPixels[level].size());
+	}
+
+	return replaceCookedFile(file, temporaryFilename, cookedFilename);
+}
+
+int Importer::loadCookedTexture(std::string filename, TextureManager::Handle& textureHandle) {
+	spdlog::info("Loading cooked texture '{}'...", filename);
+
+	MappedFile file {};
+	if (file.open(filename)) {
+		return 1;
+	}
+
+	// Pixels are copied from mapping into staging memory by region update
+	vk::Format format {};
+	std::vector<TextureManager::TextureRegion> regions {};
+	if (parseCookedTexture(filename, file.getData(), file.getSize(), format, regions)) {
+		return 1;
+	}
+
+	// Texture is created without pixel data, its mip levels are written afterwards
+	textureHandle.apply<Texture2D>([&](auto& texture) {
+		texture.size = vk::Extent3D(regions[0].extent.width, regions[0].extent.height, 1);
+
+		texture.format		= format;
+		texture.usage		= vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+		texture.imageAspect = vk::ImageAspectFlagBits::eColor;
+
+		texture.useMipMapping = true;
+
+		texture.releasePixelData();
+	});
+	textureHandle.update();
+
+	return TextureManager::updateRegions(textureHandle, regions, true);
+}
+
+int Importer::loadCookedTextureMipLevels(std::string filename, vk::Format format,
+										 std::vector<std::vector<uint8_t>>& levelPixels,
+										 std::vector<vk::Extent2D>& levelExtents) {
+	MappedFile file {};
+	if (file.open(filename)) {
+		return 1;
+	}
+
+	vk::Format cookedFormat {};
+	std::vector<TextureManager::TextureRegion> regions {};
+	if (parseCookedTexture(filename, file.getData(), file.getSize(), cookedFormat, regions)) {
+		return 1;
+	}
+
+	if (cookedFormat != format) {
+		spdlog::error("'{}' is cooked with format {} instead of {}", filename, vk::to_string(cookedFormat),
+					  vk::to_string(format));
+		return 1;
+	}
+
+	levelPixels.resize(regions.size());
+	levelExtents.resize(regions.size());
+
+	for (uint level = 0; level < regions.size(); level++) {
+		const auto* pPixels = static_cast<const uint8_t*>(regions[level].pData);
+
+		levelPixels[level].assign(pPixels, pPixels + regions[level].size);
+		levelExtents[level] = regions[level].extent;
+	}
+
+	return 0;
+}
+
+int Importer::parseCookedTexture(std::string filename, const uint8_t* pData, uint64_t size, vk::Format& format,
+								 std::vector<TextureManager::TextureRegion>& regions) {
+	CookedTextureFile::Header header {};
+	if (size >= sizeof(header)) {
+		memcpy(&header, pData, sizeof(header));
+	}
+
+	if (header.magic != CookedTextureFile::MAGIC || header.version != CookedTextureFile::VERSION ||
+		header.width == 0 || header.height == 0) {
+		spdlog::error("'{}' is not a supported cooked texture file", filename);
+		return 1;
+	}
+
+	const uint expectedMipLevelCount =
+		static_cast<uint>(std::floor(std::log2(std::max(header.width, header.height)))) + 1;
+
+	if (header.mipLevelCount != expectedMipLevelCount) {
+		spdlog::error("'{}' does not contain full mip chain", filename);
+		return 1;
+	}
+
+	const uint64_t levelHeadersOffset = sizeof(CookedTextureFile::Header);
+
+	if (levelHeadersOffset + header.mipLevelCount * sizeof(CookedTextureFile::MipLevelHeader) > size) {
+		spdlog::error("'{}' is truncated", filename);
+		return 1;
+	}
+
+	regions.resize(header.mipLevelCount);
+
+	for (uint level = 0; level < header.mipLevelCount; level++) {
+		CookedTextureFile::MipLevelHeader levelHeader {};
+		memcpy(&levelHeader, &pData[levelHeadersOffset + level * sizeof(CookedTextureFile::MipLevelHeader)],
+			   sizeof(levelHeader));
+
+		if (levelHeader.size != uint64_t(levelHeader.width) * levelHeader.height * CookedTextureFile::TEXEL_SIZE ||
+			levelHeader.offset + levelHeader.size > size) {
+			spdlog::error("Mip level {} of '{}' is truncated", level, filename);
+			return 1;
+		}
+
+		auto& region	= regions[level];
+		region.mipLevel = level;
+		region.extent	= vk::Extent2D(levelHeader.width, levelHeader.height);
+		region.pData	= &pData[levelHeader.offset];
+		region.size		= levelHeader.size;
+	}
+
+	format = vk::Format(header.format);
 
 	return 0;
 }
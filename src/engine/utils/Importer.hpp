@@ -3,8 +3,7 @@
 #include "engine/managers/MeshManager.hpp"
 #include "engine/managers/TextureManager.hpp"
 
-#include <assimp/Importer.hpp>
-
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -12,12 +11,127 @@
 namespace Engine {
 class Importer {
 private:
-	static Assimp::Importer assimpImporter;
+	static constexpr uint MAX_MESHLET_VERTEX_COUNT	 = 64;
+	static constexpr uint MAX_MESHLET_TRIANGLE_COUNT = 124;
+
+	// FIFO post-transform cache size triangle order is optimized for and statistics are measured with
+	static constexpr uint VERTEX_CACHE_SIZE = 16;
+
+	// Height pyramid levels wider than that are dropped from cooked terrains to bound their memory at runtime
+	static constexpr uint MAX_TERRAIN_PYRAMID_SIZE = 1024;
+
+	struct VertexCacheStatistics {
+		// Transformed vertices per triangle, 0.5 is the lower bound for large regular meshes
+		float averageCacheMissRatio;
+
+		// Transformed vertices per referenced vertex, 1.0 is optimal
+		float averageTransformToVertexRatio;
+	};
 
 public:
 	[[nodiscard]] static int importMesh(std::string filename, std::vector<MeshManager::Handle>& meshHandles);
 
+	// Reads and optimizes meshes without creating resources, so it may be called from any thread
+	[[nodiscard]] static int loadMesh(std::string filename, std::vector<StaticMesh>& meshes,
+									  std::vector<std::string>& meshNames);
+
+	// Creates mesh resources from loaded meshes, mesh data is moved out of them. Meshes used only as a source for other
+	// ones may be left not uploaded.
+	static void createMeshes(std::vector<StaticMesh>& meshes, const std::vector<std::string>& meshNames,
+							 std::vector<MeshManager::Handle>& meshHandles, bool upload = true);
+
+	// Fills lodHandles with source mesh followed by progressively simplified copies of it, each level keeping given
+	// ratio of triangles of the previous one. Fewer levels are returned if mesh can not be simplified any further.
+	// Simplified levels are not uploaded unless requested.
+	[[nodiscard]] static int generateMeshLods(const MeshManager::Handle& meshHandle, std::string name, uint lodCount,
+											  std::vector<MeshManager::Handle>& lodHandles, bool upload,
+											  float triangleRatio = 0.25f);
+
+	// Creates a copy of static mesh with quantized positions, half float texture coordinates and octahedral encoded
+	// tangent frame
+	[[nodiscard]] static int compressMesh(const MeshManager::Handle& meshHandle, std::string name,
+										  MeshManager::Handle& compressedMeshHandle);
+
 	[[nodiscard]] static int importTexture(std::string filename, TextureManager::Handle& textureHandle, uint channels,
 										   uint channelWidth, vk::Format format);
+
+	// Decodes image into texture without uploading it, so it may be called from any thread
+	[[nodiscard]] static int loadTexture(std::string filename, Texture2D& texture, uint channels, uint channelWidth,
+										 vk::Format format);
+
+	// Decodes RGBA8 image and averages its full mip chain on CPU, so it may be called from any thread
+	[[nodiscard]] static int loadTextureMipLevels(std::string filename, vk::Format format,
+												  std::vector<std::vector<uint8_t>>& levelPixels,
+												  std::vector<vk::Extent2D>& levelExtents);
+
+	// Converts 16 bit heightmap into tiled terrain file streamed by TerrainStreamingManager. Heights and normals are
+	// stored for every mip level down to a single tile, followed by min/max height pyramid. Texel size is world size
+	// of a heightmap texel, max height is world height of max value.
+	[[nodiscard]] static int cookTerrain(std::string heightMapFilename, std::string terrainFilename, float texelSize,
+										 float maxHeight);
+
+	// Tells whether cooked file exists, starts with given magic and version and is not older than its source. Missing
+	// source counts as up to date.
+	static bool isCookedFileUpToDate(std::string sourceFilename, std::string cookedFilename, uint32_t magic,
+									 uint32_t version);
+
+	// Writes meshes in GPU layout into cooked mesh file, loaded back by loadCookedMeshes
+	[[nodiscard]] static int cookMeshes(const std::vector<MeshManager::Handle>& meshHandles,
+										const std::vector<std::string>& meshNames, std::string filename);
+
+	// Creates meshes from mapped cooked mesh file, data is uploaded directly from the mapping
+	[[nodiscard]] static int loadCookedMeshes(std::string filename, std::vector<MeshManager::Handle>& meshHandles);
+
+	// Decodes RGBA8 image and writes it with its full mip chain into cooked texture file. May be called from any
+	// thread.
+	[[nodiscard]] static int cookTexture(std::string filename, std::string cookedFilename, vk::Format format);
+
+	// Writes mip chain loaded by loadTextureMipLevels into cooked texture file. May be called from any thread.
+	[[nodiscard]] static int writeCookedTexture(std::string cookedFilename, vk::Format format,
+												const std::vector<std::vector<uint8_t>>& levelPixels,
+												const std::vector<vk::Extent2D>& levelExtents);
+
+	// Creates texture from mapped cooked texture file, each mip level is uploaded directly from the mapping
+	[[nodiscard]] static int loadCookedTexture(std::string filename, TextureManager::Handle& textureHandle);
+
+	// Reads mip chain of cooked texture file cooked with given format without creating resources, so it may be called
+	// from any thread
+	[[nodiscard]] static int loadCookedTextureMipLevels(std::string filename, vk::Format format,
+														std::vector<std::vector<uint8_t>>& levelPixels,
+														std::vector<vk::Extent2D>& levelExtents);
+
+private:
+	// Closes cooked file written under temporary name and moves it into place, temporary file is removed on failure
+	[[nodiscard]] static int replaceCookedFile(std::ofstream& file, std::string temporaryFilename,
+											   std::string filename);
+
+	// Validates cooked texture file contents and fills one region per mip level pointing into them
+	[[nodiscard]] static int parseCookedTexture(std::string filename, const uint8_t* pData, uint64_t size,
+												vk::Format& format,
+												std::vector<TextureManager::TextureRegion>& regions);
+
+	// Quadric error metric edge collapse, vertices are collapsed onto their neighbours so attributes are preserved.
+	// Vertices on UV seams, hard edges and borders only slide along them.
+	static void simplifyMesh(const StaticMesh& srcMesh, StaticMesh& dstMesh, uint targetIndexCount);
+
+	// Reorders index buffer into meshlets of adjacent triangles and computes their bounds and normal cones
+	static void buildMeshlets(StaticMesh& mesh);
+
+	// Reorders triangles for vertex cache and overdraw, then vertices in order of first use. Statistics of mesh before
+	// meshlets were built are reported along with the optimized ones.
+	static void optimizeMesh(StaticMesh& mesh, const std::string& name, const VertexCacheStatistics& statisticsBefore);
+
+	// Tipsify triangle reordering of given index range, ranges are optimized independently to preserve meshlets
+	static void optimizeVertexCache(std::vector<uint32_t>& indices, uint firstIndex, uint indexCount);
+
+	// Orders meshlets so the ones facing away from mesh center, likely occluders, are drawn first
+	static void optimizeOverdraw(StaticMesh& mesh);
+
+	static void optimizeVertexFetch(StaticMesh& mesh);
+
+	static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, uint vertexCount);
+
+	// Maps unit vector onto octahedron unfolded into [-1, 1] square, stored as snorm
+	static glm::i16vec2 encodeOctahedral(glm::vec3 direction);
 };
 } // namespace Engine
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "MappedFile.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace Engine {
+int MappedFile::open(std::string filename) {
+	close();
+
+	fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) {
+		spdlog::error("[MappedFile] Failed to open '{}'", filename);
+		return 1;
+	}
+
+	struct stat fileStat {};
+	if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+		spdlog::error("[MappedFile] Failed to get size of '{}'", filename);
+		close();
+		return 1;
+	}
+
+	void* pMapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (pMapping == MAP_FAILED) {
+		spdlog::error("[MappedFile] Failed to map '{}'", filename);
+		close();
+		return 1;
+	}
+
+	pData = static_cast<const uint8_t*>(pMapping);
+	size  = fileStat.st_size;
+
+	return 0;
+}
+
+void MappedFile::close() {
+	if (pData != nullptr) {
+		munmap(const_cast<uint8_t*>(pData), size);
+	}
+
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+	}
+
+	pData		   = nullptr;
+	size		   = 0;
+	fileDescriptor = -1;
+}
+} // namespace Engine
\ No newline at end of file
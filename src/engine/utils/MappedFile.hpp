@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+namespace Engine {
+// Read only memory mapping of a whole file. Pages are loaded by the OS on first access, so reading from mapped data
+// may block on disk IO.
+class MappedFile {
+private:
+	const uint8_t* pData {};
+	uint64_t size {};
+
+	int fileDescriptor = -1;
+
+
+public:
+	MappedFile() = default;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+		close();
+	}
+
+
+	int open(std::string filename);
+	void close();
+
+
+	inline const uint8_t* getData() const {
+		return pData;
+	}
+
+	inline uint64_t getSize() const {
+		return size;
+	}
+
+	inline bool isOpen() const {
+		return pData != nullptr;
+	}
+};
+} // namespace Engine
\ No newline at end of file
@@ -15,9 +15,14 @@ void ThreadPool::terminate() {
 	cvReady.notify_all();
 	lock.unlock();
 
+	// Pool may be terminated explicitly before destruction
 	for (auto& thread : threads) {
-		thread.join();
+		if (thread.joinable()) {
+			thread.join();
+		}
 	}
+
+	threads.clear();
 }
 
 